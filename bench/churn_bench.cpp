@@ -0,0 +1,497 @@
+// Change-to-visible latency under filesystem churn.
+//
+//   boox_churn [--zones N] [--files N] [--duration SECONDS]
+//              [--create-rate R] [--delete-rate R] [--rename-rate R]
+//              [--burst N] [--seed N] [--json FILE] [--trace FILE]
+//
+// Builds a temporary boox root with --zones folders of --files files each and
+// runs the app on it (offscreen). Files are then created, deleted and renamed
+// inside the zone folders at the given rates (operations per second, across
+// all zones); with --burst N operations are issued N at a time. For every
+// operation the harness timestamps when the zone's model reflects it (for a
+// rename: the new name is shown and the old one is gone) and reports p50 /
+// p99 / max latency per operation type, plus the thread CPU time and wall
+// time spent in the watcher/refresh path of the zones and the process CPU
+// time.
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRandomGenerator>
+#include <QSaveFile>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QTimer>
+#include <algorithm>
+#include "mainwindow.h"
+#include "floatingzone.h"
+#include "features/dirscan/dirscan.h"
+#include "features/filemodel/filemodel.h"
+#include "features/theme/theme.h"
+#include "features/trace/tracer.h"
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#elif defined(Q_OS_UNIX)
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+enum OpKind { Create, Delete, Rename, OpKindCount };
+const char *const OP_NAMES[OpKindCount] = { "create", "delete", "rename" };
+
+// Spans of the zone refresh path reported after the run
+const char *const REPORTED_SPANS[] = {
+    "FloatingZone::onFolderEvents",
+    "FloatingZone::flushPendingChanges",
+    "FloatingZone::refreshFileList",
+    "ZoneFileModel::applyDelta",
+    "ZoneFileModel::setEntries",
+    "DirScanner::stat",
+    "DirScanner::scan",
+};
+
+struct ChurnConfig
+{
+    int zones = 4;
+    int files = 1000;
+    int durationMs = 10000;
+    double rates[OpKindCount] = { 50.0, 20.0, 10.0 };
+    int burst = 1;
+    quint32 seed = 1;
+    QString jsonPath;
+    QString tracePath;
+};
+
+// Process CPU time (user + system), in milliseconds
+double processCpuMs()
+{
+#if defined(Q_OS_WIN)
+    FILETIME created, exited, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel, &user)) {
+        return 0;
+    }
+    auto toMs = [](const FILETIME &t) {
+        return ((quint64(t.dwHighDateTime) << 32) | t.dwLowDateTime) / 10000.0;
+    };
+    return toMs(kernel) + toMs(user);
+#elif defined(Q_OS_UNIX)
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+    auto toMs = [](const timeval &t) { return t.tv_sec * 1000.0 + t.tv_usec / 1000.0; };
+    return toMs(usage.ru_utime) + toMs(usage.ru_stime);
+#else
+    return 0;
+#endif
+}
+
+double percentile(QVector<double> sorted, double p)
+{
+    if (sorted.isEmpty()) {
+        return 0;
+    }
+    const int index = qBound(0, int(p * (sorted.size() - 1) + 0.5), sorted.size() - 1);
+    return sorted.at(index);
+}
+
+} // namespace
+
+class ChurnHarness : public QObject
+{
+    Q_OBJECT
+
+public:
+    ChurnHarness(const ChurnConfig &config, const QString &rootPath);
+
+    // Create the zone folders and their initial files
+    bool prepare();
+    // Wait for the app's zones on our folders to finish loading
+    bool attachZones(int timeoutMs);
+    // Churn for the configured duration, then wait for stragglers
+    void run();
+    void report();
+
+private:
+    struct Pending
+    {
+        OpKind kind;
+        QString path;
+        QString oldPath;    // renames: the name that must disappear
+        bool shouldExist;
+        qint64 issuedNs;
+    };
+
+    struct Zone
+    {
+        QString folder;
+        FloatingZone *widget = nullptr;
+        QStringList knownFiles;       // files whose creation the zone has shown
+        QList<Pending> pending;
+    };
+
+    void tick();
+    void issue(OpKind kind);
+    void check(int zoneIndex);
+    QString newFileName();
+    int pendingCount() const;
+
+    ChurnConfig config;
+    QString rootPath;
+    QVector<Zone> zones;
+    QRandomGenerator random;
+    QElapsedTimer clock;
+    QTimer ticker;
+
+    int nameCounter = 0;
+    int issued[OpKindCount] = {};
+    int missed[OpKindCount] = {};
+    QVector<double> latenciesMs[OpKindCount];
+    double cpuMs = 0;
+    qint64 churnNs = 0;
+};
+
+ChurnHarness::ChurnHarness(const ChurnConfig &config, const QString &rootPath)
+    : config(config), rootPath(rootPath), random(config.seed)
+{
+    ticker.setTimerType(Qt::PreciseTimer);
+    ticker.setInterval(5);
+    connect(&ticker, &QTimer::timeout, this, &ChurnHarness::tick);
+}
+
+bool ChurnHarness::prepare()
+{
+    const QDir root(rootPath);
+    for (int z = 0; z < config.zones; ++z) {
+        Zone zone;
+        zone.folder = root.absoluteFilePath(QStringLiteral("zone %1").arg(z + 1));
+        if (!QDir().mkpath(zone.folder)) {
+            return false;
+        }
+
+        const QDir dir(zone.folder);
+        for (int i = 0; i < config.files; ++i) {
+            const QString path = dir.filePath(QStringLiteral("seed %1.txt").arg(i, 6, 10, QLatin1Char('0')));
+            QFile file(path);
+            if (!file.open(QIODevice::WriteOnly)) {
+                return false;
+            }
+            zone.knownFiles.append(path);
+        }
+        zones.append(zone);
+    }
+    return true;
+}
+
+bool ChurnHarness::attachZones(int timeoutMs)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QTimer heartbeat;
+    heartbeat.start(10);
+
+    while (timer.elapsed() < timeoutMs) {
+        int ready = 0;
+        for (QWidget *widget : QApplication::topLevelWidgets()) {
+            FloatingZone *floating = qobject_cast<FloatingZone *>(widget);
+            if (!floating) {
+                continue;
+            }
+            for (int z = 0; z < zones.size(); ++z) {
+                if (zones[z].folder == QDir(floating->getFolderPath()).absolutePath()) {
+                    zones[z].widget = floating;
+                }
+            }
+        }
+        for (const Zone &zone : zones) {
+            if (zone.widget && !DirScanner::instance()->isBusy(zone.widget)
+                && zone.widget->getFileModel()->entryCount() == config.files) {
+                ++ready;
+            }
+        }
+        if (ready == zones.size()) {
+            for (int z = 0; z < zones.size(); ++z) {
+                connect(zones[z].widget->getFileModel(), &ZoneFileModel::entriesChanged,
+                        this, [this, z]() { check(z); });
+            }
+            return true;
+        }
+        QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+    }
+    return false;
+}
+
+void ChurnHarness::run()
+{
+    // Only the churn phase is traced
+    Tracer::enable(config.tracePath);
+
+    const double cpuStart = processCpuMs();
+    clock.start();
+    ticker.start();
+
+    QEventLoop loop;
+    QTimer::singleShot(config.durationMs, &loop, [this, &loop]() {
+        ticker.stop();
+        churnNs = clock.nsecsElapsed();
+
+        // Give outstanding operations a few seconds to show up
+        QElapsedTimer drain;
+        drain.start();
+        QTimer *poll = new QTimer(&loop);
+        connect(poll, &QTimer::timeout, &loop, [this, &loop, drain]() {
+            if (pendingCount() == 0 || drain.elapsed() > 5000) {
+                loop.quit();
+            }
+        });
+        poll->start(20);
+    });
+    loop.exec();
+
+    cpuMs = processCpuMs() - cpuStart;
+    for (const Zone &zone : zones) {
+        for (const Pending &op : zone.pending) {
+            ++missed[op.kind];
+        }
+    }
+}
+
+void ChurnHarness::tick()
+{
+    // Operations due so far at the configured rates
+    const double elapsedSec = clock.nsecsElapsed() / 1e9;
+    int due[OpKindCount];
+    int totalDue = 0;
+    for (int kind = 0; kind < OpKindCount; ++kind) {
+        due[kind] = int(config.rates[kind] * elapsedSec) - issued[kind];
+        totalDue += qMax(0, due[kind]);
+    }
+
+    if (totalDue < config.burst) {
+        return;
+    }
+
+    for (int kind = 0; kind < OpKindCount; ++kind) {
+        for (int i = 0; i < due[kind]; ++i) {
+            issue(OpKind(kind));
+        }
+    }
+}
+
+void ChurnHarness::issue(OpKind kind)
+{
+    ++issued[kind];
+    const int z = int(random.bounded(quint32(zones.size())));
+    Zone &zone = zones[z];
+
+    // Deletes and renames need a file the zone already shows
+    if (kind != Create && zone.knownFiles.isEmpty()) {
+        kind = Create;
+    }
+
+    Pending op{ kind, QString(), QString(), true, 0 };
+    if (kind == Create) {
+        op.path = QDir(zone.folder).filePath(newFileName());
+        QFile file(op.path);
+        file.open(QIODevice::WriteOnly);
+    } else {
+        const int index = int(random.bounded(quint32(zone.knownFiles.size())));
+        const QString path = zone.knownFiles.at(index);
+        zone.knownFiles.swapItemsAt(index, zone.knownFiles.size() - 1);
+        zone.knownFiles.removeLast();
+
+        if (kind == Delete) {
+            op.path = path;
+            op.shouldExist = false;
+            QFile::remove(path);
+        } else {
+            op.path = QDir(zone.folder).filePath(newFileName());
+            op.oldPath = path;
+            QFile::rename(path, op.path);
+        }
+    }
+
+    op.issuedNs = clock.nsecsElapsed();
+    zone.pending.append(op);
+}
+
+void ChurnHarness::check(int zoneIndex)
+{
+    Zone &zone = zones[zoneIndex];
+    if (zone.pending.isEmpty()) {
+        return;
+    }
+
+    const qint64 now = clock.nsecsElapsed();
+    ZoneFileModel *model = zone.widget->getFileModel();
+    for (int i = zone.pending.size() - 1; i >= 0; --i) {
+        const Pending &op = zone.pending.at(i);
+        if (model->contains(op.path) != op.shouldExist
+            || (!op.oldPath.isEmpty() && model->contains(op.oldPath))) {
+            continue;
+        }
+        latenciesMs[op.kind].append((now - op.issuedNs) / 1e6);
+        if (op.shouldExist) {
+            zone.knownFiles.append(op.path);
+        }
+        zone.pending.removeAt(i);
+    }
+}
+
+QString ChurnHarness::newFileName()
+{
+    return QStringLiteral("churn %1.txt").arg(++nameCounter, 6, 10, QLatin1Char('0'));
+}
+
+int ChurnHarness::pendingCount() const
+{
+    int count = 0;
+    for (const Zone &zone : zones) {
+        count += zone.pending.size();
+    }
+    return count;
+}
+
+void ChurnHarness::report()
+{
+    QTextStream out(stdout);
+    QJsonObject json;
+    QJsonObject jsonOps;
+
+    out << QString("zones %1, %2 files each, %3 s, burst %4\n")
+               .arg(config.zones).arg(config.files).arg(churnNs / 1e9, 0, 'f', 1).arg(config.burst);
+    out << "op          issued   missed     p50_ms     p99_ms     max_ms\n";
+
+    QVector<double> all;
+    for (int kind = 0; kind < OpKindCount; ++kind) {
+        QVector<double> samples = latenciesMs[kind];
+        std::sort(samples.begin(), samples.end());
+        all += samples;
+
+        const double p50 = percentile(samples, 0.50);
+        const double p99 = percentile(samples, 0.99);
+        const double max = samples.isEmpty() ? 0 : samples.last();
+        out << QString("%1 %2 %3 %4 %5 %6\n")
+                   .arg(QString::fromLatin1(OP_NAMES[kind]), -8)
+                   .arg(issued[kind], 8).arg(missed[kind], 8)
+                   .arg(p50, 10, 'f', 2).arg(p99, 10, 'f', 2).arg(max, 10, 'f', 2);
+
+        jsonOps[OP_NAMES[kind]] = QJsonObject{
+            { "issued", issued[kind] }, { "missed", missed[kind] },
+            { "p50_ms", p50 }, { "p99_ms", p99 }, { "max_ms", max } };
+    }
+    std::sort(all.begin(), all.end());
+    out << QString("%1 %2 %3 %4 %5 %6\n\n")
+               .arg(QStringLiteral("all"), -8)
+               .arg(all.size(), 8).arg(QString(), 8)
+               .arg(percentile(all, 0.50), 10, 'f', 2).arg(percentile(all, 0.99), 10, 'f', 2)
+               .arg(all.isEmpty() ? 0.0 : all.last(), 10, 'f', 2);
+
+    // Where the time went: CPU time of the thread running each span, and wall
+    // time (which includes waiting, e.g. on the disk)
+    const QHash<QString, Tracer::SpanTotal> totals = Tracer::totals();
+    QJsonObject jsonSpans;
+    out << "span                                   calls     cpu_ms    wall_ms max_wall_ms\n";
+    for (const char *name : REPORTED_SPANS) {
+        const Tracer::SpanTotal total = totals.value(QString::fromLatin1(name));
+        out << QString("%1 %2 %3 %4 %5\n")
+                   .arg(QString::fromLatin1(name), -36)
+                   .arg(total.count, 8)
+                   .arg(total.cpuNs / 1e6, 10, 'f', 2)
+                   .arg(total.totalNs / 1e6, 10, 'f', 2).arg(total.maxNs / 1e6, 11, 'f', 2);
+        jsonSpans[name] = QJsonObject{
+            { "calls", total.count }, { "cpu_ms", total.cpuNs / 1e6 },
+            { "wall_ms", total.totalNs / 1e6 }, { "max_wall_ms", total.maxNs / 1e6 } };
+    }
+    out << QString("\nprocess CPU time during churn: %1 ms\n").arg(cpuMs, 0, 'f', 1);
+
+    if (!config.jsonPath.isEmpty()) {
+        json["zones"] = config.zones;
+        json["files"] = config.files;
+        json["duration_s"] = churnNs / 1e9;
+        json["burst"] = config.burst;
+        json["ops"] = jsonOps;
+        json["spans"] = jsonSpans;
+        json["cpu_ms"] = cpuMs;
+
+        QSaveFile file(config.jsonPath);
+        if (file.open(QIODevice::WriteOnly)) {
+            file.write(QJsonDocument(json).toJson(QJsonDocument::Indented));
+            file.commit();
+        }
+    }
+    if (!config.tracePath.isEmpty()) {
+        Tracer::write();
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    QApplication app(argc, argv);
+    Theme::install(app);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Boox change-to-visible latency under filesystem churn");
+    parser.addHelpOption();
+    const QCommandLineOption zonesOption("zones", "Number of zone folders.", "n", "4");
+    const QCommandLineOption filesOption("files", "Initial files per zone.", "n", "1000");
+    const QCommandLineOption durationOption("duration", "Churn duration in seconds.", "s", "10");
+    const QCommandLineOption createOption("create-rate", "Creates per second.", "r", "50");
+    const QCommandLineOption deleteOption("delete-rate", "Deletes per second.", "r", "20");
+    const QCommandLineOption renameOption("rename-rate", "Renames per second.", "r", "10");
+    const QCommandLineOption burstOption("burst", "Operations issued at once.", "n", "1");
+    const QCommandLineOption seedOption("seed", "Random seed.", "n", "1");
+    const QCommandLineOption jsonOption("json", "Also write results as JSON.", "file");
+    const QCommandLineOption traceOption("trace", "Write a Chrome trace of the churn phase.", "file");
+    parser.addOptions({ zonesOption, filesOption, durationOption, createOption, deleteOption,
+                        renameOption, burstOption, seedOption, jsonOption, traceOption });
+    parser.process(app);
+
+    ChurnConfig config;
+    config.zones = qMax(1, parser.value(zonesOption).toInt());
+    config.files = qMax(0, parser.value(filesOption).toInt());
+    config.durationMs = qMax(1, int(parser.value(durationOption).toDouble() * 1000));
+    config.rates[Create] = qMax(0.0, parser.value(createOption).toDouble());
+    config.rates[Delete] = qMax(0.0, parser.value(deleteOption).toDouble());
+    config.rates[Rename] = qMax(0.0, parser.value(renameOption).toDouble());
+    config.burst = qMax(1, parser.value(burstOption).toInt());
+    config.seed = parser.value(seedOption).toUInt();
+    config.jsonPath = parser.value(jsonOption);
+    config.tracePath = parser.value(traceOption);
+
+    QTemporaryDir root;
+    if (!root.isValid()) {
+        QTextStream(stderr) << "cannot create a temporary root\n";
+        return 1;
+    }
+
+    ChurnHarness harness(config, root.path());
+    if (!harness.prepare()) {
+        QTextStream(stderr) << "cannot create zone folders in " << root.path() << "\n";
+        return 1;
+    }
+
+    MainWindow window(root.path());
+    if (!harness.attachZones(60000)) {
+        QTextStream(stderr) << "zones did not finish loading\n";
+        return 1;
+    }
+
+    harness.run();
+    harness.report();
+    return 0;
+}
+
+#include "churn_bench.moc"
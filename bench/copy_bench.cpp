@@ -0,0 +1,234 @@
+// Copy throughput of each CopyEngine method vs. the old QFile::copy path.
+//
+//   copy_bench [--size MB] [--sparse] [--runs N] [--to DIR] [DIR...]
+//
+// In every DIR (default: the system temp dir) a source file of --size MB is
+// written (random data, or with --sparse 1 MiB of data every 8 MiB) and
+// copied with each method on its own, then with the automatic fallback
+// order. With --to, copies go from each DIR into that folder instead, which
+// is the cross-device case of a zone drop. Every copy is compared with the
+// source; on Unix the allocated size shows whether holes survived. The last
+// row times CopyEngine::verify on a finished copy (hash of both files, with
+// the copy read back from the device).
+// The source stays in the page cache, so this measures the copy path, not
+// the disk. To compare filesystems locally:
+//
+//   truncate -s 4G ext4.img && mkfs.ext4 -q ext4.img
+//   truncate -s 4G xfs.img && mkfs.xfs -q -m reflink=1 xfs.img
+//   sudo mkdir -p /mnt/ext4 /mnt/xfs /mnt/tmpfs
+//   sudo mount -o loop ext4.img /mnt/ext4
+//   sudo mount -o loop xfs.img /mnt/xfs
+//   sudo mount -t tmpfs -o size=2G tmpfs /mnt/tmpfs
+//   sudo chown "$USER" /mnt/ext4 /mnt/xfs /mnt/tmpfs
+//   copy_bench --size 1024 /mnt/tmpfs /mnt/ext4 /mnt/xfs
+//   copy_bench --size 1024 --to /mnt/xfs /mnt/ext4
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QRandomGenerator>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <algorithm>
+#include "features/copy/copyengine.h"
+
+#if defined(Q_OS_UNIX)
+#include <sys/stat.h>
+#endif
+
+namespace {
+
+constexpr qint64 MB = 1024 * 1024;
+
+struct Candidate
+{
+    const char *name;
+    int methods;          // 0: QFile::copy
+};
+
+const Candidate CANDIDATES[] = {
+    { "QFile::copy", 0 },
+#if defined(Q_OS_LINUX)
+    { "reflink", CopyEngine::Reflink },
+    { "copy_file_range", CopyEngine::CopyFileRange },
+    { "sendfile", CopyEngine::SendFile },
+#elif defined(Q_OS_WIN)
+    { "CopyFileEx", CopyEngine::SystemCopy },
+#endif
+    { "read/write", CopyEngine::ReadWrite },
+    { "auto", CopyEngine::AllMethods },
+};
+
+bool writeSource(const QString &path, qint64 size, bool sparse)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        return false;
+    }
+
+    QByteArray chunk(int(MB), Qt::Uninitialized);
+    for (qint64 offset = 0; offset < size; offset += MB) {
+        // Sparse: one data MiB per 8 MiB, the rest left as holes
+        if (sparse && (offset / MB) % 8 != 0) {
+            continue;
+        }
+        QRandomGenerator::global()->fillRange(reinterpret_cast<quint32 *>(chunk.data()),
+                                              chunk.size() / int(sizeof(quint32)));
+        const qint64 length = qMin(MB, size - offset);
+        if (!file.seek(offset) || file.write(chunk.constData(), length) != length) {
+            return false;
+        }
+    }
+    return file.resize(size);
+}
+
+bool sameContent(const QString &a, const QString &b)
+{
+    QFile fa(a);
+    QFile fb(b);
+    if (!fa.open(QIODevice::ReadOnly) || !fb.open(QIODevice::ReadOnly) || fa.size() != fb.size()) {
+        return false;
+    }
+    while (!fa.atEnd()) {
+        if (fa.read(MB) != fb.read(MB)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Allocated size in MiB, -1 where unknown
+double allocatedMb(const QString &path)
+{
+#if defined(Q_OS_UNIX)
+    struct stat st;
+    if (::stat(QFile::encodeName(path).constData(), &st) == 0) {
+        return st.st_blocks * 512.0 / MB;
+    }
+#else
+    Q_UNUSED(path);
+#endif
+    return -1;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("CopyEngine throughput per copy method");
+    parser.addHelpOption();
+    const QCommandLineOption sizeOption("size", "Source file size in MiB.", "MB", "256");
+    const QCommandLineOption sparseOption("sparse", "Use a sparse source file.");
+    const QCommandLineOption runsOption("runs", "Copies per method (median is reported).", "n", "3");
+    const QCommandLineOption toOption("to", "Copy into this folder instead of the source folder.", "dir");
+    parser.addOptions({ sizeOption, sparseOption, runsOption, toOption });
+    parser.addPositionalArgument("dirs", "Folders to put the source file in.", "[DIR...]");
+    parser.process(app);
+
+    const qint64 size = qMax<qint64>(1, parser.value(sizeOption).toLongLong()) * MB;
+    const bool sparse = parser.isSet(sparseOption);
+    const int runs = qMax(1, parser.value(runsOption).toInt());
+    QStringList dirs = parser.positionalArguments();
+    if (dirs.isEmpty()) {
+        dirs << QDir::tempPath();
+    }
+
+    QTextStream out(stdout);
+    out << QString("%1 MiB %2 source, median of %3 copies\n\n")
+               .arg(size / MB).arg(sparse ? "sparse" : "dense").arg(runs);
+    out << "folder                   method                ms       MiB/s   alloc_MiB  ok\n";
+
+    for (const QString &dir : dirs) {
+        QTemporaryDir sourceDir(QDir(dir).filePath("copy_bench-XXXXXX"));
+        QTemporaryDir targetDir(parser.isSet(toOption)
+                                    ? QDir(parser.value(toOption)).filePath("copy_bench-XXXXXX")
+                                    : QDir(dir).filePath("copy_bench-XXXXXX"));
+        if (!sourceDir.isValid() || !targetDir.isValid()) {
+            QTextStream(stderr) << "cannot create a folder in " << dir << "\n";
+            return 1;
+        }
+
+        const QString source = sourceDir.filePath("source.bin");
+        if (!writeSource(source, size, sparse)) {
+            QTextStream(stderr) << "cannot write " << source << "\n";
+            return 1;
+        }
+        const QString label = parser.isSet(toOption) ? dir + " -> " + parser.value(toOption) : dir;
+
+        for (const Candidate &candidate : CANDIDATES) {
+            QVector<qint64> samplesNs;
+            bool ok = true;
+            QString error;
+            double allocated = -1;
+
+            for (int run = 0; run < runs && ok; ++run) {
+                const QString target = targetDir.filePath(QString("copy-%1.bin").arg(run));
+                QFile::remove(target);
+
+                QElapsedTimer timer;
+                timer.start();
+                if (candidate.methods == 0) {
+                    ok = QFile::copy(source, target);
+                } else {
+                    const CopyEngine::Result result = CopyEngine::copyFile(
+                        source, target, CopyEngine::ProgressCallback(), candidate.methods);
+                    ok = result.ok;
+                    error = result.error;
+                }
+                samplesNs.append(timer.nsecsElapsed());
+
+                if (ok) {
+                    ok = sameContent(source, target);
+                    error = ok ? QString() : QStringLiteral("content differs");
+                    allocated = allocatedMb(target);
+                }
+                QFile::remove(target);
+            }
+
+            if (!ok) {
+                out << QString("%1 %2 %3\n")
+                           .arg(label, -24).arg(QString::fromLatin1(candidate.name), -16)
+                           .arg(QStringLiteral("n/a (%1)").arg(error));
+                continue;
+            }
+
+            std::sort(samplesNs.begin(), samplesNs.end());
+            const double ms = samplesNs.at(samplesNs.size() / 2) / 1e6;
+            out << QString("%1 %2 %3 %4 %5  yes\n")
+                       .arg(label, -24).arg(QString::fromLatin1(candidate.name), -16)
+                       .arg(ms, 10, 'f', 1)
+                       .arg(ms > 0 ? (size / double(MB)) / (ms / 1000.0) : 0.0, 11, 'f', 0)
+                       .arg(allocated, 11, 'f', 1);
+        }
+
+        // Verification of an automatic copy
+        const QString copy = targetDir.filePath(QStringLiteral("verify.bin"));
+        QFile::remove(copy);
+        if (CopyEngine::copyFile(source, copy).ok) {
+            QVector<qint64> samplesNs;
+            bool ok = true;
+            for (int run = 0; run < runs && ok; ++run) {
+                QElapsedTimer timer;
+                timer.start();
+                ok = CopyEngine::verify(source, copy).ok;
+                samplesNs.append(timer.nsecsElapsed());
+            }
+            std::sort(samplesNs.begin(), samplesNs.end());
+            const double ms = samplesNs.at(samplesNs.size() / 2) / 1e6;
+            out << QString("%1 %2 %3 %4 %5  %6\n")
+                       .arg(label, -24).arg(QStringLiteral("verify"), -16)
+                       .arg(ms, 10, 'f', 1)
+                       .arg(ms > 0 ? (size / double(MB)) / (ms / 1000.0) : 0.0, 11, 'f', 0)
+                       .arg(allocatedMb(copy), 11, 'f', 1)
+                       .arg(ok ? "yes" : "no");
+            QFile::remove(copy);
+        }
+        out.flush();
+    }
+    return 0;
+}
@@ -0,0 +1,133 @@
+// Folder tree deletion: QDir::removeRecursively vs. DeleteQueue.
+//
+//   delete_bench [--files N] [--fanout N] [--depth N] [--runs N] [DIR]
+//
+// Builds a tree in DIR (default: the system temp dir) with --fanout
+// subfolders per folder, --depth levels deep and --files empty files spread
+// over all folders (a node_modules-like shape), then deletes it. Reported per
+// method: median wall time, entries removed per second, and how long the
+// calling (GUI) thread was blocked. Deletion is metadata-bound, so results
+// depend on the file system and on whether its metadata is cached; run on
+// the disk the zones live on.
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <algorithm>
+#include "features/delete/deletequeue.h"
+
+namespace {
+
+struct TreeShape
+{
+    int files;
+    int fanout;
+    int depth;
+};
+
+// Returns the number of entries created (files and folders)
+qint64 buildTree(const QString &root, const TreeShape &shape)
+{
+    QStringList folders{ root };
+    QDir().mkpath(root);
+    for (int level = 0, first = 0; level < shape.depth; ++level) {
+        const int last = folders.size();
+        for (int i = first; i < last; ++i) {
+            for (int j = 0; j < shape.fanout; ++j) {
+                const QString path = QDir(folders.at(i)).filePath(QStringLiteral("dir%1").arg(j));
+                QDir().mkdir(path);
+                folders.append(path);
+            }
+        }
+        first = last;
+    }
+
+    for (int i = 0; i < shape.files; ++i) {
+        QFile file(QDir(folders.at(i % folders.size())).filePath(QStringLiteral("file%1.js").arg(i)));
+        file.open(QIODevice::WriteOnly);
+    }
+    return shape.files + folders.size();
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Folder tree deletion throughput");
+    parser.addHelpOption();
+    const QCommandLineOption filesOption("files", "Files in the tree.", "n", "50000");
+    const QCommandLineOption fanoutOption("fanout", "Subfolders per folder.", "n", "6");
+    const QCommandLineOption depthOption("depth", "Folder levels.", "n", "4");
+    const QCommandLineOption runsOption("runs", "Deletions per method (median is reported).", "n", "3");
+    parser.addOptions({ filesOption, fanoutOption, depthOption, runsOption });
+    parser.addPositionalArgument("dir", "Folder to build the tree in.", "[DIR]");
+    parser.process(app);
+
+    const TreeShape shape{ qMax(0, parser.value(filesOption).toInt()),
+                           qMax(1, parser.value(fanoutOption).toInt()),
+                           qMax(0, parser.value(depthOption).toInt()) };
+    const int runs = qMax(1, parser.value(runsOption).toInt());
+    const QString dir = parser.positionalArguments().value(0, QDir::tempPath());
+
+    QTemporaryDir workDir(QDir(dir).filePath("delete_bench-XXXXXX"));
+    if (!workDir.isValid()) {
+        QTextStream(stderr) << "cannot create a folder in " << dir << "\n";
+        return 1;
+    }
+
+    QTextStream out(stdout);
+    out << "method                    entries        ms    entries/s   blocked_ms  ok\n";
+
+    for (const bool queued : { false, true }) {
+        QVector<qint64> samplesNs;
+        QVector<qint64> blockedNs;
+        qint64 entries = 0;
+        bool ok = true;
+
+        for (int run = 0; run < runs && ok; ++run) {
+            const QString root = workDir.filePath(QStringLiteral("tree%1").arg(run));
+            entries = buildTree(root, shape);
+
+            QElapsedTimer timer;
+            timer.start();
+            if (!queued) {
+                ok = QDir(root).removeRecursively();
+                blockedNs.append(timer.nsecsElapsed());
+            } else {
+                QEventLoop loop;
+                QObject::connect(DeleteQueue::instance(), &DeleteQueue::jobFinished, &loop,
+                                 [&](const DeleteStatus &status) {
+                    ok = status.failed.isEmpty();
+                    loop.quit();
+                });
+                DeleteQueue::instance()->remove({ root });
+                blockedNs.append(timer.nsecsElapsed());
+                loop.exec();
+            }
+            samplesNs.append(timer.nsecsElapsed());
+            ok = ok && !QFileInfo::exists(root);
+        }
+
+        std::sort(samplesNs.begin(), samplesNs.end());
+        std::sort(blockedNs.begin(), blockedNs.end());
+        const double ms = samplesNs.at(samplesNs.size() / 2) / 1e6;
+        out << QString("%1 %2 %3 %4 %5  %6\n")
+                   .arg(QString::fromLatin1(queued ? "DeleteQueue" : "QDir::removeRecursively"), -24)
+                   .arg(entries, 8)
+                   .arg(ms, 9, 'f', 1)
+                   .arg(ms > 0 ? entries / (ms / 1000.0) : 0.0, 12, 'f', 0)
+                   .arg(blockedNs.at(blockedNs.size() / 2) / 1e6, 12, 'f', 2)
+                   .arg(ok ? "yes" : "no");
+        out.flush();
+    }
+    return 0;
+}
@@ -0,0 +1,165 @@
+// Save latency of the layout journal vs. the old whole-file JSON rewrite.
+//
+//   layout_bench [saves-per-size]
+//
+// For 10, 100 and 1000 zones, moves one zone at a time and reports the
+// median / 95th percentile / max time of a single save, including the
+// periodic compaction the journal does on its own. Journal saves are
+// synced to disk; the JSON rewrite never was, so it is flattered here.
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStringList>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <algorithm>
+#include "features/layout/layoutjournal.h"
+
+namespace {
+
+struct Stats
+{
+    double medianUs = 0;
+    double p95Us = 0;
+    double maxUs = 0;
+};
+
+Stats summarize(QVector<qint64> samplesNs)
+{
+    Stats stats;
+    if (samplesNs.isEmpty()) {
+        return stats;
+    }
+    std::sort(samplesNs.begin(), samplesNs.end());
+    stats.medianUs = samplesNs.at(samplesNs.size() / 2) / 1000.0;
+    stats.p95Us = samplesNs.at(qMin(samplesNs.size() - 1, samplesNs.size() * 95 / 100)) / 1000.0;
+    stats.maxUs = samplesNs.last() / 1000.0;
+    return stats;
+}
+
+QString zonePath(int index)
+{
+    return QStringLiteral("d:/boox/Zone %1").arg(index);
+}
+
+ZoneLayout layoutFor(int index, int step)
+{
+    ZoneLayout layout;
+    layout.geometry = QRect(50 * (index % 20) + step, 50 * (index / 20), 250, 350);
+    layout.hasViewMode = true;
+    layout.gridMode = index % 2;
+    return layout;
+}
+
+Stats benchJournal(const QString &dir, int zones, int saves)
+{
+    LayoutJournal journal(dir + "/.layout");
+    journal.load();
+
+    QVector<LayoutRecord> all;
+    for (int i = 0; i < zones; ++i) {
+        all.append(LayoutRecord{ zonePath(i), false, layoutFor(i, 0) });
+    }
+    journal.append(all);
+
+    QVector<qint64> samples;
+    QElapsedTimer timer;
+    for (int s = 0; s < saves; ++s) {
+        const int index = s % zones;
+        timer.start();
+        journal.append({ LayoutRecord{ zonePath(index), false, layoutFor(index, s + 1) } });
+        if (journal.needsCompaction()) {
+            journal.compact();
+        }
+        samples.append(timer.nsecsElapsed());
+    }
+
+    // Recovery must reproduce the last saved state exactly
+    LayoutJournal reloaded(dir + "/.layout");
+    reloaded.load();
+    if (reloaded.layouts() != journal.layouts()) {
+        QTextStream(stderr) << "journal recovery mismatch at " << zones << " zones\n";
+    }
+    return summarize(samples);
+}
+
+// What FloatingZone::saveLayout used to do on every move/resize
+Stats benchJsonRewrite(const QString &dir, int zones, int saves)
+{
+    const QString filePath = dir + "/.layout.json";
+    {
+        QJsonObject root;
+        for (int i = 0; i < zones; ++i) {
+            const ZoneLayout layout = layoutFor(i, 0);
+            QJsonObject zoneData;
+            zoneData["x"] = layout.geometry.x();
+            zoneData["y"] = layout.geometry.y();
+            zoneData["width"] = layout.geometry.width();
+            zoneData["height"] = layout.geometry.height();
+            zoneData["viewMode"] = layout.gridMode ? "grid" : "list";
+            root[zonePath(i)] = zoneData;
+        }
+        QFile file(filePath);
+        file.open(QIODevice::WriteOnly);
+        file.write(QJsonDocument(root).toJson(QJsonDocument::Indented));
+    }
+
+    QVector<qint64> samples;
+    QElapsedTimer timer;
+    for (int s = 0; s < saves; ++s) {
+        const int index = s % zones;
+        const ZoneLayout layout = layoutFor(index, s + 1);
+        timer.start();
+
+        QJsonObject root;
+        QFile file(filePath);
+        if (file.open(QIODevice::ReadOnly)) {
+            root = QJsonDocument::fromJson(file.readAll()).object();
+            file.close();
+        }
+        QJsonObject zoneData;
+        zoneData["x"] = layout.geometry.x();
+        zoneData["y"] = layout.geometry.y();
+        zoneData["width"] = layout.geometry.width();
+        zoneData["height"] = layout.geometry.height();
+        zoneData["viewMode"] = layout.gridMode ? "grid" : "list";
+        root[zonePath(index)] = zoneData;
+        if (file.open(QIODevice::WriteOnly)) {
+            file.write(QJsonDocument(root).toJson(QJsonDocument::Indented));
+            file.close();
+        }
+
+        samples.append(timer.nsecsElapsed());
+    }
+    return summarize(samples);
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    const QStringList args = app.arguments();
+    const int saves = args.size() > 1 ? qMax(1, args.at(1).toInt()) : 500;
+
+    QTextStream out(stdout);
+    out << "zones  format        median_us     p95_us     max_us\n";
+
+    for (int zones : { 10, 100, 1000 }) {
+        QTemporaryDir journalDir;
+        QTemporaryDir jsonDir;
+        const Stats journal = benchJournal(journalDir.path(), zones, saves);
+        const Stats json = benchJsonRewrite(jsonDir.path(), zones, saves);
+
+        out << QString("%1  journal     %2 %3 %4\n").arg(zones, 5)
+                   .arg(journal.medianUs, 10, 'f', 1).arg(journal.p95Us, 10, 'f', 1)
+                   .arg(journal.maxUs, 10, 'f', 1);
+        out << QString("%1  json        %2 %3 %4\n").arg(zones, 5)
+                   .arg(json.medianUs, 10, 'f', 1).arg(json.p95Us, 10, 'f', 1)
+                   .arg(json.maxUs, 10, 'f', 1);
+    }
+    return 0;
+}
@@ -0,0 +1,130 @@
+// Choosing target names for a bulk drop: a stat per candidate vs. NameIndex.
+//
+//   names_bench [--items N] [--existing N] [--runs N] [DIR]
+//
+// Fills a folder in DIR (default: the system temp dir) with --existing files
+// report.pdf, report_1.pdf, ... and then names --items more items called
+// report.pdf for it, first the old way (QFileInfo::exists on name_1,
+// name_2, ... for every item, which is quadratic in stats) and then with one
+// NameIndex listing. Reported per method: median time, the stat calls it
+// needed, and whether both came up with the same names.
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QSet>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <algorithm>
+#include "features/names/nameindex.h"
+
+namespace {
+
+// What TransferQueue did before NameIndex
+QStringList probeNames(const QString &folder, const QString &fileName, int items, qint64 &stats)
+{
+    const QDir dir(folder);
+    const QFileInfo source(fileName);
+    QSet<QString> reserved;
+    auto taken = [&](const QString &path) {
+        if (reserved.contains(path)) {
+            return true;
+        }
+        ++stats;
+        if (QFileInfo::exists(path)) {
+            return true;
+        }
+        ++stats;
+        return QFileInfo(path).isSymLink();
+    };
+
+    QStringList names;
+    for (int i = 0; i < items; ++i) {
+        QString path = dir.absoluteFilePath(fileName);
+        for (int counter = 1; taken(path); ++counter) {
+            path = dir.absoluteFilePath(QStringLiteral("%1_%2.%3")
+                .arg(source.completeBaseName()).arg(counter).arg(source.suffix()));
+        }
+        reserved.insert(path);
+        names.append(QFileInfo(path).fileName());
+    }
+    return names;
+}
+
+QStringList indexNames(const QString &folder, const QString &fileName, int items)
+{
+    NameIndex index(folder);
+    QStringList names;
+    for (int i = 0; i < items; ++i) {
+        names.append(index.allocate(fileName, false));
+    }
+    return names;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Target name allocation for bulk drops");
+    parser.addHelpOption();
+    const QCommandLineOption itemsOption("items", "Same-named items dropped.", "n", "2000");
+    const QCommandLineOption existingOption("existing", "report_N.pdf already in the folder.", "n", "2000");
+    const QCommandLineOption runsOption("runs", "Runs per method (median is reported).", "n", "3");
+    parser.addOptions({ itemsOption, existingOption, runsOption });
+    parser.addPositionalArgument("dir", "Folder to create the target folder in.", "[DIR]");
+    parser.process(app);
+
+    const int items = qMax(1, parser.value(itemsOption).toInt());
+    const int existing = qMax(0, parser.value(existingOption).toInt());
+    const int runs = qMax(1, parser.value(runsOption).toInt());
+    const QString dir = parser.positionalArguments().value(0, QDir::tempPath());
+
+    QTemporaryDir workDir(QDir(dir).filePath("names_bench-XXXXXX"));
+    if (!workDir.isValid()) {
+        QTextStream(stderr) << "cannot create a folder in " << dir << "\n";
+        return 1;
+    }
+    const QString fileName = QStringLiteral("report.pdf");
+    for (int i = 0; i < existing; ++i) {
+        QFile file(workDir.filePath(i == 0 ? fileName : QStringLiteral("report_%1.pdf").arg(i)));
+        file.open(QIODevice::WriteOnly);
+    }
+
+    QTextStream out(stdout);
+    out << "method             items  existing         ms        stats  same\n";
+
+    QStringList expected;
+    for (const bool indexed : { false, true }) {
+        QVector<qint64> samplesNs;
+        qint64 stats = 0;
+        QStringList names;
+        for (int run = 0; run < runs; ++run) {
+            stats = 0;
+            QElapsedTimer timer;
+            timer.start();
+            names = indexed ? indexNames(workDir.path(), fileName, items)
+                            : probeNames(workDir.path(), fileName, items, stats);
+            samplesNs.append(timer.nsecsElapsed());
+        }
+        if (!indexed) {
+            expected = names;
+        }
+
+        std::sort(samplesNs.begin(), samplesNs.end());
+        out << QString("%1 %2 %3 %4 %5  %6\n")
+                   .arg(QString::fromLatin1(indexed ? "NameIndex" : "stat per name"), -16)
+                   .arg(items, 7)
+                   .arg(existing, 9)
+                   .arg(samplesNs.at(samplesNs.size() / 2) / 1e6, 10, 'f', 2)
+                   .arg(stats, 12)
+                   .arg(names == expected ? "yes" : "no");
+        out.flush();
+    }
+    return 0;
+}
@@ -0,0 +1,220 @@
+// Zone listing / refresh throughput on synthetic folders.
+//
+//   boox_bench [QtTest options]
+//
+// Runs under the offscreen platform unless QT_QPA_PLATFORM says otherwise.
+// Folder sizes come from BOOX_BENCH_SIZES (default "10,1000,10000,100000").
+// Without an explicit -o, results are printed and also written to
+// boox_bench.xml (QtTest XML), which can be diffed between builds.
+
+#include <QApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTimer>
+#include <QtTest>
+#include <functional>
+#include "floatingzone.h"
+#include "features/coalescer/coalescer.h"
+#include "features/dirscan/dirscan.h"
+#include "features/filemodel/filemodel.h"
+#include "features/theme/theme.h"
+
+namespace {
+
+constexpr int WAIT_TIMEOUT_MS = 120000;
+
+// Spin the event loop until done() holds
+bool waitUntil(const std::function<bool()> &done)
+{
+    // Keeps WaitForMoreEvents from sleeping forever if nothing else arrives
+    QTimer heartbeat;
+    heartbeat.start(10);
+
+    QElapsedTimer timer;
+    timer.start();
+    while (!done()) {
+        if (timer.elapsed() > WAIT_TIMEOUT_MS) {
+            return false;
+        }
+        QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+    }
+    return true;
+}
+
+bool listingDone(FloatingZone *zone)
+{
+    return !DirScanner::instance()->isBusy(zone);
+}
+
+} // namespace
+
+class ZoneBench : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void populate_data();
+    void populate();
+
+    void refreshAfterChange_data();
+    void refreshAfterChange();
+
+    void toggleViewMode_data();
+    void toggleViewMode();
+
+private:
+    void addSizes();
+    QString folderFor(int size) const;
+
+    QTemporaryDir root;
+    QList<int> sizes;
+};
+
+void ZoneBench::initTestCase()
+{
+    QVERIFY(root.isValid());
+
+    const QString spec = qEnvironmentVariable("BOOX_BENCH_SIZES",
+                                              QStringLiteral("10,1000,10000,100000"));
+    for (const QString &part : spec.split(QLatin1Char(','), Qt::SkipEmptyParts)) {
+        bool ok = false;
+        const int size = part.trimmed().toInt(&ok);
+        if (ok && size > 0) {
+            sizes.append(size);
+        }
+    }
+    QVERIFY(!sizes.isEmpty());
+
+    // One folder per size, mostly files plus a few subfolders
+    for (int size : sizes) {
+        const QString folder = folderFor(size);
+        QVERIFY(QDir().mkpath(folder));
+        const QDir dir(folder);
+        for (int i = 0; i < size; ++i) {
+            if (i % 50 == 0) {
+                QVERIFY(dir.mkdir(QStringLiteral("folder %1").arg(i, 6, 10, QLatin1Char('0'))));
+                continue;
+            }
+            QFile file(dir.filePath(QStringLiteral("file %1.txt").arg(i, 6, 10, QLatin1Char('0'))));
+            QVERIFY(file.open(QIODevice::WriteOnly));
+        }
+    }
+}
+
+void ZoneBench::addSizes()
+{
+    QTest::addColumn<int>("size");
+    for (int size : sizes) {
+        QTest::newRow(qPrintable(QString::number(size))) << size;
+    }
+}
+
+QString ZoneBench::folderFor(int size) const
+{
+    return root.filePath(QStringLiteral("zone-%1").arg(size));
+}
+
+void ZoneBench::populate_data()
+{
+    addSizes();
+}
+
+// Widget creation through a complete listing in the model
+void ZoneBench::populate()
+{
+    QFETCH(int, size);
+    const QString folder = folderFor(size);
+
+    QBENCHMARK {
+        FloatingZone zone(QFileInfo(folder).fileName(), folder);
+        zone.show();
+        QVERIFY(waitUntil([&zone]() { return listingDone(&zone); }));
+        QCOMPARE(zone.getFileModel()->entryCount(), size);
+    }
+}
+
+void ZoneBench::refreshAfterChange_data()
+{
+    addSizes();
+}
+
+// One file created or deleted, until the model shows it. Goes through the
+// folder watcher with the zone's debounce switched off.
+void ZoneBench::refreshAfterChange()
+{
+    QFETCH(int, size);
+    const QString folder = folderFor(size);
+
+    FloatingZone zone(QFileInfo(folder).fileName(), folder);
+    zone.show();
+    QVERIFY(waitUntil([&zone]() { return listingDone(&zone); }));
+
+    ChangeCoalescer *coalescer = zone.findChild<ChangeCoalescer *>();
+    QVERIFY(coalescer);
+    coalescer->setQuietPeriod(0);
+    coalescer->setMaxLatency(0);
+
+    const QString probePath = QDir(folder).filePath(QStringLiteral("probe.txt"));
+    ZoneFileModel *model = zone.getFileModel();
+
+    QBENCHMARK {
+        if (QFile::exists(probePath)) {
+            QVERIFY(QFile::remove(probePath));
+            QVERIFY(waitUntil([&]() { return model->entryCount() == size && listingDone(&zone); }));
+        } else {
+            QFile probe(probePath);
+            QVERIFY(probe.open(QIODevice::WriteOnly));
+            probe.close();
+            QVERIFY(waitUntil([&]() { return model->entryCount() == size + 1 && listingDone(&zone); }));
+        }
+    }
+
+    QFile::remove(probePath);
+}
+
+void ZoneBench::toggleViewMode_data()
+{
+    addSizes();
+}
+
+// Switching between list and grid on a populated zone
+void ZoneBench::toggleViewMode()
+{
+    QFETCH(int, size);
+    const QString folder = folderFor(size);
+
+    FloatingZone zone(QFileInfo(folder).fileName(), folder);
+    zone.show();
+    QVERIFY(waitUntil([&zone]() { return listingDone(&zone); }));
+
+    QBENCHMARK {
+        QVERIFY(QMetaObject::invokeMethod(&zone, "toggleViewMode", Qt::DirectConnection));
+        QVERIFY(waitUntil([&zone]() { return listingDone(&zone); }));
+        QCoreApplication::sendPostedEvents();
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    // No windows on screen; zones still lay out and paint
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    QApplication app(argc, argv);
+    Theme::install(app);
+    ZoneBench bench;
+
+    QStringList args = app.arguments();
+    if (!args.contains(QStringLiteral("-o"))) {
+        args << QStringLiteral("-o") << QStringLiteral("-,txt")
+             << QStringLiteral("-o") << QStringLiteral("boox_bench.xml,xml");
+    }
+    return QTest::qExec(&bench, args);
+}
+
+#include "zone_bench.moc"
@@ -0,0 +1,178 @@
+#include "checksum.h"
+#include <QtEndian>
+#include <array>
+#include <cstring>
+
+namespace {
+
+constexpr quint64 PRIME64_1 = 0x9E3779B185EBCA87ULL;
+constexpr quint64 PRIME64_2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr quint64 PRIME64_3 = 0x165667B19E3779F9ULL;
+constexpr quint64 PRIME64_4 = 0x85EBCA77C2B2AE63ULL;
+constexpr quint64 PRIME64_5 = 0x27D4EB2F165667C5ULL;
+
+inline quint64 rotl64(quint64 x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+inline quint64 read64(const uchar *p)
+{
+    return qFromLittleEndian<quint64>(p);
+}
+
+inline quint64 xxhRound(quint64 acc, quint64 input)
+{
+    acc += input * PRIME64_2;
+    acc = rotl64(acc, 31);
+    return acc * PRIME64_1;
+}
+
+inline quint64 xxhMerge(quint64 acc, quint64 lane)
+{
+    acc ^= xxhRound(0, lane);
+    return acc * PRIME64_1 + PRIME64_4;
+}
+
+// Whole 32-byte stripes; returns the bytes consumed
+qint64 consumeStripes(quint64 *lanes, const uchar *data, qint64 length)
+{
+    const uchar *p = data;
+    const uchar *const end = data + (length & ~qint64(31));
+    quint64 v1 = lanes[0];
+    quint64 v2 = lanes[1];
+    quint64 v3 = lanes[2];
+    quint64 v4 = lanes[3];
+    while (p < end) {
+        v1 = xxhRound(v1, read64(p));
+        v2 = xxhRound(v2, read64(p + 8));
+        v3 = xxhRound(v3, read64(p + 16));
+        v4 = xxhRound(v4, read64(p + 24));
+        p += 32;
+    }
+    lanes[0] = v1;
+    lanes[1] = v2;
+    lanes[2] = v3;
+    lanes[3] = v4;
+    return p - data;
+}
+
+std::array<quint32, 256> makeCrcTable()
+{
+    std::array<quint32, 256> table{};
+    for (quint32 i = 0; i < 256; ++i) {
+        quint32 c = i;
+        for (int k = 0; k < 8; ++k) {
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        }
+        table[i] = c;
+    }
+    return table;
+}
+
+} // namespace
+
+namespace Checksum {
+
+quint32 crc32(const uchar *data, qint64 length)
+{
+    // Built once, thread-safe: the layout journal checksums on a worker thread
+    static const std::array<quint32, 256> table = makeCrcTable();
+
+    quint32 crc = 0xFFFFFFFFu;
+    for (qint64 i = 0; i < length; ++i) {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+quint32 crc32(const QByteArray &data)
+{
+    return crc32(reinterpret_cast<const uchar *>(data.constData()), data.size());
+}
+
+StreamHash::StreamHash(quint64 seed)
+    : seed(seed)
+{
+    lanes[0] = seed + PRIME64_1 + PRIME64_2;
+    lanes[1] = seed + PRIME64_2;
+    lanes[2] = seed;
+    lanes[3] = seed - PRIME64_1;
+}
+
+void StreamHash::add(const uchar *data, qint64 length)
+{
+    totalLength += quint64(length);
+
+    if (buffered > 0) {
+        const int take = int(qMin<qint64>(32 - buffered, length));
+        std::memcpy(buffer + buffered, data, size_t(take));
+        buffered += take;
+        data += take;
+        length -= take;
+        if (buffered < 32) {
+            return;
+        }
+        consumeStripes(lanes, buffer, 32);
+        buffered = 0;
+    }
+
+    const qint64 consumed = consumeStripes(lanes, data, length);
+    buffered = int(length - consumed);
+    std::memcpy(buffer, data + consumed, size_t(buffered));
+}
+
+void StreamHash::add(const QByteArray &data)
+{
+    add(reinterpret_cast<const uchar *>(data.constData()), data.size());
+}
+
+quint64 StreamHash::result() const
+{
+    quint64 h;
+    if (totalLength >= 32) {
+        h = rotl64(lanes[0], 1) + rotl64(lanes[1], 7) + rotl64(lanes[2], 12) + rotl64(lanes[3], 18);
+        for (quint64 lane : lanes) {
+            h = xxhMerge(h, lane);
+        }
+    } else {
+        h = seed + PRIME64_5;
+    }
+    h += totalLength;
+
+    // Tail: the bytes that did not fill a stripe
+    const uchar *p = buffer;
+    const uchar *const end = buffer + buffered;
+    while (p + 8 <= end) {
+        h ^= xxhRound(0, read64(p));
+        h = rotl64(h, 27) * PRIME64_1 + PRIME64_4;
+        p += 8;
+    }
+    if (p + 4 <= end) {
+        h ^= quint64(qFromLittleEndian<quint32>(p)) * PRIME64_1;
+        h = rotl64(h, 23) * PRIME64_2 + PRIME64_3;
+        p += 4;
+    }
+    while (p < end) {
+        h ^= *p * PRIME64_5;
+        h = rotl64(h, 11) * PRIME64_1;
+        ++p;
+    }
+
+    // Avalanche
+    h ^= h >> 33;
+    h *= PRIME64_2;
+    h ^= h >> 29;
+    h *= PRIME64_3;
+    h ^= h >> 32;
+    return h;
+}
+
+quint64 hash64(const uchar *data, qint64 length, quint64 seed)
+{
+    StreamHash hash(seed);
+    hash.add(data, length);
+    return hash.result();
+}
+
+} // namespace Checksum
@@ -0,0 +1,39 @@
+#ifndef CHECKSUM_H
+#define CHECKSUM_H
+
+#include <QByteArray>
+#include <QtGlobal>
+
+// Checksums for the app's own on-disk formats (icon cache, layout journal)
+// and for verifying copied files
+namespace Checksum {
+
+// CRC-32 (IEEE 802.3, as used by zlib/PNG)
+quint32 crc32(const uchar *data, qint64 length);
+quint32 crc32(const QByteArray &data);
+
+// 64-bit XXH64, fed in chunks of any size. Four independent lanes of
+// multiply/rotate per 32 bytes; several GB/s per core, far above what the
+// disks being verified deliver. Not cryptographic.
+class StreamHash
+{
+public:
+    explicit StreamHash(quint64 seed = 0);
+
+    void add(const uchar *data, qint64 length);
+    void add(const QByteArray &data);
+    quint64 result() const;
+
+private:
+    quint64 seed;
+    quint64 lanes[4];
+    uchar buffer[32];
+    int buffered = 0;
+    quint64 totalLength = 0;
+};
+
+quint64 hash64(const uchar *data, qint64 length, quint64 seed = 0);
+
+} // namespace Checksum
+
+#endif // CHECKSUM_H
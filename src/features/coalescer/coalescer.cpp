@@ -0,0 +1,59 @@
+#include "coalescer.h"
+
+ChangeCoalescer::ChangeCoalescer(QObject *parent, int quietMs, int maxLatencyMs)
+    : QObject(parent)
+    , quietMs(quietMs)
+    , maxLatencyMs(qMax(quietMs, maxLatencyMs))
+    , pending(false)
+    , rawEvents(0)
+    , triggers(0)
+{
+    quietTimer.setSingleShot(true);
+    deadlineTimer.setSingleShot(true);
+    connect(&quietTimer, &QTimer::timeout, this, &ChangeCoalescer::fire);
+    connect(&deadlineTimer, &QTimer::timeout, this, &ChangeCoalescer::fire);
+}
+
+void ChangeCoalescer::setQuietPeriod(int ms)
+{
+    quietMs = qMax(0, ms);
+    maxLatencyMs = qMax(quietMs, maxLatencyMs);
+}
+
+void ChangeCoalescer::setMaxLatency(int ms)
+{
+    maxLatencyMs = qMax(quietMs, ms);
+}
+
+void ChangeCoalescer::notify()
+{
+    ++rawEvents;
+    pending = true;
+
+    // Each event pushes the quiet deadline back...
+    quietTimer.start(quietMs);
+
+    // ...but the hard deadline is only armed by the first event of a burst
+    if (!deadlineTimer.isActive()) {
+        deadlineTimer.start(maxLatencyMs);
+    }
+}
+
+void ChangeCoalescer::flush()
+{
+    if (pending) {
+        fire();
+    }
+}
+
+void ChangeCoalescer::fire()
+{
+    quietTimer.stop();
+    deadlineTimer.stop();
+    if (!pending) {
+        return;
+    }
+    pending = false;
+    ++triggers;
+    emit triggered();
+}
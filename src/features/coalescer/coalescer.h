@@ -0,0 +1,56 @@
+#ifndef COALESCER_H
+#define COALESCER_H
+
+#include <QObject>
+#include <QTimer>
+
+// Merges bursts of change notifications into a single refresh.
+// triggered() fires once the source has been quiet for quietPeriod ms, but
+// never later than maxLatency ms after the first unhandled notification, so
+// a continuous stream of events still refreshes at a bounded interval.
+class ChangeCoalescer : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int DEFAULT_QUIET_MS = 150;
+    static constexpr int DEFAULT_MAX_LATENCY_MS = 1000;
+
+    explicit ChangeCoalescer(QObject *parent = nullptr,
+                             int quietMs = DEFAULT_QUIET_MS,
+                             int maxLatencyMs = DEFAULT_MAX_LATENCY_MS);
+
+    int quietPeriod() const { return quietMs; }
+    void setQuietPeriod(int ms);
+
+    int maxLatency() const { return maxLatencyMs; }
+    void setMaxLatency(int ms);
+
+    bool isPending() const { return pending; }
+
+    // Counters: raw notifications received vs. refreshes actually triggered
+    quint64 rawEventCount() const { return rawEvents; }
+    quint64 triggerCount() const { return triggers; }
+
+public slots:
+    // Record one raw change notification
+    void notify();
+    // Trigger immediately if anything is pending
+    void flush();
+
+signals:
+    void triggered();
+
+private:
+    void fire();
+
+    QTimer quietTimer;
+    QTimer deadlineTimer;
+    int quietMs;
+    int maxLatencyMs;
+    bool pending;
+    quint64 rawEvents;
+    quint64 triggers;
+};
+
+#endif // COALESCER_H
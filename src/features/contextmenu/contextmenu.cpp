@@ -1,46 +1,47 @@
 #include "contextmenu.h"
 #include "../fileops/fileops.h"
-#include <QListWidget>
-#include <QListWidgetItem>
+#include "../filemodel/filemodel.h"
+#include <QAbstractItemView>
+#include <QItemSelectionModel>
 #include <QMenu>
 #include <QAction>
 #include <QObject>
 
-static const char *MENU_STYLE =
-    "QMenu { "
-    "  background-color: rgba(40, 40, 40, 240); "
-    "  color: white; "
-    "  border: 1px solid rgba(255, 255, 255, 50); "
-    "  border-radius: 5px; "
-    "  padding: 5px; "
-    "}"
-    "QMenu::item { "
-    "  padding: 5px 20px; "
-    "  border-radius: 3px; "
-    "}"
-    "QMenu::item:selected { "
-    "  background-color: rgba(255, 255, 255, 80); "
-    "}";
-
+// Styled by the application stylesheet (features/theme)
 static QMenu *makeMenu(QWidget *parent)
 {
     QMenu *menu = new QMenu(parent);
-    menu->setStyleSheet(MENU_STYLE);
+    menu->setObjectName("zoneMenu");
     return menu;
 }
 
-void ContextMenuBuilder::show(QListWidget *fileList, const QPoint &pos,
+// The selected items if the clicked one is among them, else just that one
+static QStringList targetPaths(QAbstractItemView *fileList, const QString &clickedPath)
+{
+    QStringList paths;
+    if (QItemSelectionModel *selection = fileList->selectionModel()) {
+        for (const QModelIndex &index : selection->selectedIndexes()) {
+            paths.append(index.data(ZoneFileModel::PathRole).toString());
+        }
+    }
+    if (!paths.contains(clickedPath)) {
+        paths = QStringList{ clickedPath };
+    }
+    return paths;
+}
+
+void ContextMenuBuilder::show(QAbstractItemView *fileList, const QPoint &pos,
                               const QString &zoneFolderPath, const QString &zoneName,
                               QWidget *parent,
                               std::function<void()> onRefresh,
                               std::function<void(const QString &newFolderPath)> onRenamed)
 {
-    QListWidgetItem *item = fileList->itemAt(pos);
+    QModelIndex index = fileList->indexAt(pos);
 
-    if (item) {
-        const QString filePath = item->data(Qt::UserRole).toString();
+    if (index.isValid()) {
+        const QString filePath = index.data(ZoneFileModel::PathRole).toString();
         showFileMenu(filePath, zoneFolderPath, zoneName,
-                     fileList, pos, parent, onRefresh, onRenamed);
+                     fileList, pos, parent, onRenamed);
     } else {
         showBlankMenu(zoneFolderPath, zoneName,
                       fileList, pos, parent, onRefresh, onRenamed);
@@ -49,19 +50,22 @@ void ContextMenuBuilder::show(QListWidget *fileList, const QPoint &pos,
 
 void ContextMenuBuilder::showFileMenu(const QString &filePath,
                                       const QString &zoneFolderPath, const QString &zoneName,
-                                      QListWidget *fileList, const QPoint &pos,
+                                      QAbstractItemView *fileList, const QPoint &pos,
                                       QWidget *parent,
-                                      std::function<void()> onRefresh,
                                       std::function<void(const QString &newFolderPath)> onRenamed)
 {
     QMenu *menu = makeMenu(parent);
+    const QStringList selectedPaths = targetPaths(fileList, filePath);
 
     QAction *openAction     = menu->addAction(QObject::tr("打开"));
     QAction *copyPathAction = menu->addAction(QObject::tr("复制路径"));
     menu->addSeparator();
     QAction *renameZoneAction = menu->addAction(QObject::tr("重命名区域"));
     menu->addSeparator();
-    QAction *deleteAction   = menu->addAction(QObject::tr("删除"));
+    QAction *deleteAction   = menu->addAction(selectedPaths.size() > 1
+        ? QObject::tr("删除 %1 项").arg(selectedPaths.size())
+        : QObject::tr("删除"));
+    QAction *purgeAction    = menu->addAction(QObject::tr("永久删除"));
 
     QObject::connect(openAction, &QAction::triggered, [filePath, parent]() {
         FileOpsHandler::openFile(filePath, parent);
@@ -73,8 +77,11 @@ void ContextMenuBuilder::showFileMenu(const QString &filePath,
                      [zoneFolderPath, zoneName, parent, onRenamed]() {
         FileOpsHandler::renameFolder(zoneFolderPath, zoneName, parent, onRenamed);
     });
-    QObject::connect(deleteAction, &QAction::triggered, [filePath, parent, onRefresh]() {
-        FileOpsHandler::deleteFile(filePath, parent, onRefresh);
+    QObject::connect(deleteAction, &QAction::triggered, [selectedPaths, parent]() {
+        FileOpsHandler::deleteFiles(selectedPaths, parent);
+    });
+    QObject::connect(purgeAction, &QAction::triggered, [selectedPaths, parent]() {
+        FileOpsHandler::deleteFiles(selectedPaths, parent, true);
     });
 
     menu->exec(fileList->mapToGlobal(pos));
@@ -82,7 +89,7 @@ void ContextMenuBuilder::showFileMenu(const QString &filePath,
 }
 
 void ContextMenuBuilder::showBlankMenu(const QString &zoneFolderPath, const QString &zoneName,
-                                       QListWidget *fileList, const QPoint &pos,
+                                       QAbstractItemView *fileList, const QPoint &pos,
                                        QWidget *parent,
                                        std::function<void()> onRefresh,
                                        std::function<void(const QString &newFolderPath)> onRenamed)
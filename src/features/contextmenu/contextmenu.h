@@ -4,20 +4,23 @@
 #include <QPoint>
 #include <functional>
 
-class QListWidget;
+class QAbstractItemView;
 class QWidget;
 
 // Builds and shows the right-click context menu for the file list.
-// - Click on a file/folder: file operations menu (open, copy path, delete)
+// - Click on a file/folder: file operations menu (open, copy path, delete to
+//   the trash, delete permanently; deleting applies to the whole selection
+//   if the item is part of it)
 // - Click on empty space:   create menu (new file, new folder) + zone rename
 // Delegates actual file operations to FileOpsHandler.
 class ContextMenuBuilder
 {
 public:
     // Show context menu at pos (in fileList local coordinates).
-    // onRefresh: called after any operation that modifies the file list.
+    // onRefresh: called after a file or folder was created (deletions are
+    // picked up from DeleteQueue by the zone itself).
     // onRenamed(newFolderPath): called after zone folder rename.
-    static void show(QListWidget *fileList, const QPoint &pos,
+    static void show(QAbstractItemView *fileList, const QPoint &pos,
                      const QString &zoneFolderPath, const QString &zoneName,
                      QWidget *parent,
                      std::function<void()> onRefresh,
@@ -26,13 +29,12 @@ public:
 private:
     static void showFileMenu(const QString &filePath,
                              const QString &zoneFolderPath, const QString &zoneName,
-                             QListWidget *fileList, const QPoint &pos,
+                             QAbstractItemView *fileList, const QPoint &pos,
                              QWidget *parent,
-                             std::function<void()> onRefresh,
                              std::function<void(const QString &newFolderPath)> onRenamed);
 
     static void showBlankMenu(const QString &zoneFolderPath, const QString &zoneName,
-                              QListWidget *fileList, const QPoint &pos,
+                              QAbstractItemView *fileList, const QPoint &pos,
                               QWidget *parent,
                               std::function<void()> onRefresh,
                               std::function<void(const QString &newFolderPath)> onRenamed);
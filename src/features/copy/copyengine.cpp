@@ -0,0 +1,567 @@
+#include "copyengine.h"
+#include <QByteArray>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <atomic>
+#include <thread>
+#include "../checksum/checksum.h"
+
+#if defined(Q_OS_LINUX)
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifndef FICLONE
+#define FICLONE _IOW(0x94, 9, int)
+#endif
+#elif defined(Q_OS_WIN)
+#include <windows.h>
+#endif
+
+namespace {
+
+bool reportProgress(const CopyEngine::ProgressCallback &progress, qint64 bytes,
+                    CopyEngine::Result &result)
+{
+    if (progress && !progress(bytes)) {
+        result.cancelled = true;
+        result.error = QStringLiteral("cancelled");
+        return false;
+    }
+    return true;
+}
+
+#if !defined(Q_OS_LINUX)
+// Portable fallback: QFile loop, then permissions and modification time
+void copyWithQFile(const QString &source, const QString &target,
+                   const CopyEngine::ProgressCallback &progress, Checksum::StreamHash *hash,
+                   CopyEngine::Result &result)
+{
+    result.method = CopyEngine::ReadWrite;
+
+    QFile in(source);
+    QFile out(target);
+    if (!in.open(QIODevice::ReadOnly)) {
+        result.error = in.errorString();
+        return;
+    }
+    if (!out.open(QIODevice::WriteOnly | QIODevice::NewOnly)) {
+        result.error = out.errorString();
+        return;
+    }
+
+    QByteArray buffer(int(CopyEngine::BUFFER_SIZE), Qt::Uninitialized);
+    for (;;) {
+        const qint64 n = in.read(buffer.data(), buffer.size());
+        if (n < 0) {
+            result.error = in.errorString();
+            break;
+        }
+        if (n == 0) {
+            result.ok = true;
+            break;
+        }
+        if (out.write(buffer.constData(), n) != n) {
+            result.error = out.errorString();
+            break;
+        }
+        if (hash) {
+            hash->add(reinterpret_cast<const uchar *>(buffer.constData()), n);
+        }
+        result.bytes += n;
+        if (!reportProgress(progress, n, result)) {
+            break;
+        }
+    }
+
+    if (result.ok) {
+        out.setPermissions(in.permissions());
+        result.ok = out.flush()
+            && out.setFileTime(QFileInfo(in).lastModified(), QFileDevice::FileModificationTime);
+    }
+    if (result.ok && hash) {
+        result.hashed = true;
+        result.sourceHash = hash->result();
+    }
+    out.close();
+    if (!result.ok) {
+        out.remove();
+    }
+}
+#endif
+
+#if defined(Q_OS_LINUX)
+
+// One file copy on Linux; methods that turn out to be unsupported for this
+// pair of files are dropped from `active` and the next one continues
+class LinuxCopy
+{
+public:
+    // With hash, only the read/write loop may be among methods; it hashes
+    // what it copies, and skipped holes as zeros
+    LinuxCopy(int in, int out, int methods, const CopyEngine::ProgressCallback &progress,
+              Checksum::StreamHash *hash, CopyEngine::Result &result)
+        : in(in), out(out), active(methods), progress(progress), hash(hash), result(result)
+    {
+    }
+
+    bool reflink(qint64 size)
+    {
+        if (!(active & CopyEngine::Reflink) || ::ioctl(out, FICLONE, in) != 0) {
+            return false;
+        }
+        result.method = CopyEngine::Reflink;
+        return reportProgress(progress, size, result);
+    }
+
+    // Copy only the data ranges of the source; holes stay holes
+    bool copySparse(qint64 size)
+    {
+        qint64 offset = 0;
+        while (offset < size) {
+            off_t data = ::lseek(in, offset, SEEK_DATA);
+            off_t hole = size;
+            if (data < 0) {
+                if (errno == ENXIO) {
+                    break;   // only a hole is left
+                }
+                data = offset;   // no SEEK_DATA support: all data
+            } else {
+                hole = ::lseek(in, data, SEEK_HOLE);
+                if (hole < 0) {
+                    hole = size;
+                }
+            }
+            // Skipped holes count as copied, so progress adds up to the size
+            if (data > offset) {
+                hashZeros(data - offset);
+                if (!reportProgress(progress, data - offset, result)) {
+                    return false;
+                }
+            }
+            if (!copyRange(data, qMin<qint64>(hole, size))) {
+                return false;
+            }
+            offset = hole;
+        }
+        if (offset < size) {
+            hashZeros(size - offset);
+            if (!reportProgress(progress, size - offset, result)) {
+                return false;
+            }
+        }
+        // Sets the size, including a trailing hole
+        if (::ftruncate(out, size) != 0) {
+            return fail();
+        }
+        return true;
+    }
+
+private:
+    // Copy [offset, end) of in to the same offset of out
+    bool copyRange(qint64 offset, qint64 end)
+    {
+        while (offset < end) {
+            const qint64 length = qMin(CopyEngine::CHUNK_SIZE, end - offset);
+            ssize_t n;
+            CopyEngine::Method method;
+
+            if (active & CopyEngine::CopyFileRange) {
+                method = CopyEngine::CopyFileRange;
+                loff_t inOffset = offset;
+                loff_t outOffset = offset;
+                n = ::copy_file_range(in, &inOffset, out, &outOffset, size_t(length), 0);
+                if (n < 0 && (errno == EXDEV || errno == ENOSYS || errno == EOPNOTSUPP
+                              || errno == EINVAL || errno == EBADF)) {
+                    active &= ~CopyEngine::CopyFileRange;
+                    continue;
+                }
+            } else if (active & CopyEngine::SendFile) {
+                method = CopyEngine::SendFile;
+                // sendfile writes at the current position of out
+                if (::lseek(out, offset, SEEK_SET) < 0) {
+                    return fail();
+                }
+                off_t inOffset = offset;
+                n = ::sendfile(out, in, &inOffset, size_t(length));
+                if (n < 0 && (errno == EINVAL || errno == ENOSYS || errno == EOPNOTSUPP)) {
+                    active &= ~CopyEngine::SendFile;
+                    continue;
+                }
+            } else if (active & CopyEngine::ReadWrite) {
+                method = CopyEngine::ReadWrite;
+                n = readWrite(offset, qMin(length, CopyEngine::BUFFER_SIZE));
+            } else {
+                result.error = QStringLiteral("no copy method available");
+                return false;
+            }
+
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return fail();
+            }
+            if (n == 0) {
+                // copy_file_range and sendfile can return 0 before the end on
+                // some file systems; only pread() is trusted to mean EOF, and
+                // then the source got shorter while copying
+                if (method != CopyEngine::ReadWrite) {
+                    active &= ~method;
+                    continue;
+                }
+                result.error = QStringLiteral("source changed while copying");
+                return false;
+            }
+
+            offset += n;
+            result.method = method;
+            if (!reportProgress(progress, n, result)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    ssize_t readWrite(qint64 offset, qint64 length)
+    {
+        if (buffer.isEmpty()) {
+            buffer.resize(int(CopyEngine::BUFFER_SIZE));
+        }
+        const ssize_t n = ::pread(in, buffer.data(), size_t(length), offset);
+        if (n <= 0) {
+            return n;
+        }
+        if (hash) {
+            hash->add(reinterpret_cast<const uchar *>(buffer.constData()), n);
+        }
+        ssize_t written = 0;
+        while (written < n) {
+            const ssize_t w = ::pwrite(out, buffer.constData() + written, size_t(n - written),
+                                       offset + written);
+            if (w < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return -1;
+            }
+            written += w;
+        }
+        return n;
+    }
+
+    // A hole reads back as zeros, so that is what the target will hash to
+    void hashZeros(qint64 length)
+    {
+        if (!hash) {
+            return;
+        }
+        if (zeros.isEmpty()) {
+            zeros = QByteArray(int(CopyEngine::BUFFER_SIZE), '\0');
+        }
+        while (length > 0) {
+            const qint64 n = qMin<qint64>(length, zeros.size());
+            hash->add(reinterpret_cast<const uchar *>(zeros.constData()), n);
+            length -= n;
+        }
+    }
+
+    bool fail()
+    {
+        result.error = QString::fromLocal8Bit(std::strerror(errno));
+        return false;
+    }
+
+    int in;
+    int out;
+    int active;
+    const CopyEngine::ProgressCallback &progress;
+    Checksum::StreamHash *hash;
+    CopyEngine::Result &result;
+    QByteArray buffer;
+    QByteArray zeros;
+};
+
+void copyOnLinux(const QString &source, const QString &target, int methods,
+                 const CopyEngine::ProgressCallback &progress, Checksum::StreamHash *hash,
+                 CopyEngine::Result &result)
+{
+    const QByteArray sourcePath = QFile::encodeName(source);
+    const QByteArray targetPath = QFile::encodeName(target);
+
+    const int in = ::open(sourcePath.constData(), O_RDONLY | O_CLOEXEC);
+    if (in < 0) {
+        result.error = QString::fromLocal8Bit(std::strerror(errno));
+        return;
+    }
+    struct stat st;
+    if (::fstat(in, &st) != 0 || !S_ISREG(st.st_mode)) {
+        result.error = QStringLiteral("not a regular file");
+        ::close(in);
+        return;
+    }
+    // Owner-only until the copy is complete
+    const int out = ::open(targetPath.constData(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    if (out < 0) {
+        result.error = QString::fromLocal8Bit(std::strerror(errno));
+        ::close(in);
+        return;
+    }
+
+    LinuxCopy copy(in, out, methods, progress, hash, result);
+    const qint64 size = st.st_size;
+    const bool cloned = copy.reflink(size);
+    result.ok = cloned || (!result.cancelled && copy.copySparse(size));
+    if (result.ok && hash && !cloned) {
+        result.hashed = true;
+        result.sourceHash = hash->result();
+    }
+
+    if (result.ok) {
+        const struct timespec times[2] = { st.st_atim, st.st_mtim };
+        if (::fchmod(out, st.st_mode & 07777) != 0 || ::futimens(out, times) != 0) {
+            result.ok = false;
+            result.error = QString::fromLocal8Bit(std::strerror(errno));
+        }
+        result.bytes = size;
+    }
+    if (::close(out) != 0 && result.ok) {
+        result.ok = false;
+        result.error = QString::fromLocal8Bit(std::strerror(errno));
+    }
+    ::close(in);
+    if (!result.ok) {
+        ::unlink(targetPath.constData());
+    }
+}
+
+#elif defined(Q_OS_WIN)
+
+struct WinProgress
+{
+    const CopyEngine::ProgressCallback *progress;
+    CopyEngine::Result *result;
+    qint64 reported;
+};
+
+DWORD CALLBACK onCopyProgress(LARGE_INTEGER, LARGE_INTEGER transferred, LARGE_INTEGER,
+                              LARGE_INTEGER, DWORD, DWORD, HANDLE, HANDLE, LPVOID data)
+{
+    WinProgress *state = static_cast<WinProgress *>(data);
+    const qint64 delta = transferred.QuadPart - state->reported;
+    state->reported = transferred.QuadPart;
+    if (delta > 0 && !reportProgress(*state->progress, delta, *state->result)) {
+        return PROGRESS_CANCEL;
+    }
+    return PROGRESS_CONTINUE;
+}
+
+// CopyFileExW copies in the kernel (and server-side on SMB) and keeps
+// attributes and timestamps; a cancelled copy is deleted by it
+void copyOnWindows(const QString &source, const QString &target,
+                   const CopyEngine::ProgressCallback &progress, CopyEngine::Result &result)
+{
+    result.method = CopyEngine::SystemCopy;
+    WinProgress state{ &progress, &result, 0 };
+    const QString from = QDir::toNativeSeparators(source);
+    const QString to = QDir::toNativeSeparators(target);
+    if (CopyFileExW(reinterpret_cast<LPCWSTR>(from.utf16()), reinterpret_cast<LPCWSTR>(to.utf16()),
+                    onCopyProgress, &state, nullptr, COPY_FILE_FAIL_IF_EXISTS)) {
+        result.ok = true;
+        result.bytes = state.reported;
+    } else if (!result.cancelled) {
+        result.error = QStringLiteral("CopyFileExW failed (error %1)").arg(GetLastError());
+    }
+}
+
+#endif
+
+// Hash the whole file at path; onChunk gets the bytes of each chunk and
+// returns false to stop. With dropCache the file's cached pages are written
+// out and evicted first.
+bool hashFile(const QString &path, bool dropCache, const std::function<bool(qint64)> &onChunk,
+              quint64 &hash, QString &error)
+{
+    Checksum::StreamHash stream;
+    QByteArray buffer(int(CopyEngine::BUFFER_SIZE), Qt::Uninitialized);
+    bool ok = true;
+
+#if defined(Q_OS_LINUX)
+    const QByteArray encodedPath = QFile::encodeName(path);
+    const int fd = ::open(encodedPath.constData(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        error = QString::fromLocal8Bit(std::strerror(errno));
+        return false;
+    }
+    if (dropCache) {
+        // Dirty pages are not dropped, so write them out first
+        ::fdatasync(fd);
+        ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    }
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    qint64 offset = 0;
+    for (;;) {
+        const ssize_t n = ::pread(fd, buffer.data(), size_t(buffer.size()), offset);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            error = QString::fromLocal8Bit(std::strerror(errno));
+            ok = false;
+            break;
+        }
+        if (n == 0) {
+            break;
+        }
+        offset += n;
+        // The device reads the next chunk while this one is hashed
+        ::posix_fadvise(fd, offset, CopyEngine::BUFFER_SIZE, POSIX_FADV_WILLNEED);
+        stream.add(reinterpret_cast<const uchar *>(buffer.constData()), n);
+        if (onChunk && !onChunk(n)) {
+            ok = false;
+            break;
+        }
+    }
+    ::close(fd);
+#else
+    // No portable way to bypass the cache; the target may be read from memory
+    Q_UNUSED(dropCache);
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        error = file.errorString();
+        return false;
+    }
+    for (;;) {
+        const qint64 n = file.read(buffer.data(), buffer.size());
+        if (n < 0) {
+            error = file.errorString();
+            ok = false;
+            break;
+        }
+        if (n == 0) {
+            break;
+        }
+        stream.add(reinterpret_cast<const uchar *>(buffer.constData()), n);
+        if (onChunk && !onChunk(n)) {
+            ok = false;
+            break;
+        }
+    }
+#endif
+
+    hash = stream.result();
+    return ok;
+}
+
+} // namespace
+
+CopyEngine::Result CopyEngine::copyFile(const QString &source, const QString &target,
+                                        const ProgressCallback &progress, int methods,
+                                        bool hashSource)
+{
+    Result result;
+    Checksum::StreamHash stream;
+    Checksum::StreamHash *hash = hashSource ? &stream : nullptr;
+#if defined(Q_OS_LINUX)
+    if (hashSource) {
+        // The kernel-side methods never show the bytes to hash
+        methods &= Reflink | ReadWrite;
+    }
+    copyOnLinux(source, target, methods, progress, hash, result);
+#elif defined(Q_OS_WIN)
+    if ((methods & SystemCopy) && !hashSource) {
+        copyOnWindows(source, target, progress, result);
+    } else {
+        copyWithQFile(source, target, progress, hash, result);
+    }
+#else
+    Q_UNUSED(methods);
+    copyWithQFile(source, target, progress, hash, result);
+#endif
+    return result;
+}
+
+CopyEngine::Result CopyEngine::verify(const QString &source, const QString &target,
+                                      const ProgressCallback &progress)
+{
+    Result result;
+    std::atomic_bool stop{false};
+
+    quint64 targetHash = 0;
+    QString targetError;
+    bool targetOk = false;
+    std::thread targetReader([&]() {
+        targetOk = hashFile(target, true, [&stop](qint64) {
+            return !stop.load(std::memory_order_relaxed);
+        }, targetHash, targetError);
+    });
+
+    quint64 sourceHash = 0;
+    QString sourceError;
+    const bool sourceOk = hashFile(source, false, [&](qint64 bytes) {
+        result.bytes += bytes;
+        return reportProgress(progress, bytes, result);
+    }, sourceHash, sourceError);
+    if (!sourceOk) {
+        // No use reading the rest of the target
+        stop.store(true);
+    }
+    targetReader.join();
+
+    if (result.cancelled) {
+        return result;
+    }
+    if (!sourceOk || !targetOk) {
+        result.error = !sourceOk ? sourceError : targetError;
+        return result;
+    }
+    result.ok = sourceHash == targetHash;
+    if (!result.ok) {
+        result.error = QStringLiteral("contents differ");
+    }
+    return result;
+}
+
+CopyEngine::Result CopyEngine::verifyTarget(const QString &target, quint64 sourceHash,
+                                            const ProgressCallback &progress)
+{
+    Result result;
+    quint64 targetHash = 0;
+    QString error;
+    const bool ok = hashFile(target, true, [&](qint64 bytes) {
+        result.bytes += bytes;
+        return reportProgress(progress, bytes, result);
+    }, targetHash, error);
+
+    if (result.cancelled) {
+        return result;
+    }
+    if (!ok) {
+        result.error = error;
+        return result;
+    }
+    result.ok = targetHash == sourceHash;
+    if (!result.ok) {
+        result.error = QStringLiteral("contents differ");
+    }
+    return result;
+}
+
+const char *CopyEngine::methodName(Method method)
+{
+    switch (method) {
+    case Reflink:       return "reflink";
+    case CopyFileRange: return "copy_file_range";
+    case SendFile:      return "sendfile";
+    case ReadWrite:     return "read/write";
+    case SystemCopy:    return "CopyFileEx";
+    default:            return "?";
+    }
+}
@@ -0,0 +1,72 @@
+#ifndef COPYENGINE_H
+#define COPYENGINE_H
+
+#include <QString>
+#include <functional>
+
+// Copies one regular file, letting the kernel move the bytes where it can.
+// On Linux the methods are tried in order: a FICLONE reflink (shares extents
+// on btrfs/xfs, no data is copied), copy_file_range, sendfile, and finally a
+// pread/pwrite loop with a large buffer. Each later method takes over where
+// the previous one stopped being supported. Holes in sparse files are kept
+// (only data ranges are copied), as are permissions and timestamps.
+// On Windows the copy is done by CopyFileExW; elsewhere by the plain loop.
+// verify() compares a finished copy with its source by content hash. For a
+// copy that is verified right away, copyFile() can hash the source while
+// copying instead (read/write loop only, as the kernel-side methods never
+// show the bytes), so that verifyTarget() only has to read the copy back.
+class CopyEngine
+{
+public:
+    enum Method {
+        Reflink       = 0x01,
+        CopyFileRange = 0x02,
+        SendFile      = 0x04,
+        ReadWrite     = 0x08,
+        SystemCopy    = 0x10,   // CopyFileExW
+        AllMethods    = 0xff
+    };
+
+    // Called with the bytes copied since the last call; return false to cancel
+    using ProgressCallback = std::function<bool(qint64 bytes)>;
+
+    struct Result
+    {
+        bool ok = false;
+        bool cancelled = false;
+        Method method = ReadWrite;   // the method that copied the data
+        qint64 bytes = 0;            // logical size of the copy
+        bool hashed = false;         // sourceHash is set (not for a reflink)
+        quint64 sourceHash = 0;      // XXH64 of the bytes copied, holes as zeros
+        QString error;
+    };
+
+    static constexpr qint64 CHUNK_SIZE = 8 * 1024 * 1024;   // between progress calls
+    static constexpr qint64 BUFFER_SIZE = 1024 * 1024;      // read/write loop
+
+    // Copy source to target, which must not exist yet. `methods` limits the
+    // methods tried (benchmarks); the target is removed again on failure.
+    // With hashSource only a reflink or the read/write loop is used, and the
+    // data is hashed as it is written (see Result::sourceHash).
+    static Result copyFile(const QString &source, const QString &target,
+                           const ProgressCallback &progress = ProgressCallback(),
+                           int methods = AllMethods, bool hashSource = false);
+
+    // Compare target with source by XXH64 of their contents; ok when they
+    // match, error says why not. The target is flushed and, on Linux, evicted
+    // from the page cache first, so it is read back from the device rather
+    // than from the pages just written. Both files are read at the same time
+    // (the target on a helper thread) and the next chunk is prefetched while
+    // the current one is hashed. `progress` gets the source bytes hashed.
+    static Result verify(const QString &source, const QString &target,
+                         const ProgressCallback &progress = ProgressCallback());
+
+    // Like verify(), against the sourceHash of a hashed copyFile(): only the
+    // target is read. `progress` gets the target bytes hashed.
+    static Result verifyTarget(const QString &target, quint64 sourceHash,
+                               const ProgressCallback &progress = ProgressCallback());
+
+    static const char *methodName(Method method);
+};
+
+#endif // COPYENGINE_H
@@ -0,0 +1,177 @@
+#include "itemdelegate.h"
+#include "../filemodel/filemodel.h"
+#include <QListView>
+#include <QPainter>
+#include <QPixmap>
+#include <QTextLayout>
+
+// Same colors as the former QListView::item stylesheet rules
+ZoneItemDelegate::ZoneItemDelegate(QObject *parent)
+    : QStyledItemDelegate(parent)
+    , selectedBrush(QColor(255, 255, 255, 80))
+    , hoverBrush(QColor(255, 255, 255, 40))
+    , textColor(Qt::white)
+    , textCache(TEXT_CACHE_SIZE)
+{
+}
+
+void ZoneItemDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option,
+                             const QModelIndex &index) const
+{
+    if (option.state & QStyle::State_Selected) {
+        painter->fillRect(option.rect, selectedBrush);
+    } else if ((option.state & QStyle::State_MouseOver) && (option.state & QStyle::State_Enabled)) {
+        painter->fillRect(option.rect, hoverBrush);
+    }
+
+    // Items still being moved into the folder are drawn faded
+    const bool pending = index.data(ZoneFileModel::PendingRole).toBool();
+    if (pending) {
+        painter->save();
+        painter->setOpacity(PENDING_OPACITY);
+    }
+
+    const QRect content = option.rect.adjusted(PADDING, PADDING, -PADDING, -PADDING);
+    const QSize iconSize = option.decorationSize;
+    const bool iconOnTop = option.decorationPosition == QStyleOptionViewItem::Top;
+
+    QRect iconRect;
+    QRect textRect;
+    if (iconOnTop) {
+        iconRect = QRect(content.left() + (content.width() - iconSize.width()) / 2, content.top(),
+                         iconSize.width(), iconSize.height());
+        textRect = content.adjusted(0, iconSize.height() + ICON_SPACING / 2, 0, 0);
+    } else {
+        iconRect = QRect(content.left(), content.top() + (content.height() - iconSize.height()) / 2,
+                         iconSize.width(), iconSize.height());
+        textRect = content.adjusted(iconSize.width() + ICON_SPACING, 0, 0, 0);
+    }
+
+    // The model hands out pixmaps already scaled for the screen
+    const QPixmap pixmap = index.data(Qt::DecorationRole).value<QPixmap>();
+    if (!pixmap.isNull()) {
+        const QSizeF logical = QSizeF(pixmap.size()) / pixmap.devicePixelRatio();
+        const QSize drawn = logical.toSize().scaled(iconSize, Qt::KeepAspectRatio).boundedTo(iconSize);
+        const QRect target(iconRect.left() + (iconRect.width() - drawn.width()) / 2,
+                           iconRect.top() + (iconRect.height() - drawn.height()) / 2,
+                           drawn.width(), drawn.height());
+        painter->drawPixmap(target, pixmap);
+    }
+
+    const QString name = index.data(Qt::DisplayRole).toString();
+    if (!name.isEmpty() && textRect.width() > 0) {
+        paintName(painter, option, name, textRect, iconOnTop);
+    }
+
+    if (pending) {
+        painter->restore();
+    }
+}
+
+void ZoneItemDelegate::paintName(QPainter *painter, const QStyleOptionViewItem &option,
+                                 const QString &name, const QRect &textRect, bool iconOnTop) const
+{
+    const QFontMetrics metrics(option.font);
+    const int lineHeight = metrics.lineSpacing();
+    const int maxLines = iconOnTop ? qMax(1, textRect.height() / lineHeight) : 1;
+    const TextBlock *block = textBlock(name, option.font, textRect.width(), maxLines,
+                                       option.textElideMode);
+    if (!block) {
+        return;
+    }
+
+    painter->save();
+    painter->setFont(option.font);
+    painter->setPen(textColor);
+
+    qreal y = iconOnTop
+        ? textRect.top()
+        : textRect.top() + (textRect.height() - lineHeight) / 2.0;
+    for (int i = 0; i < block->lines.size(); ++i) {
+        const qreal x = iconOnTop
+            ? textRect.left() + (textRect.width() - block->widths.at(i)) / 2
+            : textRect.left();
+        painter->drawStaticText(QPointF(x, y), block->lines.at(i));
+        y += lineHeight;
+    }
+    painter->restore();
+}
+
+QSize ZoneItemDelegate::sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const
+{
+    const QSize iconSize = option.decorationSize;
+
+    if (option.decorationPosition == QStyleOptionViewItem::Top) {
+        // Icon mode: fill the grid cell the view lays items out in
+        const QListView *view = qobject_cast<const QListView *>(option.widget);
+        if (view && view->gridSize().isValid()) {
+            const int spacing = view->spacing();
+            return view->gridSize() - QSize(spacing, spacing);
+        }
+        const QFontMetrics metrics(option.font);
+        return QSize(iconSize.width() * 3 / 2, iconSize.height() + ICON_SPACING / 2 + 2 * metrics.lineSpacing())
+            + QSize(2 * PADDING, 2 * PADDING);
+    }
+
+    const QFontMetrics metrics(option.font);
+    const QString name = index.data(Qt::DisplayRole).toString();
+    return QSize(iconSize.width() + ICON_SPACING + metrics.horizontalAdvance(name),
+                 qMax(iconSize.height(), metrics.height()))
+        + QSize(2 * PADDING, 2 * PADDING);
+}
+
+const ZoneItemDelegate::TextBlock *ZoneItemDelegate::textBlock(const QString &text, const QFont &font,
+                                                               int width, int maxLines,
+                                                               Qt::TextElideMode elide) const
+{
+    if (font != cachedFont) {
+        textCache.clear();
+        cachedFont = font;
+    }
+
+    const QString key = QString::number(width) + QLatin1Char('/') + QString::number(maxLines)
+        + QLatin1Char('/') + QString::number(int(elide)) + QLatin1Char('/') + text;
+    if (const TextBlock *cached = textCache.object(key)) {
+        return cached;
+    }
+
+    const QFontMetrics metrics(font);
+    QStringList lines;
+
+    if (maxLines <= 1) {
+        lines << metrics.elidedText(text, elide, width);
+    } else {
+        // Wrap at word boundaries (anywhere for long names without spaces);
+        // whatever does not fit in maxLines is elided on the last line
+        QTextLayout layout(text, font);
+        QTextOption textOption;
+        textOption.setWrapMode(QTextOption::WrapAtWordBoundaryOrAnywhere);
+        layout.setTextOption(textOption);
+        layout.beginLayout();
+        while (lines.size() < maxLines) {
+            QTextLine line = layout.createLine();
+            if (!line.isValid()) {
+                break;
+            }
+            line.setLineWidth(width);
+            if (lines.size() == maxLines - 1) {
+                lines << metrics.elidedText(text.mid(line.textStart()), elide, width);
+            } else {
+                lines << text.mid(line.textStart(), line.textLength()).trimmed();
+            }
+        }
+        layout.endLayout();
+    }
+
+    TextBlock *block = new TextBlock;
+    for (const QString &line : lines) {
+        QStaticText staticText(line);
+        staticText.setTextFormat(Qt::PlainText);
+        staticText.setPerformanceHint(QStaticText::AggressiveCaching);
+        staticText.prepare(QTransform(), font);
+        block->lines.append(staticText);
+        block->widths.append(staticText.size().width());
+    }
+    textCache.insert(key, block);
+    return block;
+}
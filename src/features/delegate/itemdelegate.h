@@ -0,0 +1,54 @@
+#ifndef ITEMDELEGATE_H
+#define ITEMDELEGATE_H
+
+#include <QBrush>
+#include <QCache>
+#include <QFont>
+#include <QStaticText>
+#include <QStyledItemDelegate>
+#include <QVector>
+
+// Paints the rows of a zone's file list: icon, name and the selection /
+// hover highlight, drawn directly instead of through the stylesheet engine.
+// List mode (icon left) shows the name on one elided line; icon mode (icon
+// on top) wraps it to the lines that fit below the icon and elides the last.
+// Laid-out names are cached per text and width, so scrolling and hovering
+// only draw prepared glyphs.
+class ZoneItemDelegate : public QStyledItemDelegate
+{
+    Q_OBJECT
+
+public:
+    explicit ZoneItemDelegate(QObject *parent = nullptr);
+
+    void paint(QPainter *painter, const QStyleOptionViewItem &option,
+               const QModelIndex &index) const override;
+    QSize sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const override;
+
+private:
+    static constexpr int PADDING = 3;        // around the item contents
+    static constexpr int ICON_SPACING = 4;   // between icon and name
+    static constexpr int TEXT_CACHE_SIZE = 4096;
+    static constexpr qreal PENDING_OPACITY = 0.45;
+
+    // A name broken into display lines
+    struct TextBlock
+    {
+        QVector<QStaticText> lines;
+        QVector<qreal> widths;
+    };
+
+    void paintName(QPainter *painter, const QStyleOptionViewItem &option,
+                   const QString &name, const QRect &textRect, bool iconOnTop) const;
+    const TextBlock *textBlock(const QString &text, const QFont &font, int width,
+                               int maxLines, Qt::TextElideMode elide) const;
+
+    QBrush selectedBrush;
+    QBrush hoverBrush;
+    QColor textColor;
+
+    mutable QCache<QString, TextBlock> textCache;
+    mutable QFont cachedFont;
+};
+
+#endif // ITEMDELEGATE_H
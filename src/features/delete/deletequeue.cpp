@@ -0,0 +1,599 @@
+#include "deletequeue.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
+#include <QRunnable>
+#include <QThread>
+#include <QVector>
+#include <QWaitCondition>
+#include <atomic>
+#include <functional>
+#include "../trace/tracer.h"
+
+#if defined(Q_OS_UNIX)
+#include <cerrno>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#if defined(Q_OS_LINUX)
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#elif defined(Q_OS_WIN)
+#include <windows.h>
+#endif
+
+// Shared between the queue (GUI thread) and the job's workers
+struct DeleteJob
+{
+    struct Item
+    {
+        QString path;
+        bool isDir = false;
+    };
+
+    QVector<Item> items;
+    bool background = false;
+
+    std::atomic_bool cancelled{false};
+    std::atomic<qint64> entriesRemoved{0};
+    // Removals seen by pace(), counted across all items and folders
+    mutable std::atomic<qint64> paced{0};
+
+    bool isCancelled() const { return cancelled.load(std::memory_order_relaxed); }
+
+    // Called after every removal; background jobs pause every PACE_BATCH
+    // removals of the whole job
+    void pace() const
+    {
+        if (!background) {
+            return;
+        }
+        const qint64 removed = paced.fetch_add(1, std::memory_order_relaxed) + 1;
+        if (removed % DeleteQueue::PACE_BATCH == 0) {
+            QThread::msleep(DeleteQueue::PACE_PAUSE_MS);
+        }
+    }
+
+    // GUI thread only
+    DeleteStatus status;
+};
+
+namespace {
+
+// Entries unlinked between checks for cancellation
+constexpr int CANCEL_CHECK_INTERVAL = 256;
+
+// Drop the calling thread to idle CPU and I/O priority. Only used on the
+// background pool's thread: an unprivileged thread cannot raise its
+// priority again, so it stays there.
+void enterBackgroundMode()
+{
+#if defined(Q_OS_LINUX)
+    constexpr int IOPRIO_WHO_PROCESS = 1;   // with id 0: the calling thread
+    constexpr int IOPRIO_CLASS_IDLE = 3;
+    constexpr int IOPRIO_CLASS_SHIFT = 13;
+    ::syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT);
+    // Nice values are per thread on Linux
+    ::setpriority(PRIO_PROCESS, id_t(::syscall(SYS_gettid)), 19);
+#elif defined(Q_OS_WIN)
+    // Lowers I/O and memory priority as well
+    ::SetThreadPriority(::GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN);
+#else
+    QThread::currentThread()->setPriority(QThread::LowestPriority);
+#endif
+}
+
+// A folder of a tree being removed. On Unix it is opened relative to its
+// parent's descriptor and stays open until its last subfolder is gone; it is
+// then removed through its parent in turn.
+struct Folder
+{
+    std::shared_ptr<Folder> parent;   // null for the folder holding the root
+#if defined(Q_OS_UNIX)
+    QByteArray name;                  // entry name inside parent
+    int fd = -1;
+
+    ~Folder()
+    {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+#else
+    QString path;
+#endif
+    // Its own listing, plus one per subfolder not removed yet
+    std::atomic<int> remaining{1};
+};
+
+using FolderPtr = std::shared_ptr<Folder>;
+
+#if defined(Q_OS_UNIX)
+
+bool removeFile(const QString &path)
+{
+    return ::unlink(QFile::encodeName(path).constData()) == 0 || errno == ENOENT;
+}
+
+FolderPtr treeRoot(const QString &path, FolderPtr &holder)
+{
+    const QFileInfo info(path);
+    holder = std::make_shared<Folder>();
+    holder->fd = ::open(QFile::encodeName(info.absolutePath()).constData(),
+                        O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+    FolderPtr root = std::make_shared<Folder>();
+    root->parent = holder;
+    root->name = QFile::encodeName(info.fileName());
+    return root;
+}
+
+// Open the folder and unlink every entry except its subfolders, which are
+// appended to `subfolders`. Returns false if anything could not be removed.
+bool emptyFolder(const FolderPtr &folder, QVector<FolderPtr> &subfolders, const DeleteJob &job,
+                 std::atomic<qint64> &removed)
+{
+    // O_NOFOLLOW on a name inside an open parent: a folder swapped for a
+    // symlink meanwhile is not entered, at any depth
+    folder->fd = ::openat(folder->parent->fd, folder->name.constData(),
+                          O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+    if (folder->fd < 0) {
+        return errno == ENOENT;
+    }
+    // The listing gets its own descriptor; fd stays open for the subfolders
+    const int listFd = ::dup(folder->fd);
+    DIR *dir = listFd >= 0 ? ::fdopendir(listFd) : nullptr;
+    if (!dir) {
+        if (listFd >= 0) {
+            ::close(listFd);
+        }
+        return false;
+    }
+
+    // Names are read first: unlinking while readdir() is still going can make
+    // it skip entries on some file systems
+    bool ok = true;
+    QVector<QByteArray> files;
+    for (;;) {
+        errno = 0;
+        const struct dirent *entry = ::readdir(dir);
+        if (!entry) {
+            ok = errno == 0;
+            break;
+        }
+        const char *name = entry->d_name;
+        if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+            continue;
+        }
+
+        bool isDir = entry->d_type == DT_DIR;
+        if (entry->d_type == DT_UNKNOWN) {
+            struct stat st;
+            isDir = ::fstatat(folder->fd, name, &st, AT_SYMLINK_NOFOLLOW) == 0
+                    && S_ISDIR(st.st_mode);
+        }
+        if (isDir) {
+            FolderPtr subfolder = std::make_shared<Folder>();
+            subfolder->parent = folder;
+            subfolder->name = QByteArray(name);
+            subfolders.append(subfolder);
+        } else {
+            files.append(QByteArray(name));
+        }
+    }
+    ::closedir(dir);
+
+    qint64 count = 0;
+    for (int i = 0; i < files.size(); ++i) {
+        if (i % CANCEL_CHECK_INTERVAL == 0 && job.isCancelled()) {
+            ok = false;
+            break;
+        }
+        if (::unlinkat(folder->fd, files.at(i).constData(), 0) == 0) {
+            ++count;
+        } else if (errno != ENOENT) {
+            ok = false;
+        }
+        job.pace();
+    }
+    removed.fetch_add(count, std::memory_order_relaxed);
+    return ok;
+}
+
+// Remove the emptied folder from its parent
+bool removeEmptyFolder(Folder &folder)
+{
+    if (folder.fd >= 0) {
+        ::close(folder.fd);
+        folder.fd = -1;
+    }
+    return ::unlinkat(folder.parent->fd, folder.name.constData(), AT_REMOVEDIR) == 0
+           || errno == ENOENT;
+}
+
+#else
+
+bool removeFile(const QString &path)
+{
+    if (QFile::remove(path)) {
+        return true;
+    }
+    // Read-only files cannot be deleted on Windows
+    const QFileInfo info(path);
+    if (!info.exists() && !info.isSymLink()) {
+        return true;
+    }
+    QFile::setPermissions(path, info.permissions() | QFile::WriteUser);
+    return QFile::remove(path);
+}
+
+FolderPtr treeRoot(const QString &path, FolderPtr &holder)
+{
+    holder = std::make_shared<Folder>();
+    FolderPtr root = std::make_shared<Folder>();
+    root->parent = holder;
+    root->path = path;
+    return root;
+}
+
+bool emptyFolder(const FolderPtr &folder, QVector<FolderPtr> &subfolders, const DeleteJob &job,
+                 std::atomic<qint64> &removed)
+{
+    QStringList files;
+    QDirIterator it(folder->path,
+                    QDir::AllEntries | QDir::Hidden | QDir::System | QDir::NoDotAndDotDot);
+    while (it.hasNext()) {
+        it.next();
+        const QFileInfo info = it.fileInfo();
+        if (info.isDir() && !info.isSymLink()) {
+            FolderPtr subfolder = std::make_shared<Folder>();
+            subfolder->parent = folder;
+            subfolder->path = info.filePath();
+            subfolders.append(subfolder);
+        } else {
+            files.append(info.filePath());
+        }
+    }
+
+    bool ok = true;
+    qint64 count = 0;
+    for (int i = 0; i < files.size(); ++i) {
+        if (i % CANCEL_CHECK_INTERVAL == 0 && job.isCancelled()) {
+            ok = false;
+            break;
+        }
+        if (removeFile(files.at(i))) {
+            ++count;
+        } else {
+            ok = false;
+        }
+        job.pace();
+    }
+    removed.fetch_add(count, std::memory_order_relaxed);
+    return ok;
+}
+
+bool removeEmptyFolder(Folder &folder)
+{
+    return QDir().rmdir(folder.path) || !QFileInfo::exists(folder.path);
+}
+
+#endif
+
+// One folder tree being emptied by several threads. Folders still to be
+// listed sit in a shared stack; whoever lists a folder pushes its
+// subfolders. A folder is removed by whichever thread finishes the last of
+// its subfolders, so folders stay open only while their subtree is worked
+// on (depth first, that is about the depth of the tree per thread).
+// Listing is done when no folder is queued or being worked on.
+class TreeRemoval
+{
+public:
+    TreeRemoval(const QString &root, DeleteJob *job)
+        : job(job)
+    {
+        pending.append(treeRoot(root, holder));
+        outstanding = 1;
+    }
+
+    // Empty and remove folders until none are left; run by every thread
+    // taking part
+    void work()
+    {
+        for (;;) {
+            FolderPtr folder;
+            {
+                QMutexLocker locker(&mutex);
+                while (pending.isEmpty() && outstanding > 0) {
+                    wake.wait(&mutex);
+                }
+                if (pending.isEmpty()) {
+                    return;
+                }
+                folder = pending.takeLast();
+            }
+
+            QVector<FolderPtr> subfolders;
+            const bool cancelled = job->isCancelled();
+            if (cancelled || !emptyFolder(folder, subfolders, *job, job->entriesRemoved)) {
+                failed.store(true, std::memory_order_relaxed);
+            }
+            // Counted before any subfolder can be taken and removed
+            folder->remaining.fetch_add(subfolders.size(), std::memory_order_relaxed);
+
+            if (!subfolders.isEmpty()) {
+                QMutexLocker locker(&mutex);
+                pending += subfolders;
+                outstanding += subfolders.size();
+                wake.wakeAll();
+            }
+            subfolders.clear();
+
+            if (!cancelled) {
+                release(std::move(folder));
+            }
+
+            QMutexLocker locker(&mutex);
+            if (--outstanding == 0) {
+                wake.wakeAll();
+            }
+        }
+    }
+
+    // Whether the whole tree is gone. Call once work() has returned on the
+    // calling thread.
+    bool finish() const
+    {
+        return !failed.load() && !job->isCancelled();
+    }
+
+private:
+    // Drop one of folder's references; the folder is removed when that was
+    // the last, which may in turn complete its parent
+    void release(FolderPtr folder)
+    {
+        while (folder->parent
+               && folder->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            if (job->isCancelled() || !removeEmptyFolder(*folder)) {
+                failed.store(true, std::memory_order_relaxed);
+                return;
+            }
+            job->entriesRemoved.fetch_add(1, std::memory_order_relaxed);
+            job->pace();
+            folder = folder->parent;
+        }
+    }
+
+    DeleteJob *job;
+    FolderPtr holder;            // the folder the root is in
+    QMutex mutex;
+    QWaitCondition wake;
+    QVector<FolderPtr> pending;  // to be listed; taken from the back (depth first)
+    int outstanding = 0;         // pending + being worked on
+    std::atomic_bool failed{false};
+};
+
+// Extra thread emptying a tree alongside the job's own
+class TreeHelper : public QRunnable
+{
+public:
+    explicit TreeHelper(std::shared_ptr<TreeRemoval> tree)
+        : tree(std::move(tree))
+    {
+    }
+
+    void run() override { tree->work(); }
+
+private:
+    std::shared_ptr<TreeRemoval> tree;
+};
+
+class DeleteTask : public QRunnable
+{
+public:
+    DeleteTask(QObject *queue, QThreadPool *pool, quint64 id, std::shared_ptr<DeleteJob> job,
+               std::function<void(quint64, const QString &, bool)> onItem,
+               std::function<void(quint64)> onDone)
+        : queue(queue), pool(pool), id(id), job(std::move(job))
+        , onItem(std::move(onItem)), onDone(std::move(onDone))
+    {
+    }
+
+    void run() override
+    {
+        TraceSpan span("DeleteQueue::job", "delete");
+        if (job->background) {
+            enterBackgroundMode();
+        }
+
+        for (const DeleteJob::Item &item : job->items) {
+            bool ok = false;
+            if (job->isCancelled()) {
+                // Left in place
+            } else if (item.isDir) {
+                ok = removeTree(item.path);
+            } else if (removeFile(item.path)) {
+                job->entriesRemoved.fetch_add(1, std::memory_order_relaxed);
+                job->pace();
+                ok = true;
+            }
+            finishItem(item.path, ok);
+        }
+
+        const quint64 jobId = id;
+        auto callback = onDone;
+        QMetaObject::invokeMethod(queue, [callback, jobId]() { callback(jobId); },
+                                  Qt::QueuedConnection);
+    }
+
+private:
+    bool removeTree(const QString &path)
+    {
+        TraceSpan span("DeleteQueue::removeTree", "delete");
+
+        // Idle pool threads join in (not for background jobs); the tree
+        // outlives helpers that are still winding down when this thread is done
+        auto tree = std::make_shared<TreeRemoval>(path, job.get());
+        for (int i = 1; i < DeleteQueue::MAX_THREADS && !job->background; ++i) {
+            TreeHelper *helper = new TreeHelper(tree);
+            if (!pool->tryStart(helper)) {
+                delete helper;
+                break;
+            }
+        }
+        tree->work();
+        return tree->finish();
+    }
+
+    void finishItem(const QString &path, bool ok)
+    {
+        const quint64 jobId = id;
+        auto callback = onItem;
+        QMetaObject::invokeMethod(queue, [callback, jobId, path, ok]() {
+            callback(jobId, path, ok);
+        }, Qt::QueuedConnection);
+    }
+
+    // Only used as the context of queued calls; never dereferenced here
+    QObject *queue;
+    QThreadPool *pool;
+    quint64 id;
+    std::shared_ptr<DeleteJob> job;
+    std::function<void(quint64, const QString &, bool)> onItem;
+    std::function<void(quint64)> onDone;
+};
+
+} // namespace
+
+DeleteQueue *DeleteQueue::instance()
+{
+    static DeleteQueue *queue = new DeleteQueue(QCoreApplication::instance());
+    return queue;
+}
+
+DeleteQueue::DeleteQueue(QObject *parent)
+    : QObject(parent)
+{
+    pool.setMaxThreadCount(MAX_THREADS);
+    backgroundPool.setMaxThreadCount(1);
+
+    progressTimer.setInterval(PROGRESS_INTERVAL_MS);
+    connect(&progressTimer, &QTimer::timeout, this, &DeleteQueue::reportProgress);
+
+    connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit, this, [this]() {
+        cancelAll();
+        pool.waitForDone();
+        backgroundPool.waitForDone();
+    });
+}
+
+DeleteQueue::~DeleteQueue()
+{
+    cancelAll();
+    pool.waitForDone();
+    backgroundPool.waitForDone();
+}
+
+quint64 DeleteQueue::remove(const QStringList &paths, Priority priority)
+{
+    auto job = std::make_shared<DeleteJob>();
+    job->background = priority == Background;
+    for (const QString &path : paths) {
+        const QFileInfo info(path);
+        if (!info.exists() && !info.isSymLink()) {
+            continue;
+        }
+        DeleteJob::Item item;
+        item.path = info.absoluteFilePath();
+        item.isDir = info.isDir() && !info.isSymLink();
+        job->items.append(item);
+    }
+    if (job->items.isEmpty()) {
+        return 0;
+    }
+
+    const quint64 id = nextId++;
+    job->status.id = id;
+    job->status.itemCount = job->items.size();
+    jobs.insert(id, job);
+
+    for (const DeleteJob::Item &item : job->items) {
+        emit itemQueued(item.path, item.isDir);
+    }
+
+    QThreadPool *target = job->background ? &backgroundPool : &pool;
+    target->start(new DeleteTask(this, target, id, job,
+        [this](quint64 jobId, const QString &path, bool ok) { onItemRemoved(jobId, path, ok); },
+        [this](quint64 jobId) { onJobFinished(jobId); }));
+
+    if (!progressTimer.isActive()) {
+        progressTimer.start();
+    }
+    return id;
+}
+
+void DeleteQueue::cancel(quint64 id)
+{
+    auto it = jobs.constFind(id);
+    if (it != jobs.constEnd()) {
+        it.value()->cancelled.store(true);
+        it.value()->status.cancelled = true;
+    }
+}
+
+void DeleteQueue::cancelAll()
+{
+    for (auto it = jobs.constBegin(); it != jobs.constEnd(); ++it) {
+        cancel(it.key());
+    }
+}
+
+QList<DeleteStatus> DeleteQueue::activeJobs() const
+{
+    QList<DeleteStatus> result;
+    for (const auto &job : jobs) {
+        result.append(job->status);
+    }
+    return result;
+}
+
+void DeleteQueue::onItemRemoved(quint64 id, const QString &path, bool ok)
+{
+    auto it = jobs.constFind(id);
+    if (it != jobs.constEnd()) {
+        DeleteStatus &status = it.value()->status;
+        ++status.itemsDone;
+        if (!ok) {
+            status.failed.append(QFileInfo(path).fileName());
+        }
+    }
+    emit itemRemoved(path, ok);
+}
+
+void DeleteQueue::onJobFinished(quint64 id)
+{
+    const std::shared_ptr<DeleteJob> job = jobs.take(id);
+    if (!job) {
+        return;
+    }
+
+    job->status.entriesRemoved = job->entriesRemoved.load();
+    job->status.finished = true;
+    if (jobs.isEmpty()) {
+        progressTimer.stop();
+    }
+    emit jobFinished(job->status);
+}
+
+void DeleteQueue::reportProgress()
+{
+    for (const auto &job : jobs) {
+        job->status.entriesRemoved = job->entriesRemoved.load(std::memory_order_relaxed);
+        emit jobProgress(job->status);
+    }
+}
@@ -0,0 +1,88 @@
+#ifndef DELETEQUEUE_H
+#define DELETEQUEUE_H
+
+#include <QObject>
+#include <QHash>
+#include <QStringList>
+#include <QThreadPool>
+#include <QTimer>
+#include <memory>
+
+struct DeleteJob;
+
+// Snapshot of one delete job, as reported to the GUI
+struct DeleteStatus
+{
+    quint64 id = 0;
+    int itemCount = 0;
+    int itemsDone = 0;
+    qint64 entriesRemoved = 0;   // files, links and folders removed so far
+    QStringList failed;          // names of items that could not be removed completely
+    bool cancelled = false;
+    bool finished = false;
+};
+
+// Deletes files and folders permanently on worker threads.
+// Each remove() is one job however many items it has (a multi-selection is
+// one batch). Items are removed one after another; a folder tree is emptied
+// by up to MAX_THREADS threads that share out its subfolders. On Unix each
+// folder is opened by name relative to its parent's descriptor (openat with
+// O_NOFOLLOW), its entries are unlinked relative to its own, and it is
+// removed with unlinkat(AT_REMOVEDIR) on its parent as soon as its last
+// subfolder is gone. Only the item itself is looked up by path, so a folder
+// swapped for a symlink is never followed at any depth and deep trees do
+// not run into PATH_MAX. An item is reported as soon as it is gone.
+// Background jobs (emptying the trash) run one at a time on a single thread
+// at idle CPU and I/O priority and pause between batches of unlinks, so they
+// do not compete with the zones for the disk.
+class DeleteQueue : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Priority {
+        Normal,
+        Background
+    };
+
+    static constexpr int MAX_THREADS = 4;
+    static constexpr int PROGRESS_INTERVAL_MS = 250;
+    // Background jobs: entries removed between pauses, and the pause
+    static constexpr int PACE_BATCH = 256;
+    static constexpr int PACE_PAUSE_MS = 5;
+
+    static DeleteQueue *instance();
+
+    // Queue deleting `paths`. Returns the job id, or 0 if none of them exist.
+    quint64 remove(const QStringList &paths, Priority priority = Normal);
+
+    void cancel(quint64 id);
+    void cancelAll();
+
+    bool isBusy() const { return !jobs.isEmpty(); }
+    QList<DeleteStatus> activeJobs() const;
+
+signals:
+    // path will be deleted once its job gets to it
+    void itemQueued(const QString &path, bool isDir);
+    // path is gone (ok), or was only partly removed / cancelled
+    void itemRemoved(const QString &path, bool ok);
+    void jobProgress(const DeleteStatus &status);
+    void jobFinished(const DeleteStatus &status);
+
+private:
+    explicit DeleteQueue(QObject *parent = nullptr);
+    ~DeleteQueue() override;
+
+    void onItemRemoved(quint64 id, const QString &path, bool ok);
+    void onJobFinished(quint64 id);
+    void reportProgress();
+
+    QThreadPool pool;
+    QThreadPool backgroundPool;
+    QHash<quint64, std::shared_ptr<DeleteJob>> jobs;
+    QTimer progressTimer;
+    quint64 nextId = 1;
+};
+
+#endif // DELETEQUEUE_H
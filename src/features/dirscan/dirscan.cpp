@@ -0,0 +1,273 @@
+#include "dirscan.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QRunnable>
+#include <QThread>
+#include "../trace/tracer.h"
+
+namespace {
+
+// Deliver partial results at least this often on slow filesystems
+constexpr qint64 BATCH_INTERVAL_MS = 50;
+
+class ScanTask : public QRunnable
+{
+public:
+    ScanTask(QObject *receiver, const QString &path, DirScanner::Filter filter,
+             std::shared_ptr<std::atomic_bool> cancelled,
+             DirScanner::BatchCallback onBatch,
+             DirScanner::FinishedCallback onFinished)
+        : receiver(receiver), path(path), filter(filter), cancelled(std::move(cancelled))
+        , onBatch(std::move(onBatch)), onFinished(std::move(onFinished))
+    {
+    }
+
+    void run() override
+    {
+        TraceSpan span("DirScanner::scan", "scan");
+        span.setDetail(path);
+
+        QVector<FileEntry> entries;
+        QVector<FileEntry> batch;
+        batch.reserve(DirScanner::BATCH_SIZE);
+
+        const bool ok = QFileInfo(path).isDir();
+        if (ok) {
+            QDir::Filters filters = QDir::NoDotAndDotDot | QDir::Dirs;
+            if (filter == DirScanner::FilesAndDirs) {
+                filters |= QDir::Files;
+            }
+
+            QDirIterator it(path, filters);
+            QElapsedTimer sinceFlush;
+            sinceFlush.start();
+
+            while (it.hasNext()) {
+                if (cancelled->load(std::memory_order_relaxed)) {
+                    return;
+                }
+                it.next();
+                FileEntry entry = FileEntry::fromFileInfo(it.fileInfo());
+                entries.append(entry);
+                batch.append(std::move(entry));
+
+                if (batch.size() >= DirScanner::BATCH_SIZE ||
+                    sinceFlush.elapsed() >= BATCH_INTERVAL_MS) {
+                    deliverBatch(batch);
+                    batch.clear();
+                    batch.reserve(DirScanner::BATCH_SIZE);
+                    sinceFlush.restart();
+                }
+            }
+        }
+
+        if (cancelled->load(std::memory_order_relaxed)) {
+            return;
+        }
+        if (!batch.isEmpty()) {
+            deliverBatch(batch);
+        }
+
+        auto token = cancelled;
+        auto callback = onFinished;
+        QMetaObject::invokeMethod(receiver, [token, callback, entries, ok]() {
+            if (!token->load() && callback) {
+                callback(entries, ok);
+            }
+        }, Qt::QueuedConnection);
+    }
+
+private:
+    void deliverBatch(const QVector<FileEntry> &batch)
+    {
+        if (!onBatch) {
+            return;
+        }
+        auto token = cancelled;
+        auto callback = onBatch;
+        QMetaObject::invokeMethod(receiver, [token, callback, batch]() {
+            if (!token->load()) {
+                callback(batch);
+            }
+        }, Qt::QueuedConnection);
+    }
+
+    // The scanner itself: it outlives the pool, unlike the owner, which the
+    // GUI thread may delete while this task is still running
+    QObject *receiver;
+    QString path;
+    DirScanner::Filter filter;
+    std::shared_ptr<std::atomic_bool> cancelled;
+    DirScanner::BatchCallback onBatch;
+    DirScanner::FinishedCallback onFinished;
+};
+
+class StatTask : public QRunnable
+{
+public:
+    StatTask(QObject *receiver, const QString &folder, const QStringList &names,
+             std::shared_ptr<std::atomic_bool> cancelled,
+             DirScanner::StatCallback onDone)
+        : receiver(receiver), folder(folder), names(names), cancelled(std::move(cancelled))
+        , onDone(std::move(onDone))
+    {
+    }
+
+    void run() override
+    {
+        TraceSpan span("DirScanner::stat", "scan");
+        span.setDetail(folder);
+
+        QVector<FileEntry> present;
+        QStringList missing;
+        const QDir dir(folder);
+
+        for (const QString &name : names) {
+            if (cancelled->load(std::memory_order_relaxed)) {
+                return;
+            }
+            const QFileInfo info(dir.filePath(name));
+            if (info.exists() && (info.isDir() || info.isFile())) {
+                present.append(FileEntry::fromFileInfo(info));
+            } else {
+                missing.append(name);
+            }
+        }
+
+        auto token = cancelled;
+        auto callback = onDone;
+        QMetaObject::invokeMethod(receiver, [token, callback, present, missing]() {
+            if (!token->load() && callback) {
+                callback(present, missing);
+            }
+        }, Qt::QueuedConnection);
+    }
+
+private:
+    QObject *receiver;
+    QString folder;
+    QStringList names;
+    std::shared_ptr<std::atomic_bool> cancelled;
+    DirScanner::StatCallback onDone;
+};
+
+} // namespace
+
+DirScanner *DirScanner::instance()
+{
+    static DirScanner *scanner = new DirScanner(QCoreApplication::instance());
+    return scanner;
+}
+
+DirScanner::DirScanner(QObject *parent)
+    : QObject(parent)
+{
+    // A few threads are enough: scans are I/O bound, and one slow mount
+    // should not starve the other zones.
+    pool.setMaxThreadCount(qBound(2, QThread::idealThreadCount(), 4));
+}
+
+DirScanner::~DirScanner()
+{
+    for (const auto &token : running) {
+        token->cancelled = true;
+    }
+    pool.waitForDone();
+}
+
+std::shared_ptr<DirScanner::Token> DirScanner::beginTask(QObject *owner)
+{
+    cancel(owner);
+
+    auto token = std::make_shared<Token>();
+    if (!trackedOwners.contains(owner)) {
+        trackedOwners.insert(owner);
+        connect(owner, &QObject::destroyed, this, [this](QObject *gone) {
+            cancel(gone);
+            trackedOwners.remove(gone);
+        });
+    }
+    running.insert(owner, token);
+    return token;
+}
+
+bool DirScanner::isCurrent(QObject *owner, const std::shared_ptr<Token> &token) const
+{
+    // A destroyed or re-tasked owner no longer maps to this token
+    return !token->cancelled && running.value(owner) == token;
+}
+
+void DirScanner::endTask(QObject *owner, const std::shared_ptr<Token> &token)
+{
+    if (running.value(owner) == token) {
+        running.remove(owner);
+    }
+}
+
+void DirScanner::scan(QObject *owner, const QString &path, Filter filter,
+                      BatchCallback onBatch, FinishedCallback onFinished)
+{
+    auto token = beginTask(owner);
+
+    // The task only needs the flag; keep the token alive through an aliasing pointer
+    std::shared_ptr<std::atomic_bool> cancelled(token, &token->cancelled);
+
+    // Queued calls run on the scanner; owner is only compared, never called
+    // through, until the lookup proves it is still alive
+    BatchCallback batch;
+    if (onBatch) {
+        batch = [this, owner, token, onBatch](const QVector<FileEntry> &entries) {
+            if (isCurrent(owner, token)) {
+                onBatch(entries);
+            }
+        };
+    }
+    auto finished = [this, owner, token, onFinished](const QVector<FileEntry> &entries, bool ok) {
+        if (!isCurrent(owner, token)) {
+            return;
+        }
+        endTask(owner, token);
+        if (onFinished) {
+            onFinished(entries, ok);
+        }
+    };
+
+    pool.start(new ScanTask(this, path, filter, cancelled, batch, finished));
+}
+
+void DirScanner::stat(QObject *owner, const QString &folder, const QStringList &names,
+                      StatCallback onDone)
+{
+    auto token = beginTask(owner);
+    std::shared_ptr<std::atomic_bool> cancelled(token, &token->cancelled);
+
+    auto done = [this, owner, token, onDone](const QVector<FileEntry> &present, const QStringList &missing) {
+        if (!isCurrent(owner, token)) {
+            return;
+        }
+        endTask(owner, token);
+        if (onDone) {
+            onDone(present, missing);
+        }
+    };
+
+    pool.start(new StatTask(this, folder, names, cancelled, done));
+}
+
+bool DirScanner::isBusy(QObject *owner) const
+{
+    return running.contains(owner);
+}
+
+void DirScanner::cancel(QObject *owner)
+{
+    auto it = running.find(owner);
+    if (it == running.end()) {
+        return;
+    }
+    it.value()->cancelled = true;
+    running.erase(it);
+}
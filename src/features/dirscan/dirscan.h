@@ -0,0 +1,74 @@
+#ifndef DIRSCAN_H
+#define DIRSCAN_H
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+#include <QThreadPool>
+#include <QVector>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include "../filemodel/filemodel.h"
+
+// Lists folders on a shared worker pool so a slow disk, a network/FUSE mount
+// or a huge folder never blocks the GUI thread.
+// Results are delivered on the GUI thread: partial batches while the
+// folder is being read, then the complete listing once it is done.
+// Each owner has at most one task in flight; starting a new one cancels the
+// previous task, and nothing is delivered after the owner is destroyed.
+class DirScanner : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Filter {
+        FilesAndDirs,   // zone contents
+        DirsOnly        // boox root: one zone per folder
+    };
+
+    using BatchCallback = std::function<void(const QVector<FileEntry> &batch)>;
+    // ok is false if the folder does not exist or cannot be read
+    using FinishedCallback = std::function<void(const QVector<FileEntry> &entries, bool ok)>;
+
+    // present: entries that exist; missing: names that no longer do
+    using StatCallback = std::function<void(const QVector<FileEntry> &present,
+                                            const QStringList &missing)>;
+
+    static DirScanner *instance();
+
+    // Start listing `path` on behalf of `owner` (replaces any running scan of owner)
+    void scan(QObject *owner, const QString &path, Filter filter,
+              BatchCallback onBatch, FinishedCallback onFinished);
+
+    // Look up only `names` inside `folder`, for applying watcher deltas
+    // without relisting the folder (replaces any running task of owner)
+    void stat(QObject *owner, const QString &folder, const QStringList &names,
+              StatCallback onDone);
+
+    // Drop the running task of owner, if any
+    void cancel(QObject *owner);
+    bool isBusy(QObject *owner) const;
+
+    static constexpr int BATCH_SIZE = 256;
+
+private:
+    explicit DirScanner(QObject *parent = nullptr);
+    ~DirScanner() override;
+
+    struct Token
+    {
+        std::atomic_bool cancelled{false};
+    };
+
+    std::shared_ptr<Token> beginTask(QObject *owner);
+    bool isCurrent(QObject *owner, const std::shared_ptr<Token> &token) const;
+    void endTask(QObject *owner, const std::shared_ptr<Token> &token);
+
+    QThreadPool pool;
+    QHash<QObject*, std::shared_ptr<Token>> running;
+    QSet<QObject*> trackedOwners;
+};
+
+#endif // DIRSCAN_H
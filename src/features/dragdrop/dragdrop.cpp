@@ -6,46 +6,29 @@
 #include <QFile>
 #include <QStringList>
 #include <QObject>
+#include "../filemodel/filemodel.h"
+#include "../transfer/transferqueue.h"
 #include "../../floatingzone.h"
 
-// Implementation of DraggableListWidget
-DraggableListWidget::DraggableListWidget(QWidget *parent) : QListWidget(parent)
+// Implementation of DraggableListView
+DraggableListView::DraggableListView(QWidget *parent) : QListView(parent)
 {
     setAcceptDrops(true);
     setDragDropMode(QAbstractItemView::DragDrop);
     setDefaultDropAction(Qt::MoveAction);
 }
 
-QMimeData* DraggableListWidget::mimeData(const QList<QListWidgetItem*> items) const
-{
-    QMimeData *mimeData = new QMimeData();
-    QList<QUrl> urls;
-
-    for (QListWidgetItem *item : items) {
-        QString filePath = item->data(Qt::UserRole).toString();
-        if (!filePath.isEmpty()) {
-            urls.append(QUrl::fromLocalFile(filePath));
-        }
-    }
-
-    if (!urls.isEmpty()) {
-        mimeData->setUrls(urls);
-    }
-
-    return mimeData;
-}
-
-void DraggableListWidget::dragEnterEvent(QDragEnterEvent *event)
+void DraggableListView::dragEnterEvent(QDragEnterEvent *event)
 {
     // Accept drops if we have URLs (files from external or internal sources)
     if (event->mimeData()->hasUrls()) {
         event->acceptProposedAction();
     } else {
-        QListWidget::dragEnterEvent(event);
+        QListView::dragEnterEvent(event);
     }
 }
 
-void DraggableListWidget::dragMoveEvent(QDragMoveEvent *event)
+void DraggableListView::dragMoveEvent(QDragMoveEvent *event)
 {
     if (!event->mimeData()->hasUrls()) {
         event->ignore();
@@ -53,17 +36,17 @@ void DraggableListWidget::dragMoveEvent(QDragMoveEvent *event)
     }
 
     // Get the item under the cursor (use pos() for Qt5/Qt6 compatibility)
-    QListWidgetItem *item = itemAt(event->pos());
+    QModelIndex index = indexAt(event->pos());
 
-    if (item) {
-        QString filePath = item->data(Qt::UserRole).toString();
+    if (index.isValid()) {
+        QString filePath = index.data(ZoneFileModel::PathRole).toString();
         QFileInfo fileInfo(filePath);
 
         // Only accept drops on folders
         if (fileInfo.isDir()) {
             event->acceptProposedAction();
             // Highlight the folder item
-            setCurrentItem(item);
+            setCurrentIndex(index);
         } else {
             event->ignore();
         }
@@ -74,7 +57,7 @@ void DraggableListWidget::dragMoveEvent(QDragMoveEvent *event)
     }
 }
 
-void DraggableListWidget::dropEvent(QDropEvent *event)
+void DraggableListView::dropEvent(QDropEvent *event)
 {
     const QMimeData *mimeData = event->mimeData();
 
@@ -84,22 +67,16 @@ void DraggableListWidget::dropEvent(QDropEvent *event)
     }
 
     // Get the item where files were dropped (use pos() for Qt5/Qt6 compatibility)
-    QListWidgetItem *item = itemAt(event->pos());
+    QModelIndex index = indexAt(event->pos());
 
-    if (item) {
+    if (index.isValid()) {
         // Dropping on a specific folder item
-        QString targetFolder = getTargetFolderPath(item);
+        QString targetFolder = getTargetFolderPath(index);
 
         if (!targetFolder.isEmpty()) {
-            // Move files to the target folder
+            // Move files to the target folder (in the background)
             if (moveFilesToFolder(mimeData, targetFolder)) {
                 event->acceptProposedAction();
-
-                // Refresh the parent FloatingZone's file list
-                FloatingZone *zone = qobject_cast<FloatingZone*>(parentWidget()->parentWidget());
-                if (zone) {
-                    zone->loadFilesFromFolder();
-                }
             } else {
                 event->ignore();
             }
@@ -108,11 +85,10 @@ void DraggableListWidget::dropEvent(QDropEvent *event)
         }
     } else {
         // Dropping on empty space - move to the FloatingZone's root folder (first-level folder)
-        FloatingZone *zone = qobject_cast<FloatingZone*>(parentWidget()->parentWidget());
+        FloatingZone *zone = qobject_cast<FloatingZone*>(window());
         if (zone && !zone->getFolderPath().isEmpty()) {
             if (moveFilesToFolder(mimeData, zone->getFolderPath())) {
                 event->acceptProposedAction();
-                zone->loadFilesFromFolder();
             } else {
                 event->ignore();
             }
@@ -122,13 +98,13 @@ void DraggableListWidget::dropEvent(QDropEvent *event)
     }
 }
 
-QString DraggableListWidget::getTargetFolderPath(QListWidgetItem *item)
+QString DraggableListView::getTargetFolderPath(const QModelIndex &index)
 {
-    if (!item) {
+    if (!index.isValid()) {
         return QString();
     }
 
-    QString filePath = item->data(Qt::UserRole).toString();
+    QString filePath = index.data(ZoneFileModel::PathRole).toString();
     QFileInfo fileInfo(filePath);
 
     // Only return path if it's a directory
@@ -139,7 +115,7 @@ QString DraggableListWidget::getTargetFolderPath(QListWidgetItem *item)
     return QString();
 }
 
-bool DraggableListWidget::moveFilesToFolder(const QMimeData *mimeData, const QString &targetFolder)
+bool DraggableListView::moveFilesToFolder(const QMimeData *mimeData, const QString &targetFolder)
 {
     return DragDropHandler::moveFilesToFolder(mimeData, targetFolder, this);
 }
@@ -167,7 +143,6 @@ void DragDropHandler::handleDrop(QDropEvent *event, FloatingZone *zone)
         
         if (moveFilesToFolder(mimeData, targetFolder, zone)) {
             event->acceptProposedAction();
-            zone->refreshFileList();
         } else {
             event->ignore();
         }
@@ -191,85 +166,14 @@ bool DragDropHandler::moveFilesToFolder(const QMimeData *mimeData, const QString
         return false;
     }
 
-    int successCount = 0;
-    int failCount = 0;
-    QStringList failedFiles;
-
+    QStringList sources;
     for (const QUrl &url : urlList) {
-        QString sourcePath = url.toLocalFile();
-        QFileInfo sourceInfo(sourcePath);
-
-        if (!sourceInfo.exists()) {
-            continue;
-        }
-
-        // Skip if file is already in the target folder
-        if (sourceInfo.absolutePath() == targetDir.absolutePath()) {
-            continue;
-        }
-
-        QString targetPath = targetDir.absoluteFilePath(sourceInfo.fileName());
-
-        // Handle name conflicts
-        if (QFile::exists(targetPath) || QDir(targetPath).exists()) {
-            QString baseName = sourceInfo.completeBaseName();
-            QString suffix = sourceInfo.suffix();
-            int counter = 1;
-
-            do {
-                if (sourceInfo.isDir()) {
-                    targetPath = targetDir.absoluteFilePath(
-                        QString("%1_%2").arg(baseName).arg(counter));
-                } else {
-                    targetPath = targetDir.absoluteFilePath(
-                        QString("%1_%2.%3").arg(baseName).arg(counter).arg(suffix));
-                }
-                counter++;
-            } while (QFile::exists(targetPath) || QDir(targetPath).exists());
-        }
-
-        // Try to move the file/folder
-        bool success = false;
-        if (sourceInfo.isDir()) {
-            // For directories, use QDir::rename
-            success = QDir().rename(sourcePath, targetPath);
-        } else {
-            // For files, try rename first (fast if same drive)
-            success = QFile::rename(sourcePath, targetPath);
-
-            // If rename fails, try copy+delete (for cross-drive moves)
-            if (!success) {
-                if (QFile::copy(sourcePath, targetPath)) {
-                    success = QFile::remove(sourcePath);
-                    if (!success) {
-                        QFile::remove(targetPath); // Clean up copied file
-                    }
-                }
-            }
-        }
-
-        if (success) {
-            successCount++;
-        } else {
-            failCount++;
-            failedFiles.append(sourceInfo.fileName());
+        if (url.isLocalFile()) {
+            sources.append(url.toLocalFile());
         }
     }
 
-    // Only show message if there were failures
-    if (failCount > 0 && parent) {
-        QString msg;
-        if (successCount > 0) {
-            msg = QObject::tr("成功移动 %1 个文件\n失败 %2 个: %3")
-                .arg(successCount)
-                .arg(failCount)
-                .arg(failedFiles.join(", "));
-        } else {
-            msg = QObject::tr("移动失败: %1").arg(failedFiles.join(", "));
-        }
-        QMessageBox::warning(parent, QObject::tr("移动完成"), msg);
-    }
-
-    return successCount > 0;
+    // Moved on worker threads; the target zone lists the items as pending
+    // and failures are reported when the job is done
+    return TransferQueue::instance()->move(sources, targetDir.absolutePath()) != 0;
 }
-
@@ -1,7 +1,7 @@
 #ifndef DRAGDROP_H
 #define DRAGDROP_H
 
-#include <QListWidget>
+#include <QListView>
 #include <QDragEnterEvent>
 #include <QDragMoveEvent>
 #include <QDropEvent>
@@ -10,21 +10,21 @@
 class QWidget;
 class FloatingZone;
 
-// Custom QListWidget to support dragging files out and dropping files onto folders
-class DraggableListWidget : public QListWidget
+// Custom QListView to support dragging files out and dropping files onto folders
+// (drag-out MIME data is produced by ZoneFileModel)
+class DraggableListView : public QListView
 {
     Q_OBJECT
 public:
-    explicit DraggableListWidget(QWidget *parent = nullptr);
+    explicit DraggableListView(QWidget *parent = nullptr);
 
 protected:
-    QMimeData* mimeData(const QList<QListWidgetItem*> items) const override;
     void dragEnterEvent(QDragEnterEvent *event) override;
     void dragMoveEvent(QDragMoveEvent *event) override;
     void dropEvent(QDropEvent *event) override;
 
 private:
-    QString getTargetFolderPath(QListWidgetItem *item);
+    QString getTargetFolderPath(const QModelIndex &index);
     bool moveFilesToFolder(const QMimeData *mimeData, const QString &targetFolder);
 };
 
@@ -0,0 +1,510 @@
+#include "filemodel.h"
+#include "../icons/iconservice.h"
+#include "../trace/tracer.h"
+#include <QDateTime>
+#include <QHash>
+#include <QMimeData>
+#include <QSet>
+#include <QUrl>
+#include <algorithm>
+#include <numeric>
+
+FileEntry FileEntry::fromFileInfo(const QFileInfo &info)
+{
+    FileEntry entry;
+    entry.name = info.fileName();
+    entry.path = info.absoluteFilePath();
+    entry.isDir = info.isDir();
+    entry.size = entry.isDir ? 0 : info.size();
+    entry.mtime = info.lastModified().toMSecsSinceEpoch();
+    return entry;
+}
+
+ZoneFileModel::ZoneFileModel(QObject *parent)
+    : QAbstractListModel(parent)
+{
+    connect(IconService::instance(), &IconService::iconsReady,
+            this, &ZoneFileModel::onIconsReady);
+}
+
+int ZoneFileModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : exposed;
+}
+
+bool ZoneFileModel::canFetchMore(const QModelIndex &parent) const
+{
+    return !parent.isValid() && exposed < rows.size();
+}
+
+void ZoneFileModel::fetchMore(const QModelIndex &parent)
+{
+    if (parent.isValid() || exposed >= rows.size()) {
+        return;
+    }
+
+    const int count = qMin(FETCH_BATCH, rows.size() - exposed);
+    beginInsertRows(QModelIndex(), exposed, exposed + count - 1);
+    exposed += count;
+    endInsertRows();
+}
+
+QVariant ZoneFileModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= exposed) {
+        return QVariant();
+    }
+
+    const Row &row = rows.at(index.row());
+
+    switch (role) {
+    case Qt::DisplayRole:
+        return row.entry.name;
+    case Qt::ToolTipRole:
+    case PathRole:
+        return row.entry.path;
+    case PendingRole:
+        return !pending.isEmpty() && pending.contains(row.entry.path);
+    case Qt::DecorationRole:
+        // Real system icon (supports .lnk, file types, etc.), placeholder until resolved
+        return IconService::instance()->pixmap(row.entry, iconSize, devicePixelRatio);
+    default:
+        return QVariant();
+    }
+}
+
+Qt::ItemFlags ZoneFileModel::flags(const QModelIndex &index) const
+{
+    if (!index.isValid()) {
+        return Qt::NoItemFlags;
+    }
+    return Qt::ItemIsEnabled | Qt::ItemIsSelectable | Qt::ItemIsDragEnabled;
+}
+
+QStringList ZoneFileModel::mimeTypes() const
+{
+    return QStringList() << QStringLiteral("text/uri-list");
+}
+
+QMimeData *ZoneFileModel::mimeData(const QModelIndexList &indexes) const
+{
+    QMimeData *mimeData = new QMimeData();
+    QList<QUrl> urls;
+
+    for (const QModelIndex &index : indexes) {
+        QString filePath = this->filePath(index);
+        if (!filePath.isEmpty()) {
+            urls.append(QUrl::fromLocalFile(filePath));
+        }
+    }
+
+    if (!urls.isEmpty()) {
+        mimeData->setUrls(urls);
+    }
+
+    return mimeData;
+}
+
+Qt::DropActions ZoneFileModel::supportedDragActions() const
+{
+    return Qt::CopyAction | Qt::MoveAction;
+}
+
+QString ZoneFileModel::filePath(const QModelIndex &index) const
+{
+    if (!index.isValid() || index.row() >= exposed) {
+        return QString();
+    }
+    return rows.at(index.row()).entry.path;
+}
+
+void ZoneFileModel::setIconSize(int size)
+{
+    if (iconSize == size) {
+        return;
+    }
+    iconSize = size;
+    if (exposed > 0) {
+        emit dataChanged(index(0), index(exposed - 1), {Qt::DecorationRole});
+    }
+}
+
+void ZoneFileModel::setDevicePixelRatio(qreal dpr)
+{
+    if (qFuzzyCompare(devicePixelRatio, dpr)) {
+        return;
+    }
+    devicePixelRatio = dpr;
+    if (exposed > 0) {
+        emit dataChanged(index(0), index(exposed - 1), {Qt::DecorationRole});
+    }
+}
+
+void ZoneFileModel::onIconsReady(const QStringList &paths)
+{
+    for (const QString &path : paths) {
+        const int row = rowForPath(path);
+        if (row >= 0 && row < exposed) {
+            const QModelIndex changed = index(row);
+            emit dataChanged(changed, changed, {Qt::DecorationRole});
+        }
+    }
+}
+
+int ZoneFileModel::rowForPath(const QString &path) const
+{
+    if (!rowIndexValid) {
+        rowIndex.clear();
+        rowIndex.reserve(rows.size());
+        for (int i = 0; i < rows.size(); ++i) {
+            rowIndex.insert(rows.at(i).entry.path, i);
+        }
+        rowIndexValid = true;
+    }
+    return rowIndex.value(path, -1);
+}
+
+bool ZoneFileModel::lessThan(const FileEntry &a, const FileEntry &b)
+{
+    // Same order as QDir::Name | QDir::DirsFirst
+    if (a.isDir != b.isDir) {
+        return a.isDir;
+    }
+    return a.name.compare(b.name) < 0;
+}
+
+void ZoneFileModel::clear()
+{
+    if (rows.isEmpty()) {
+        return;
+    }
+    beginResetModel();
+    rows.clear();
+    exposed = 0;
+    sorted = true;
+    invalidateRowIndex();
+    endResetModel();
+    emit entriesChanged();
+}
+
+void ZoneFileModel::appendEntries(const QVector<FileEntry> &batch)
+{
+    // Pending entries are merged in by the setEntries() that ends the listing
+    QVector<FileEntry> entries;
+    if (pending.isEmpty()) {
+        entries = batch;
+    } else {
+        for (const FileEntry &entry : batch) {
+            if (!pending.contains(entry.path)) {
+                entries.append(entry);
+            }
+        }
+    }
+    if (entries.isEmpty()) {
+        return;
+    }
+
+    const int first = rows.size();
+    const int visible = newlyVisible(first, entries.size());
+
+    if (visible > 0) {
+        beginInsertRows(QModelIndex(), first, first + visible - 1);
+    }
+    rows.resize(first + entries.size());
+    for (int i = 0; i < entries.size(); ++i) {
+        rows[first + i].entry = entries.at(i);
+    }
+    sorted = false;
+    invalidateRowIndex();
+    if (visible > 0) {
+        exposed += visible;
+        endInsertRows();
+    }
+    emit entriesChanged();
+}
+
+int ZoneFileModel::newlyVisible(int position, int count) const
+{
+    // Inside the exposed window: shown right away
+    if (position < exposed) {
+        return count;
+    }
+    // Appended to a fully exposed list: shown up to one fetch batch,
+    // the rest waits for fetchMore()
+    if (position == exposed && exposed == rows.size()) {
+        return qMin(count, qMax(0, FETCH_BATCH - exposed));
+    }
+    return 0;
+}
+
+void ZoneFileModel::sortRows()
+{
+    emit layoutAboutToBeChanged(QList<QPersistentModelIndex>(), QAbstractItemModel::VerticalSortHint);
+
+    QVector<int> order(rows.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [this](int a, int b) {
+        return lessThan(rows.at(a).entry, rows.at(b).entry);
+    });
+
+    QVector<Row> sortedRows;
+    sortedRows.reserve(rows.size());
+    QVector<int> newRow(rows.size());
+    for (int i = 0; i < order.size(); ++i) {
+        newRow[order.at(i)] = i;
+        sortedRows.append(rows.at(order.at(i)));
+    }
+    rows.swap(sortedRows);
+    invalidateRowIndex();
+
+    // Keep selection and current item attached to the same files
+    const QModelIndexList before = persistentIndexList();
+    QModelIndexList after;
+    after.reserve(before.size());
+    for (const QModelIndex &index : before) {
+        const int moved = index.row() < newRow.size() ? newRow.at(index.row()) : -1;
+        // Rows sorted out of the exposed window are no longer addressable
+        after.append(moved >= 0 && moved < exposed ? this->index(moved) : QModelIndex());
+    }
+    changePersistentIndexList(before, after);
+
+    sorted = true;
+    emit layoutChanged(QList<QPersistentModelIndex>(), QAbstractItemModel::VerticalSortHint);
+}
+
+void ZoneFileModel::setEntries(QVector<FileEntry> entries)
+{
+    TraceSpan span("ZoneFileModel::setEntries", "model");
+
+    // Items still being moved in are kept, as found on disk or as placeholders
+    if (!pending.isEmpty()) {
+        QSet<QString> listed;
+        listed.reserve(entries.size());
+        for (const FileEntry &entry : entries) {
+            listed.insert(entry.path);
+        }
+        for (const FileEntry &entry : pending) {
+            if (!listed.contains(entry.path)) {
+                entries.append(entry);
+            }
+        }
+    }
+
+    std::sort(entries.begin(), entries.end(), &ZoneFileModel::lessThan);
+    if (!sorted) {
+        sortRows();
+    }
+
+    // An entry is identified by its path and kind; a file replaced by a
+    // folder of the same name sorts elsewhere, so treat it as remove + insert.
+    QHash<QString, bool> incoming;
+    incoming.reserve(entries.size());
+    for (const FileEntry &entry : entries) {
+        incoming.insert(entry.path, entry.isDir);
+    }
+
+    auto survives = [&incoming](const Row &row) {
+        auto it = incoming.constFind(row.entry.path);
+        return it != incoming.constEnd() && it.value() == row.entry.isDir;
+    };
+
+    // 1. Remove vanished rows, back to front, one signal per contiguous run
+    int row = rows.size() - 1;
+    while (row >= 0) {
+        if (survives(rows.at(row))) {
+            --row;
+            continue;
+        }
+        int last = row;
+        while (row > 0 && !survives(rows.at(row - 1))) {
+            --row;
+        }
+        // Only the part inside the exposed window is announced
+        const int visibleLast = qMin(last, exposed - 1);
+        if (row <= visibleLast) {
+            beginRemoveRows(QModelIndex(), row, visibleLast);
+        }
+        rows.erase(rows.begin() + row, rows.begin() + last + 1);
+        invalidateRowIndex();
+        if (row <= visibleLast) {
+            exposed -= visibleLast - row + 1;
+            endRemoveRows();
+        }
+        --row;
+    }
+
+    // 2. The surviving rows are now a subsequence of `entries` in the same
+    //    order, so a single merge pass finds every insertion point.
+    row = 0;
+    int changedFirst = -1;
+    int i = 0;
+    const int count = entries.size();
+
+    while (i < count) {
+        if (row < rows.size() && rows.at(row).entry.path == entries.at(i).path) {
+            Row &existing = rows[row];
+            if (!existing.entry.sameContent(entries.at(i))) {
+                existing.entry = entries.at(i);
+                if (changedFirst < 0) {
+                    changedFirst = row;
+                }
+            } else if (changedFirst >= 0) {
+                emitChanged(changedFirst, row - 1);
+                changedFirst = -1;
+            }
+            ++row;
+            ++i;
+            continue;
+        }
+
+        if (changedFirst >= 0) {
+            emitChanged(changedFirst, row - 1);
+            changedFirst = -1;
+        }
+
+        int first = i;
+        while (i < count &&
+               !(row < rows.size() && rows.at(row).entry.path == entries.at(i).path)) {
+            ++i;
+        }
+
+        const int runLength = i - first;
+        const int visible = newlyVisible(row, runLength);
+        if (visible > 0) {
+            beginInsertRows(QModelIndex(), row, row + visible - 1);
+        }
+        rows.insert(row, runLength, Row());
+        invalidateRowIndex();
+        for (int k = 0; k < runLength; ++k) {
+            rows[row + k].entry = entries.at(first + k);
+        }
+        if (visible > 0) {
+            exposed += visible;
+            endInsertRows();
+        }
+        row += runLength;
+    }
+
+    if (changedFirst >= 0) {
+        emitChanged(changedFirst, row - 1);
+    }
+    emit entriesChanged();
+}
+
+bool ZoneFileModel::applyDelta(const QVector<FileEntry> &present, const QStringList &goneNames)
+{
+    TraceSpan span("ZoneFileModel::applyDelta", "model");
+
+    if (!sorted) {
+        return false;
+    }
+
+    for (const QString &name : goneNames) {
+        for (bool isDir : { true, false }) {
+            const int row = findRow(name, isDir);
+            if (row >= 0 && !pending.contains(rows.at(row).entry.path)) {
+                removeRowAt(row);
+            }
+        }
+    }
+
+    for (const FileEntry &entry : present) {
+        // A file replaced by a folder of the same name (or vice versa)
+        const int replaced = findRow(entry.name, !entry.isDir);
+        if (replaced >= 0) {
+            removeRowAt(replaced);
+        }
+
+        const int row = findRow(entry.name, entry.isDir);
+        if (row < 0) {
+            insertRowAt(lowerBound(entry), entry);
+        } else if (!rows.at(row).entry.sameContent(entry)) {
+            rows[row].entry = entry;
+            emitChanged(row, row);
+        }
+    }
+    emit entriesChanged();
+    return true;
+}
+
+void ZoneFileModel::setPending(const FileEntry &entry)
+{
+    pending.insert(entry.path, entry);
+
+    const int row = rowForPath(entry.path);
+    if (row >= 0) {
+        emitChanged(row, row);
+    } else if (sorted) {
+        insertRowAt(lowerBound(entry), entry);
+        emit entriesChanged();
+    }
+    // While a listing is being appended, the final setEntries() adds it
+}
+
+void ZoneFileModel::clearPending(const QString &path)
+{
+    if (pending.remove(path) == 0) {
+        return;
+    }
+    // The row stays until a listing or delta says whether the item exists
+    const int row = rowForPath(path);
+    if (row >= 0) {
+        emitChanged(row, row);
+    }
+}
+
+int ZoneFileModel::lowerBound(const FileEntry &probe) const
+{
+    auto it = std::lower_bound(rows.constBegin(), rows.constEnd(), probe,
+        [](const Row &row, const FileEntry &entry) { return lessThan(row.entry, entry); });
+    return int(it - rows.constBegin());
+}
+
+int ZoneFileModel::findRow(const QString &name, bool isDir) const
+{
+    FileEntry probe;
+    probe.name = name;
+    probe.isDir = isDir;
+
+    const int row = lowerBound(probe);
+    if (row < rows.size() && rows.at(row).entry.isDir == isDir && rows.at(row).entry.name == name) {
+        return row;
+    }
+    return -1;
+}
+
+void ZoneFileModel::insertRowAt(int row, const FileEntry &entry)
+{
+    const bool visible = newlyVisible(row, 1) > 0;
+    if (visible) {
+        beginInsertRows(QModelIndex(), row, row);
+    }
+    rows.insert(row, Row{ entry });
+    invalidateRowIndex();
+    if (visible) {
+        ++exposed;
+        endInsertRows();
+    }
+}
+
+void ZoneFileModel::removeRowAt(int row)
+{
+    const bool visible = row < exposed;
+    if (visible) {
+        beginRemoveRows(QModelIndex(), row, row);
+    }
+    rows.remove(row);
+    invalidateRowIndex();
+    if (visible) {
+        --exposed;
+        endRemoveRows();
+    }
+}
+
+void ZoneFileModel::emitChanged(int first, int last)
+{
+    last = qMin(last, exposed - 1);
+    if (first <= last) {
+        emit dataChanged(index(first), index(last));
+    }
+}
@@ -0,0 +1,136 @@
+#ifndef FILEMODEL_H
+#define FILEMODEL_H
+
+#include <QAbstractListModel>
+#include <QFileInfo>
+#include <QHash>
+#include <QStringList>
+#include <QVector>
+
+// One entry of a zone folder listing.
+// Only what is needed to diff two listings and to display a row is kept;
+// icons come from IconService when the row is painted.
+struct FileEntry
+{
+    QString name;
+    QString path;
+    bool isDir = false;
+    qint64 size = 0;
+    qint64 mtime = 0;   // msecs since epoch
+
+    static FileEntry fromFileInfo(const QFileInfo &info);
+
+    // Same name but different size/mtime means the row needs repainting
+    bool sameContent(const FileEntry &other) const
+    {
+        return size == other.size && mtime == other.mtime;
+    }
+};
+
+// List model backing a zone's file view.
+// New listings are diffed against the current one so that views only see
+// the rowsInserted / rowsRemoved / dataChanged signals for what actually
+// changed; scroll position, selection and cached icons survive a refresh.
+//
+// Rows are exposed to views incrementally: the full listing is kept as
+// plain entries, but only the first FETCH_BATCH rows are visible until the
+// view scrolls down and asks for more through canFetchMore()/fetchMore().
+// Icons and tooltips are produced in data(), i.e. only for painted rows.
+class ZoneFileModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    enum Roles {
+        PathRole = Qt::UserRole,  // absolute path of the entry
+        PendingRole               // bool: still being moved into the folder, or being deleted
+    };
+
+    explicit ZoneFileModel(QObject *parent = nullptr);
+
+    static constexpr int FETCH_BATCH = 512;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    Qt::ItemFlags flags(const QModelIndex &index) const override;
+
+    // Drag-out support: rows are exported as file URLs
+    QStringList mimeTypes() const override;
+    QMimeData *mimeData(const QModelIndexList &indexes) const override;
+    Qt::DropActions supportedDragActions() const override;
+
+    // Replace the current listing with `entries` (any order).
+    // Emits the minimal set of row removals, insertions and changes.
+    void setEntries(QVector<FileEntry> entries);
+    void clear();
+
+    // Append a partial listing as-is while a folder is still being read.
+    // Rows are put in order by the next setEntries().
+    void appendEntries(const QVector<FileEntry> &batch);
+
+    // Apply watcher deltas without a full listing: `present` entries are
+    // inserted or updated in place, `goneNames` are removed.
+    // Returns false (and changes nothing) while rows are not in order yet.
+    bool applyDelta(const QVector<FileEntry> &present, const QStringList &goneNames);
+
+    // Items being transferred into the folder (or deleted from it). A
+    // pending entry is listed (as a placeholder while it does not exist on
+    // disk) and survives listings and deltas that don't contain it, until
+    // clearPending().
+    void setPending(const FileEntry &entry);
+    void clearPending(const QString &path);
+
+    QString filePath(const QModelIndex &index) const;
+
+    // True if the listing holds no entries (exposed or not)
+    bool isEmpty() const { return rows.isEmpty(); }
+    // Number of entries in the listing, exposed or not
+    int entryCount() const { return rows.size(); }
+    // True if the listing has an entry for path, exposed or not
+    bool contains(const QString &path) const { return rowForPath(path) >= 0; }
+
+    // Size and screen scale of the icons handed out for DecorationRole
+    void setIconSize(int size);
+    void setDevicePixelRatio(qreal dpr);
+
+    // Ordering used for every listing: folders first, then by name
+    static bool lessThan(const FileEntry &a, const FileEntry &b);
+
+signals:
+    // The listing changed (including rows not exposed to views yet)
+    void entriesChanged();
+
+private slots:
+    void onIconsReady(const QStringList &paths);
+
+private:
+    struct Row
+    {
+        FileEntry entry;
+    };
+
+    void emitChanged(int first, int last);
+    int newlyVisible(int position, int count) const;
+    int lowerBound(const FileEntry &probe) const;
+    int findRow(const QString &name, bool isDir) const;
+    void insertRowAt(int row, const FileEntry &entry);
+    void removeRowAt(int row);
+    void sortRows();
+    int rowForPath(const QString &path) const;
+    void invalidateRowIndex() { rowIndexValid = false; }
+
+    QVector<Row> rows;
+    QHash<QString, FileEntry> pending;   // path -> placeholder entry
+    int exposed = 0;      // rows [0, exposed) are visible to views
+    bool sorted = true;   // false while unordered batches are being appended
+    int iconSize = 24;
+    qreal devicePixelRatio = 1.0;
+
+    // path -> row, rebuilt lazily after structural changes
+    mutable QHash<QString, int> rowIndex;
+    mutable bool rowIndexValid = false;
+};
+
+#endif // FILEMODEL_H
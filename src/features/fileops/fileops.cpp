@@ -6,8 +6,6 @@
 #include <QFile>
 #include <QClipboard>
 #include <QApplication>
-#include <QJsonDocument>
-#include <QJsonObject>
 #include <QObject>
 #include <QDialog>
 #include <QVBoxLayout>
@@ -15,53 +13,14 @@
 #include <QLabel>
 #include <QLineEdit>
 #include <QPushButton>
+#include "../delete/deletequeue.h"
+#include "../layout/layoutstore.h"
+#include "../trash/trash.h"
 
 // ---------------------------------------------------------------------------
-// Shared dark-theme style
+// Dialogs are named "booxDialog" and styled by the application stylesheet
+// (features/theme); the heading label is "dialogTitle".
 // ---------------------------------------------------------------------------
-static const char *DIALOG_STYLE =
-    "QDialog {"
-    "  background-color: rgba(30, 30, 30, 245);"
-    "  border: 1px solid rgba(255,255,255,60);"
-    "  border-radius: 8px;"
-    "}"
-    "QLabel {"
-    "  color: rgba(255,255,255,200);"
-    "  font-size: 13px;"
-    "  background: transparent;"
-    "}"
-    "QLineEdit {"
-    "  background-color: rgba(255,255,255,15);"
-    "  color: white;"
-    "  border: 1px solid rgba(255,255,255,60);"
-    "  border-radius: 4px;"
-    "  padding: 5px 8px;"
-    "  font-size: 13px;"
-    "}"
-    "QLineEdit:focus {"
-    "  border: 1px solid rgba(255,255,255,120);"
-    "}"
-    "QPushButton {"
-    "  background-color: rgba(255,255,255,20);"
-    "  color: white;"
-    "  border: 1px solid rgba(255,255,255,50);"
-    "  border-radius: 4px;"
-    "  padding: 5px 18px;"
-    "  font-size: 13px;"
-    "}"
-    "QPushButton:hover {"
-    "  background-color: rgba(255,255,255,40);"
-    "}"
-    "QPushButton:pressed {"
-    "  background-color: rgba(255,255,255,60);"
-    "}"
-    "QPushButton#btnConfirm {"
-    "  background-color: rgba(80,120,200,180);"
-    "  border: 1px solid rgba(80,120,200,220);"
-    "}"
-    "QPushButton#btnConfirm:hover {"
-    "  background-color: rgba(80,120,200,230);"
-    "}";
 
 // ---------------------------------------------------------------------------
 // askText: styled replacement for QInputDialog::getText
@@ -72,7 +31,7 @@ static bool askText(QWidget *parent, const QString &title,
                     QString &result)
 {
     QDialog dlg(parent, Qt::Dialog | Qt::FramelessWindowHint);
-    dlg.setStyleSheet(DIALOG_STYLE);
+    dlg.setObjectName("booxDialog");
     dlg.setWindowTitle(title);
     dlg.setFixedWidth(300);
 
@@ -81,7 +40,7 @@ static bool askText(QWidget *parent, const QString &title,
     layout->setSpacing(10);
 
     QLabel *titleLbl = new QLabel(title, &dlg);
-    titleLbl->setStyleSheet("color: white; font-size: 14px; font-weight: bold; background: transparent;");
+    titleLbl->setObjectName("dialogTitle");
     layout->addWidget(titleLbl);
 
     QLabel *lbl = new QLabel(label, &dlg);
@@ -121,7 +80,7 @@ static bool askText(QWidget *parent, const QString &title,
 static void showWarning(QWidget *parent, const QString &title, const QString &message)
 {
     QDialog dlg(parent, Qt::Dialog | Qt::FramelessWindowHint);
-    dlg.setStyleSheet(DIALOG_STYLE);
+    dlg.setObjectName("booxDialog");
     dlg.setWindowTitle(title);
     dlg.setFixedWidth(300);
 
@@ -130,7 +89,8 @@ static void showWarning(QWidget *parent, const QString &title, const QString &me
     layout->setSpacing(10);
 
     QLabel *titleLbl = new QLabel(title, &dlg);
-    titleLbl->setStyleSheet("color: rgba(255,100,100,220); font-size: 14px; font-weight: bold; background: transparent;");
+    titleLbl->setObjectName("dialogTitle");
+    titleLbl->setProperty("warning", true);
     layout->addWidget(titleLbl);
 
     QLabel *msgLbl = new QLabel(message, &dlg);
@@ -159,7 +119,7 @@ static void showWarning(QWidget *parent, const QString &title, const QString &me
 static bool showConfirm(QWidget *parent, const QString &title, const QString &message)
 {
     QDialog dlg(parent, Qt::Dialog | Qt::FramelessWindowHint);
-    dlg.setStyleSheet(DIALOG_STYLE);
+    dlg.setObjectName("booxDialog");
     dlg.setWindowTitle(title);
     dlg.setFixedWidth(300);
 
@@ -168,7 +128,7 @@ static bool showConfirm(QWidget *parent, const QString &title, const QString &me
     layout->setSpacing(10);
 
     QLabel *titleLbl = new QLabel(title, &dlg);
-    titleLbl->setStyleSheet("color: white; font-size: 14px; font-weight: bold; background: transparent;");
+    titleLbl->setObjectName("dialogTitle");
     layout->addWidget(titleLbl);
 
     QLabel *msgLbl = new QLabel(message, &dlg);
@@ -206,29 +166,51 @@ void FileOpsHandler::openFile(const QString &filePath, QWidget *parent)
     }
 }
 
-void FileOpsHandler::deleteFile(const QString &filePath, QWidget *parent,
-                                std::function<void()> onSuccess)
+void FileOpsHandler::deleteFiles(const QStringList &filePaths, QWidget *parent, bool permanently)
 {
-    QFileInfo fileInfo(filePath);
-
-    if (!showConfirm(parent, QObject::tr("确认删除"),
-                     QObject::tr("确定要删除 \"%1\" 吗？").arg(fileInfo.fileName()))) {
+    if (filePaths.isEmpty()) {
         return;
     }
 
-    bool success = false;
-    if (fileInfo.isDir()) {
-        success = QDir(filePath).removeRecursively();
-    } else {
-        success = QFile::remove(filePath);
+    QStringList toDelete = filePaths;
+    if (!permanently) {
+        // Into the trash: instant whatever the size, and undoable
+        toDelete = Trash::instance()->moveToTrash(filePaths);
+        if (toDelete.isEmpty()) {
+            return;
+        }
     }
 
-    if (success) {
-        if (onSuccess) onSuccess();
+    QString message;
+    if (!permanently) {
+        message = toDelete.size() == 1
+            ? QObject::tr("\"%1\" 无法移到回收站，要永久删除吗？").arg(QFileInfo(toDelete.first()).fileName())
+            : QObject::tr("%1 个项目无法移到回收站，要永久删除吗？").arg(toDelete.size());
     } else {
-        showWarning(parent, QObject::tr("错误"),
-                    QObject::tr("无法删除: %1").arg(filePath));
+        message = toDelete.size() == 1
+            ? QObject::tr("确定要永久删除 \"%1\" 吗？").arg(QFileInfo(toDelete.first()).fileName())
+            : QObject::tr("确定要永久删除选中的 %1 个项目吗？").arg(toDelete.size());
+    }
+    if (!showConfirm(parent, QObject::tr("确认删除"), message)) {
+        return;
+    }
+
+    DeleteQueue::instance()->remove(toDelete);
+}
+
+void FileOpsHandler::emptyTrash(const QString &folderPath, QWidget *parent)
+{
+    const QList<TrashEntry> entries = Trash::instance()->entries(folderPath);
+    if (entries.isEmpty()) {
+        showWarning(parent, QObject::tr("清空回收站"), QObject::tr("回收站中没有来自区域的项目"));
+        return;
     }
+
+    if (!showConfirm(parent, QObject::tr("清空回收站"),
+                     QObject::tr("确定要永久删除回收站中来自区域的 %1 个项目吗？").arg(entries.size()))) {
+        return;
+    }
+    Trash::instance()->purge(entries);
 }
 
 void FileOpsHandler::copyFilePath(const QString &filePath)
@@ -263,23 +245,7 @@ void FileOpsHandler::renameFolder(const QString &folderPath, const QString &curr
     }
 
     // Remove stale layout entry for the old path
-    QString layoutFilePath = "d:/boox/.layout.json";
-    QFile layoutFile(layoutFilePath);
-    if (layoutFile.exists() && layoutFile.open(QIODevice::ReadOnly)) {
-        QByteArray data = layoutFile.readAll();
-        layoutFile.close();
-        QJsonDocument doc = QJsonDocument::fromJson(data);
-        if (doc.isObject()) {
-            QJsonObject obj = doc.object();
-            if (obj.contains(folderPath)) {
-                obj.remove(folderPath);
-                if (layoutFile.open(QIODevice::WriteOnly)) {
-                    layoutFile.write(QJsonDocument(obj).toJson(QJsonDocument::Indented));
-                    layoutFile.close();
-                }
-            }
-        }
-    }
+    LayoutStore::instance()->remove(folderPath);
 
     if (onSuccess) onSuccess(newFolderPath);
 }
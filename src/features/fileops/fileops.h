@@ -2,6 +2,7 @@
 #define FILEOPS_H
 
 #include <QString>
+#include <QStringList>
 #include <functional>
 
 class QWidget;
@@ -14,10 +15,16 @@ public:
     // Open file or folder with system default application
     static void openFile(const QString &filePath, QWidget *parent = nullptr);
 
-    // Delete file or folder (with confirmation dialog)
-    // onSuccess is called after successful deletion
-    static void deleteFile(const QString &filePath, QWidget *parent = nullptr,
-                           std::function<void()> onSuccess = nullptr);
+    // Move files and folders to the trash (a rename each; undoable from the
+    // tray), offering to delete what cannot be trashed. With `permanently`,
+    // delete after one confirmation for all: the deletion runs in the
+    // background on DeleteQueue and zones drop each item as it goes.
+    static void deleteFiles(const QStringList &filePaths, QWidget *parent = nullptr,
+                            bool permanently = false);
+
+    // Permanently delete trashed items that came from folderPath (with
+    // confirmation); runs in the background at low priority
+    static void emptyTrash(const QString &folderPath, QWidget *parent = nullptr);
 
     // Copy file path to clipboard
     static void copyFilePath(const QString &filePath);
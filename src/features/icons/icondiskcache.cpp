@@ -0,0 +1,443 @@
+#include "icondiskcache.h"
+#include <QDateTime>
+#include <QSaveFile>
+#include <QSet>
+#include <QVector>
+#include <algorithm>
+#include <cstring>
+#include "../checksum/checksum.h"
+
+namespace {
+
+// On-disk layout (native byte order; the cache never leaves the machine):
+//   Header
+//   FileRecord[fileCount]    sorted by key
+//   ImageRecord[imageCount]
+//   pixel data               ARGB32 premultiplied, 16-byte aligned
+struct Header
+{
+    char magic[8];
+    quint32 version;
+    quint32 fileCount;
+    quint32 imageCount;
+    quint32 tableCrc;       // CRC-32 of both tables
+    quint64 dataOffset;
+    quint64 totalSize;
+    quint64 reserved;
+};
+
+const char MAGIC[8] = { 'B', 'O', 'O', 'X', 'I', 'C', 'O', 'N' };
+constexpr quint32 VERSION = 1;
+constexpr int MAX_ICON_EDGE = 1024;
+
+quint32 nowStamp()
+{
+    return quint32(QDateTime::currentSecsSinceEpoch());
+}
+
+quint16 dprToMilli(qreal dpr)
+{
+    return quint16(qBound(1, qRound(dpr * 1000), 0xFFFF));
+}
+
+qint64 alignUp(qint64 value, qint64 alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+} // namespace
+
+using Checksum::crc32;
+
+IconDiskCache::IconDiskCache(const QString &filePath)
+    : filePath(filePath)
+{
+    static_assert(sizeof(Header) == 48, "unexpected header layout");
+    static_assert(sizeof(FileRecord) == 16, "unexpected file record layout");
+    static_assert(sizeof(ImageRecord) == 24, "unexpected image record layout");
+
+    open();
+}
+
+IconDiskCache::~IconDiskCache()
+{
+    close();
+}
+
+quint64 IconDiskCache::entryKey(const FileEntry &entry, int size, qreal dpr)
+{
+    // FNV-1a: stable across runs, unlike qHash
+    quint64 hash = 14695981039346656037ULL;
+    auto mix = [&hash](const void *data, size_t length) {
+        const uchar *bytes = static_cast<const uchar *>(data);
+        for (size_t i = 0; i < length; ++i) {
+            hash ^= bytes[i];
+            hash *= 1099511628211ULL;
+        }
+    };
+
+    mix(entry.path.constData(), size_t(entry.path.size()) * sizeof(QChar));
+    mix(&entry.mtime, sizeof(entry.mtime));
+    mix(&entry.size, sizeof(entry.size));
+    const qint32 iconSize = size;
+    const quint16 dprMilli = dprToMilli(dpr);
+    mix(&iconSize, sizeof(iconSize));
+    mix(&dprMilli, sizeof(dprMilli));
+    return hash;
+}
+
+void IconDiskCache::open()
+{
+    file.setFileName(filePath);
+    if (!file.exists() || !file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+
+    const qint64 size = file.size();
+    if (size < qint64(sizeof(Header))) {
+        close();
+        return;
+    }
+
+    uchar *data = file.map(0, size);
+    if (!data) {
+        close();
+        return;
+    }
+    mapped = data;
+    mappedSize = size;
+
+    Header header;
+    std::memcpy(&header, data, sizeof(header));
+
+    bool ok = std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0
+           && header.version == VERSION
+           && header.totalSize == quint64(size)
+           && header.fileCount <= quint32(MAX_FILES)
+           && header.imageCount <= header.fileCount;
+
+    const qint64 tablesEnd = qint64(sizeof(Header))
+                           + qint64(header.fileCount) * qint64(sizeof(FileRecord))
+                           + qint64(header.imageCount) * qint64(sizeof(ImageRecord));
+    ok = ok && tablesEnd <= qint64(header.dataOffset)
+            && qint64(header.dataOffset) <= size
+            && header.dataOffset % 16 == 0;
+    ok = ok && crc32(data + sizeof(Header), tablesEnd - qint64(sizeof(Header))) == header.tableCrc;
+
+    if (ok) {
+        fileTable = reinterpret_cast<const FileRecord *>(data + sizeof(Header));
+        fileCount = header.fileCount;
+        imageTable = reinterpret_cast<const ImageRecord *>(fileTable + fileCount);
+        imageCount = header.imageCount;
+
+        for (quint32 i = 0; ok && i < imageCount; ++i) {
+            const ImageRecord &image = imageTable[i];
+            const qint64 bytes = qint64(image.width) * image.height * 4;
+            ok = image.width > 0 && image.width <= MAX_ICON_EDGE
+              && image.height > 0 && image.height <= MAX_ICON_EDGE
+              && image.offset >= header.dataOffset
+              && image.offset % 4 == 0
+              && qint64(image.offset) + bytes <= size;
+        }
+        for (quint32 i = 0; ok && i < fileCount; ++i) {
+            ok = fileTable[i].image < imageCount
+              && (i == 0 || fileTable[i - 1].key < fileTable[i].key);
+        }
+    }
+
+    // Unreadable or damaged: start empty, the next save rewrites it
+    if (!ok) {
+        close();
+    }
+}
+
+void IconDiskCache::close()
+{
+    if (mapped) {
+        file.unmap(const_cast<uchar *>(mapped));
+    }
+    file.close();
+    mapped = nullptr;
+    mappedSize = 0;
+    fileTable = nullptr;
+    fileCount = 0;
+    imageTable = nullptr;
+    imageCount = 0;
+    mappedPixmaps.clear();
+}
+
+const IconDiskCache::FileRecord *IconDiskCache::findMapped(quint64 key) const
+{
+    if (!fileTable) {
+        return nullptr;
+    }
+    const FileRecord *end = fileTable + fileCount;
+    const FileRecord *it = std::lower_bound(fileTable, end, key,
+        [](const FileRecord &record, quint64 k) { return record.key < k; });
+    return (it != end && it->key == key) ? it : nullptr;
+}
+
+QPixmap IconDiskCache::mappedPixmap(quint32 image)
+{
+    auto it = mappedPixmaps.constFind(image);
+    if (it != mappedPixmaps.constEnd()) {
+        return it.value();
+    }
+
+    // First use of this icon: verify its pixels before trusting them
+    QPixmap pixmap;
+    const ImageRecord &record = imageTable[image];
+    const uchar *pixels = mapped + record.offset;
+    const qint64 bytes = qint64(record.width) * record.height * 4;
+    if (crc32(pixels, bytes) == record.crc) {
+        QImage view(pixels, record.width, record.height, record.width * 4,
+                    QImage::Format_ARGB32_Premultiplied);
+        pixmap = QPixmap::fromImage(view);
+        pixmap.setDevicePixelRatio(record.dprMilli / 1000.0);
+    }
+
+    mappedPixmaps.insert(image, pixmap);
+    return pixmap;
+}
+
+QPixmap IconDiskCache::lookup(const FileEntry &entry, int size, qreal dpr)
+{
+    const quint64 key = entryKey(entry, size, dpr);
+    const FileRecord *record = findMapped(key);
+    if (!record) {
+        return QPixmap();
+    }
+
+    QPixmap pixmap = mappedPixmap(record->image);
+    if (!pixmap.isNull()) {
+        touch(key);
+    }
+    return pixmap;
+}
+
+void IconDiskCache::store(const FileEntry &entry, int size, qreal dpr,
+                          const QString &imageKey, const QPixmap &pixmap)
+{
+    if (pixmap.isNull()) {
+        return;
+    }
+
+    const quint64 key = entryKey(entry, size, dpr);
+    const quint32 now = nowStamp();
+
+    auto pending = pendingFiles.find(key);
+    if (pending != pendingFiles.end()) {
+        pending->lastUsed = now;
+        if (pending->imageKey != imageKey) {
+            pending->imageKey = imageKey;
+            cacheImage(imageKey, pixmap);
+            dirty = true;
+        }
+        return;
+    }
+
+    if (verified.contains(key)) {
+        touch(key);
+        return;
+    }
+
+    cacheImage(imageKey, pixmap);
+
+    if (const FileRecord *record = findMapped(key)) {
+        // Mapped entries are painted before the real icon is known; keep the
+        // stored pixels unless they turn out to differ from the real icon.
+        const QImage &image = pendingImages[imageKey];
+        const ImageRecord &stored = imageTable[record->image];
+        if (stored.width == image.width() && stored.height == image.height()
+            && crc32(image.constBits(), qint64(image.width()) * image.height() * 4) == stored.crc) {
+            verified.insert(key);
+            touch(key);
+            return;
+        }
+    }
+
+    pendingFiles.insert(key, PendingFile{ imageKey, now });
+    dirty = true;
+}
+
+void IconDiskCache::touch(quint64 key)
+{
+    // A new stamp is a change too: save() must persist the recency order
+    touched.insert(key, nowStamp());
+    dirty = true;
+}
+
+void IconDiskCache::cacheImage(const QString &imageKey, const QPixmap &pixmap)
+{
+    if (!pendingImages.contains(imageKey)) {
+        pendingImages.insert(imageKey,
+            pixmap.toImage().convertToFormat(QImage::Format_ARGB32_Premultiplied));
+    }
+}
+
+bool IconDiskCache::save()
+{
+    if (!dirty) {
+        return true;
+    }
+
+    // Everything we know, newest first; this session's entries win over mapped ones
+    struct Candidate
+    {
+        quint64 key;
+        quint32 lastUsed;
+        qint64 mappedImage;     // index into imageTable, or -1
+        QString pendingImage;   // key into pendingImages
+    };
+
+    QVector<Candidate> candidates;
+    candidates.reserve(int(fileCount) + pendingFiles.size());
+    for (quint32 i = 0; i < fileCount; ++i) {
+        const FileRecord &record = fileTable[i];
+        if (pendingFiles.contains(record.key)) {
+            continue;
+        }
+        candidates.append(Candidate{ record.key, touched.value(record.key, record.lastUsed),
+                                     qint64(record.image), QString() });
+    }
+    for (auto it = pendingFiles.constBegin(); it != pendingFiles.constEnd(); ++it) {
+        candidates.append(Candidate{ it.key(), it->lastUsed, -1, it->imageKey });
+    }
+    std::stable_sort(candidates.begin(), candidates.end(),
+                     [](const Candidate &a, const Candidate &b) { return a.lastUsed > b.lastUsed; });
+
+    // Keep the most recently used entries within the limits
+    struct OutImage
+    {
+        const uchar *pixels;
+        quint16 width;
+        quint16 height;
+        quint16 dprMilli;
+        quint32 crc;
+    };
+
+    QVector<FileRecord> outFiles;
+    QVector<OutImage> outImages;
+    QHash<qint64, quint32> mappedIds;
+    QHash<QString, quint32> pendingIds;
+    QSet<qint64> badMapped;
+    qint64 imageBytes = 0;
+
+    for (const Candidate &candidate : candidates) {
+        if (outFiles.size() >= MAX_FILES) {
+            break;
+        }
+
+        quint32 id;
+        if (candidate.mappedImage >= 0) {
+            if (badMapped.contains(candidate.mappedImage)) {
+                continue;
+            }
+            auto known = mappedIds.constFind(candidate.mappedImage);
+            if (known != mappedIds.constEnd()) {
+                id = known.value();
+            } else {
+                const ImageRecord &record = imageTable[candidate.mappedImage];
+                const qint64 bytes = qint64(record.width) * record.height * 4;
+                const uchar *pixels = mapped + record.offset;
+                if (crc32(pixels, bytes) != record.crc) {
+                    badMapped.insert(candidate.mappedImage);
+                    continue;
+                }
+                if (imageBytes + bytes > MAX_IMAGE_BYTES) {
+                    continue;
+                }
+                imageBytes += bytes;
+                id = quint32(outImages.size());
+                outImages.append(OutImage{ pixels, record.width, record.height,
+                                           record.dprMilli, record.crc });
+                mappedIds.insert(candidate.mappedImage, id);
+            }
+        } else {
+            auto known = pendingIds.constFind(candidate.pendingImage);
+            if (known != pendingIds.constEnd()) {
+                id = known.value();
+            } else {
+                const QImage &image = pendingImages[candidate.pendingImage];
+                if (image.isNull() || image.width() > MAX_ICON_EDGE || image.height() > MAX_ICON_EDGE) {
+                    continue;
+                }
+                const qint64 bytes = qint64(image.width()) * image.height() * 4;
+                if (imageBytes + bytes > MAX_IMAGE_BYTES) {
+                    continue;
+                }
+                imageBytes += bytes;
+                id = quint32(outImages.size());
+                outImages.append(OutImage{ image.constBits(), quint16(image.width()),
+                                           quint16(image.height()),
+                                           dprToMilli(image.devicePixelRatio()),
+                                           crc32(image.constBits(), bytes) });
+                pendingIds.insert(candidate.pendingImage, id);
+            }
+        }
+        outFiles.append(FileRecord{ candidate.key, id, candidate.lastUsed });
+    }
+
+    std::sort(outFiles.begin(), outFiles.end(),
+              [](const FileRecord &a, const FileRecord &b) { return a.key < b.key; });
+
+    // Serialize
+    QVector<ImageRecord> imageRecords;
+    imageRecords.reserve(outImages.size());
+
+    const qint64 tablesEnd = qint64(sizeof(Header))
+                           + qint64(outFiles.size()) * qint64(sizeof(FileRecord))
+                           + qint64(outImages.size()) * qint64(sizeof(ImageRecord));
+    const qint64 dataOffset = alignUp(tablesEnd, 16);
+    qint64 offset = dataOffset;
+    for (const OutImage &image : outImages) {
+        ImageRecord record{};
+        record.offset = quint64(offset);
+        record.width = image.width;
+        record.height = image.height;
+        record.dprMilli = image.dprMilli;
+        record.crc = image.crc;
+        imageRecords.append(record);
+        offset = alignUp(offset + qint64(image.width) * image.height * 4, 16);
+    }
+
+    QByteArray blob(int(offset), '\0');
+    uchar *out = reinterpret_cast<uchar *>(blob.data());
+
+    std::memcpy(out + sizeof(Header), outFiles.constData(), outFiles.size() * sizeof(FileRecord));
+    std::memcpy(out + sizeof(Header) + outFiles.size() * sizeof(FileRecord),
+                imageRecords.constData(), imageRecords.size() * sizeof(ImageRecord));
+    for (int i = 0; i < outImages.size(); ++i) {
+        const OutImage &image = outImages.at(i);
+        std::memcpy(out + imageRecords.at(i).offset, image.pixels,
+                    size_t(image.width) * image.height * 4);
+    }
+
+    Header header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.fileCount = quint32(outFiles.size());
+    header.imageCount = quint32(outImages.size());
+    header.tableCrc = crc32(out + sizeof(Header), tablesEnd - qint64(sizeof(Header)));
+    header.dataOffset = quint64(dataOffset);
+    header.totalSize = quint64(offset);
+    std::memcpy(out, &header, sizeof(header));
+
+    // The mapping must go before the file is replaced (required on Windows);
+    // the pixels it referenced have been copied into blob above.
+    close();
+
+    QSaveFile saveFile(filePath);
+    bool ok = saveFile.open(QIODevice::WriteOnly)
+           && saveFile.write(blob) == blob.size()
+           && saveFile.commit();
+
+    touched.clear();
+    verified.clear();
+    pendingFiles.clear();
+    pendingImages.clear();
+    dirty = false;
+
+    open();
+    return ok;
+}
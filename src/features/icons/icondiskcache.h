@@ -0,0 +1,101 @@
+#ifndef ICONDISKCACHE_H
+#define ICONDISKCACHE_H
+
+#include <QFile>
+#include <QHash>
+#include <QImage>
+#include <QPixmap>
+#include <QSet>
+#include <QString>
+#include "../filemodel/filemodel.h"
+
+// Persistent icon cache shared by all zones (<boox root>/.iconcache).
+// Lets a cold start paint real icons immediately instead of placeholders.
+//
+// Entries are keyed by path + mtime + size + icon size + device pixel ratio,
+// so an entry never outlives the file state it was rendered for. Pixel data
+// is stored once per distinct icon and referenced by every file using it.
+//
+// The file is memory-mapped on open; only the header and index tables are
+// checked up front, each icon's checksum is verified the first time it is
+// used. Anything that does not check out is treated as a miss, and a damaged
+// file is simply rebuilt on the next save. save() keeps the most recently used
+// entries within MAX_FILES / MAX_IMAGE_BYTES and replaces the file atomically;
+// entries used this session are written with their new LRU stamp.
+class IconDiskCache
+{
+public:
+    static constexpr int MAX_FILES = 50000;
+    static constexpr qint64 MAX_IMAGE_BYTES = 8 * 1024 * 1024;
+
+    explicit IconDiskCache(const QString &filePath);
+    ~IconDiskCache();
+
+    // Cached icon for entry, or a null pixmap
+    QPixmap lookup(const FileEntry &entry, int size, qreal dpr);
+
+    // Remember the icon rendered for entry. imageKey identifies the rendered
+    // icon (same key = same pixels), so shared icons are converted only once.
+    void store(const FileEntry &entry, int size, qreal dpr,
+               const QString &imageKey, const QPixmap &pixmap);
+
+    // Write the cache back to disk if anything changed
+    bool save();
+
+private:
+    struct FileRecord
+    {
+        quint64 key;
+        quint32 image;
+        quint32 lastUsed;
+    };
+
+    struct ImageRecord
+    {
+        quint64 offset;
+        quint16 width;
+        quint16 height;
+        quint16 dprMilli;
+        quint16 reserved;
+        quint32 crc;
+        quint32 reserved2;
+    };
+
+    struct PendingFile
+    {
+        QString imageKey;
+        quint32 lastUsed;
+    };
+
+    void open();
+    void close();
+    const FileRecord *findMapped(quint64 key) const;
+    QPixmap mappedPixmap(quint32 image);
+    // Mark a mapped entry as used now
+    void touch(quint64 key);
+    void cacheImage(const QString &imageKey, const QPixmap &pixmap);
+
+    static quint64 entryKey(const FileEntry &entry, int size, qreal dpr);
+
+    QString filePath;
+    QFile file;
+    const uchar *mapped = nullptr;
+    qint64 mappedSize = 0;
+    const FileRecord *fileTable = nullptr;
+    quint32 fileCount = 0;
+    const ImageRecord *imageTable = nullptr;
+    quint32 imageCount = 0;
+
+    // Mapped images already converted (or found corrupt: null pixmap)
+    QHash<quint32, QPixmap> mappedPixmaps;
+    // LRU stamps of mapped entries used this session
+    QHash<quint64, quint32> touched;
+    // Mapped entries confirmed to match the real icon this session
+    QSet<quint64> verified;
+    // Entries and images added this session
+    QHash<quint64, PendingFile> pendingFiles;
+    QHash<QString, QImage> pendingImages;
+    bool dirty = false;
+};
+
+#endif // ICONDISKCACHE_H
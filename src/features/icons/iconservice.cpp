@@ -0,0 +1,338 @@
+#include "iconservice.h"
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QMimeDatabase>
+#include <QMimeType>
+#include <QRunnable>
+#include "../trace/tracer.h"
+
+namespace {
+
+// File types whose icon is stored in (or defined by) the file itself
+const QSet<QString> &perFileSuffixes()
+{
+    static const QSet<QString> suffixes = {
+        QStringLiteral("exe"), QStringLiteral("lnk"), QStringLiteral("ico"),
+        QStringLiteral("url"), QStringLiteral("cur"), QStringLiteral("ani"),
+        QStringLiteral("desktop")
+    };
+    return suffixes;
+}
+
+const QString KEY_DIR = QStringLiteral("dir");
+const QString PREFIX_EXT = QStringLiteral("ext:");
+const QString PREFIX_MIME = QStringLiteral("mime:");
+const QString PREFIX_FILE = QStringLiteral("file:");
+const QString PREFIX_SNIFF = QStringLiteral("sniff:");
+
+// Per-file icons resolved per queue run on the GUI thread, and the time a
+// run may take, so a folder full of .lnk files does not stall the event loop
+constexpr int PER_FILE_ICONS_PER_RUN = 32;
+constexpr qint64 PER_FILE_RUN_BUDGET_MS = 8;
+
+// Pixmap cache budget, in KiB
+constexpr int PIXMAP_CACHE_KB = 32 * 1024;
+// Per-file icon budget, in KiB of image data
+constexpr int FILE_ICON_CACHE_KB = 16 * 1024;
+// Suffix-less files whose sniffed type is remembered
+constexpr int MAX_SNIFFED_FILES = 8192;
+
+// Cache cost of an icon whose sizes are unknown (scalable), in KiB
+constexpr int SCALABLE_ICON_COST_KB = 64;
+
+int iconCostKb(const QIcon &icon)
+{
+    qint64 bytes = 0;
+    for (const QSize &size : icon.availableSizes()) {
+        bytes += qint64(size.width()) * size.height() * 4;
+    }
+    return bytes > 0 ? int(qMax<qint64>(1, bytes / 1024)) : SCALABLE_ICON_COST_KB;
+}
+
+// Identifies the state of the file an entry was listed with
+QString fileStamp(const FileEntry &entry)
+{
+    return QLatin1Char('@') + QString::number(entry.mtime)
+         + QLatin1Char(':') + QString::number(entry.size);
+}
+
+} // namespace
+
+// Resolves MIME types for a batch of type keys on the worker pool
+class MimeLookupTask : public QRunnable
+{
+public:
+    MimeLookupTask(IconService *service, const QHash<QString, QString> &requests)
+        : service(service), requests(requests)
+    {
+    }
+
+    void run() override
+    {
+        TraceSpan span("IconService::lookupMime", "icons");
+
+        QMimeDatabase db;
+        QHash<QString, IconService::MimeResult> results;
+
+        for (auto it = requests.constBegin(); it != requests.constEnd(); ++it) {
+            const QString &requestKey = it.key();
+            const QString &path = it.value();
+
+            QMimeType mime;
+            IconService::MimeResult result;
+            if (requestKey.startsWith(PREFIX_SNIFF)) {
+                // No suffix: look at the content
+                mime = db.mimeTypeForFile(path);
+                result.key = PREFIX_MIME + mime.name();
+            } else {
+                // Suffix only, no I/O
+                mime = db.mimeTypeForFile(path, QMimeDatabase::MatchExtension);
+                result.key = requestKey;
+            }
+            result.iconName = mime.iconName();
+            result.genericIconName = mime.genericIconName();
+            result.samplePath = path;
+            results.insert(requestKey, result);
+        }
+
+        IconService *target = service;
+        QMetaObject::invokeMethod(service, [target, results]() {
+            target->onMimeResolved(results);
+        }, Qt::QueuedConnection);
+    }
+
+private:
+    IconService *service;
+    QHash<QString, QString> requests;
+};
+
+IconService *IconService::instance()
+{
+    static IconService *service = new IconService(QCoreApplication::instance());
+    return service;
+}
+
+IconService::IconService(QObject *parent)
+    : QObject(parent)
+    , fileIcons(FILE_ICON_CACHE_KB)
+    , sniffedKeys(MAX_SNIFFED_FILES)
+    , pixmaps(PIXMAP_CACHE_KB)
+{
+    pool.setMaxThreadCount(1);
+
+    queueTimer.setSingleShot(true);
+    connect(&queueTimer, &QTimer::timeout, this, &IconService::processQueue);
+
+    connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit, this, [this]() {
+        if (diskCache) {
+            diskCache->save();
+        }
+    });
+
+    folderPlaceholder = provider.icon(QFileIconProvider::Folder);
+    filePlaceholder = provider.icon(QFileIconProvider::File);
+    icons.insert(KEY_DIR, folderPlaceholder);
+}
+
+IconService::~IconService()
+{
+    pool.waitForDone();
+}
+
+QString IconService::typeKey(const FileEntry &entry)
+{
+    if (entry.isDir) {
+        return KEY_DIR;
+    }
+
+    const int dot = entry.name.lastIndexOf(QLatin1Char('.'));
+    const QString suffix = dot > 0 ? entry.name.mid(dot + 1).toLower() : QString();
+
+    if (perFileSuffixes().contains(suffix)) {
+        return PREFIX_FILE + entry.path + fileStamp(entry);
+    }
+    if (!suffix.isEmpty()) {
+        return PREFIX_EXT + suffix;
+    }
+
+    const QString file = entry.path + fileStamp(entry);
+    if (const QString *sniffed = sniffedKeys.object(file)) {
+        return *sniffed;
+    }
+    return PREFIX_SNIFF + file;
+}
+
+bool IconService::findIcon(const QString &key, QIcon &icon)
+{
+    if (key.startsWith(PREFIX_FILE)) {
+        if (const QIcon *cached = fileIcons.object(key)) {
+            icon = *cached;
+            return true;
+        }
+        return false;
+    }
+
+    auto it = icons.constFind(key);
+    if (it == icons.constEnd()) {
+        return false;
+    }
+    icon = it.value();
+    return true;
+}
+
+void IconService::openDiskCache(const QString &filePath)
+{
+    TraceSpan span("IconService::openDiskCache", "startup");
+
+    if (diskCache) {
+        diskCache->save();
+    }
+    diskCache.reset(new IconDiskCache(filePath));
+}
+
+QPixmap IconService::pixmap(const FileEntry &entry, int size, qreal dpr)
+{
+    const QString key = typeKey(entry);
+    const QString cacheKey = pixmapKey(key, size, dpr);
+
+    // A rendered pixmap outlives an evicted per-file icon
+    QIcon icon;
+    if (pixmaps.contains(cacheKey) || findIcon(key, icon)) {
+        QPixmap pm = render(icon, cacheKey, size, dpr);
+        // Only the first real paint of an entry is stored, not every repaint
+        if (diskCache && !entry.isDir && freshPaths.remove(entry.path)) {
+            diskCache->store(entry, size, dpr, cacheKey, pm);
+        }
+        return pm;
+    }
+
+    request(key, entry);
+
+    // Painted in a previous run: show that until the type is resolved
+    if (diskCache) {
+        QPixmap cached = diskCache->lookup(entry, size, dpr);
+        if (!cached.isNull()) {
+            return cached;
+        }
+    }
+
+    return entry.isDir ? render(folderPlaceholder, pixmapKey(QStringLiteral("placeholder:dir"), size, dpr), size, dpr)
+                       : render(filePlaceholder, pixmapKey(QStringLiteral("placeholder:file"), size, dpr), size, dpr);
+}
+
+void IconService::request(const QString &key, const FileEntry &entry)
+{
+    waiting[key].insert(entry.path);
+
+    if (inFlight.contains(key) || queued.contains(key)) {
+        return;
+    }
+    queued.insert(key, entry.path);
+
+    if (!queueTimer.isActive()) {
+        queueTimer.start(0);
+    }
+}
+
+void IconService::processQueue()
+{
+    QHash<QString, QString> mimeRequests;
+    int perFileBudget = PER_FILE_ICONS_PER_RUN;
+    QElapsedTimer runTime;
+    runTime.start();
+
+    for (auto it = queued.begin(); it != queued.end(); ) {
+        if (it.key().startsWith(PREFIX_FILE)) {
+            if (perFileBudget == 0 || runTime.elapsed() >= PER_FILE_RUN_BUDGET_MS) {
+                ++it;
+                continue;
+            }
+            // Icon comes from the file itself: only the system provider knows
+            // it, and QFileIconProvider (SHGetFileInfo, HICON -> QPixmap on
+            // Windows) may only be used on the GUI thread
+            --perFileBudget;
+            TraceSpan span("IconService::fileIcon", "icons");
+            const QIcon icon = provider.icon(QFileInfo(it.value()));
+            fileIcons.insert(it.key(), new QIcon(icon), iconCostKb(icon));
+            const QString key = it.key();
+            it = queued.erase(it);
+            notifyReady(key);
+        } else {
+            mimeRequests.insert(it.key(), it.value());
+            inFlight.insert(it.key());
+            it = queued.erase(it);
+        }
+    }
+
+    if (!mimeRequests.isEmpty()) {
+        pool.start(new MimeLookupTask(this, mimeRequests));
+    }
+
+    // Per-file icons left over for the next run
+    if (!queued.isEmpty()) {
+        queueTimer.start(0);
+    }
+}
+
+void IconService::onMimeResolved(const QHash<QString, MimeResult> &results)
+{
+    for (auto it = results.constBegin(); it != results.constEnd(); ++it) {
+        const QString &requestKey = it.key();
+        const MimeResult &result = it.value();
+        inFlight.remove(requestKey);
+
+        if (requestKey.startsWith(PREFIX_SNIFF)) {
+            sniffedKeys.insert(requestKey.mid(PREFIX_SNIFF.size()), new QString(result.key));
+        }
+
+        if (!icons.contains(result.key)) {
+            QIcon icon = QIcon::fromTheme(result.iconName);
+            if (icon.isNull()) {
+                icon = QIcon::fromTheme(result.genericIconName);
+            }
+            if (icon.isNull()) {
+                // No icon theme (e.g. Windows): ask the system once per type
+                icon = provider.icon(QFileInfo(result.samplePath));
+            }
+            icons.insert(result.key, icon);
+        }
+
+        notifyReady(requestKey);
+    }
+}
+
+void IconService::notifyReady(const QString &requestKey)
+{
+    const QSet<QString> paths = waiting.take(requestKey);
+    if (!paths.isEmpty()) {
+        if (diskCache) {
+            freshPaths.unite(paths);
+        }
+        emit iconsReady(paths.values());
+    }
+}
+
+QString IconService::pixmapKey(const QString &typeKey, int size, qreal dpr)
+{
+    return typeKey + QLatin1Char('@') + QString::number(size)
+         + QLatin1Char('@') + QString::number(dpr);
+}
+
+QPixmap IconService::render(const QIcon &icon, const QString &cacheKey, int size, qreal dpr)
+{
+    if (QPixmap *cached = pixmaps.object(cacheKey)) {
+        return *cached;
+    }
+
+    const QSize physical(qRound(size * dpr), qRound(size * dpr));
+    QPixmap pm = icon.pixmap(physical);
+    if (!pm.isNull() && pm.size() != physical) {
+        pm = pm.scaled(physical, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+    }
+    pm.setDevicePixelRatio(dpr);
+
+    const int costKb = qMax(1, pm.width() * pm.height() * 4 / 1024);
+    pixmaps.insert(cacheKey, new QPixmap(pm), costKb);
+    return pm;
+}
@@ -0,0 +1,107 @@
+#ifndef ICONSERVICE_H
+#define ICONSERVICE_H
+
+#include <QObject>
+#include <QCache>
+#include <QFileIconProvider>
+#include <QHash>
+#include <QIcon>
+#include <QPixmap>
+#include <QSet>
+#include <QStringList>
+#include <QThreadPool>
+#include <QTimer>
+#include <memory>
+#include "../filemodel/filemodel.h"
+#include "icondiskcache.h"
+
+// Shared icon lookup for all zones.
+// Icons are keyed by file type rather than by file: all ".pdf" files share
+// one icon, and files without a suffix share the icon of their sniffed MIME
+// type. Only types whose icon lives in the file itself (.exe, .lnk, .ico,
+// .desktop, ...) are resolved per file.
+// MIME detection runs on a worker thread; per-file icons come from the
+// system icon provider, which is GUI-thread-only, and are resolved in small
+// time-boxed batches from the event loop. Until an icon is known callers get
+// a generic file/folder placeholder and iconsReady() later reports the paths
+// whose icon became available. Rendered pixmaps are cached per icon size and
+// device pixel ratio, so list (24px) and grid (48px) mode both hit the cache.
+// Everything kept per file (sniffed types, per-file icons and their pixmaps)
+// is keyed by path + mtime + size, so a file replaced on disk gets a fresh
+// lookup as soon as a watcher delta updates its entry, and lives in bounded
+// caches, so entries of files long gone are evicted.
+// With a disk cache attached, icons painted in a previous run are served
+// straight from it while their type is still being resolved, and an icon is
+// written to it when it first replaces a placeholder (or a cached icon).
+// Files that show up after their type is known are not stored: their icon
+// resolves without I/O on the next start.
+class IconService : public QObject
+{
+    Q_OBJECT
+
+public:
+    static IconService *instance();
+
+    // Icon for entry at `size` logical pixels on a `dpr` screen.
+    // Never blocks on I/O; returns a placeholder while the type is unresolved.
+    QPixmap pixmap(const FileEntry &entry, int size, qreal dpr);
+
+    // Persist icons in `filePath` across restarts (saved on quit)
+    void openDiskCache(const QString &filePath);
+
+signals:
+    // Real icons are now available for these paths
+    void iconsReady(const QStringList &paths);
+
+private:
+    friend class MimeLookupTask;
+
+    explicit IconService(QObject *parent = nullptr);
+    ~IconService() override;
+
+    struct MimeResult
+    {
+        QString key;            // resolved type key
+        QString iconName;
+        QString genericIconName;
+        QString samplePath;     // a file of this type, for the system fallback
+    };
+
+    QString typeKey(const FileEntry &entry);
+    void request(const QString &key, const FileEntry &entry);
+    void processQueue();
+    void onMimeResolved(const QHash<QString, MimeResult> &results);
+    bool findIcon(const QString &key, QIcon &icon);
+    void notifyReady(const QString &requestKey);
+    QPixmap render(const QIcon &icon, const QString &cacheKey, int size, qreal dpr);
+    static QString pixmapKey(const QString &typeKey, int size, qreal dpr);
+
+    QFileIconProvider provider;
+    QThreadPool pool;
+    QTimer queueTimer;
+
+    // Type key ("dir", "ext:pdf", "mime:text/plain") -> icon
+    QHash<QString, QIcon> icons;
+    // Per-file key ("file:<path>@<mtime>:<size>") -> icon, cost in KiB
+    QCache<QString, QIcon> fileIcons;
+    // Suffix-less files: "<path>@<mtime>:<size>" -> sniffed type key
+    QCache<QString, QString> sniffedKeys;
+    // Pixmaps per (type key, size, dpr)
+    QCache<QString, QPixmap> pixmaps;
+
+    // Work waiting for the next queue run: type key -> a path of that type
+    QHash<QString, QString> queued;
+    // Type key -> paths painted with a placeholder while it resolves
+    QHash<QString, QSet<QString>> waiting;
+    // Keys handed to the worker and not back yet
+    QSet<QString> inFlight;
+    // Paths whose real icon became available and has not been painted yet
+    QSet<QString> freshPaths;
+
+    QIcon folderPlaceholder;
+    QIcon filePlaceholder;
+
+    std::unique_ptr<IconDiskCache> diskCache;
+};
+
+#endif // ICONSERVICE_H
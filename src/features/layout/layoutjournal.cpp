@@ -0,0 +1,411 @@
+#include "layoutjournal.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QtEndian>
+#include "../checksum/checksum.h"
+
+#if defined(Q_OS_WIN)
+#include <io.h>
+#elif defined(Q_OS_UNIX)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// File layout (little endian):
+//   snapshot: magic "BOOXLS01", u64 generation, u32 count, u32 crc(body), body
+//   journal:  magic "BOOXLJ01", u64 generation, record...
+// where body is `count` records and each record is framed as
+//   u32 payload length, u32 crc(payload), payload
+//   payload: u8 op, u8 flags, i32 x, y, width, height, folder path (UTF-8)
+const char SNAPSHOT_MAGIC[8] = { 'B', 'O', 'O', 'X', 'L', 'S', '0', '1' };
+const char JOURNAL_MAGIC[8] = { 'B', 'O', 'O', 'X', 'L', 'J', '0', '1' };
+constexpr int HEADER_SIZE = 16;
+constexpr int SNAPSHOT_HEADER_SIZE = HEADER_SIZE + 8;
+constexpr int FRAME_SIZE = 8;
+constexpr int PAYLOAD_FIXED_SIZE = 18;
+constexpr quint32 MAX_PAYLOAD_SIZE = PAYLOAD_FIXED_SIZE + 64 * 1024;
+
+enum Op : quint8 { OpPut = 1, OpRemove = 2 };
+enum Flag : quint8 { HasGeometry = 1, HasViewMode = 2, GridMode = 4 };
+
+void putU32(QByteArray &out, quint32 value)
+{
+    uchar bytes[4];
+    qToLittleEndian(value, bytes);
+    out.append(reinterpret_cast<const char *>(bytes), 4);
+}
+
+void putU64(QByteArray &out, quint64 value)
+{
+    uchar bytes[8];
+    qToLittleEndian(value, bytes);
+    out.append(reinterpret_cast<const char *>(bytes), 8);
+}
+
+quint32 getU32(const QByteArray &data, qint64 pos)
+{
+    return qFromLittleEndian<quint32>(reinterpret_cast<const uchar *>(data.constData() + pos));
+}
+
+quint64 getU64(const QByteArray &data, qint64 pos)
+{
+    return qFromLittleEndian<quint64>(reinterpret_cast<const uchar *>(data.constData() + pos));
+}
+
+QByteArray header(const char magic[8], quint64 generation)
+{
+    QByteArray out(magic, 8);
+    putU64(out, generation);
+    return out;
+}
+
+void appendRecord(QByteArray &out, const LayoutRecord &record)
+{
+    const ZoneLayout &layout = record.layout;
+    quint8 flags = 0;
+    if (layout.geometry.isValid()) flags |= HasGeometry;
+    if (layout.hasViewMode) flags |= HasViewMode;
+    if (layout.gridMode) flags |= GridMode;
+
+    QByteArray payload;
+    payload.reserve(PAYLOAD_FIXED_SIZE + record.folderPath.size() * 3);
+    payload.append(char(record.removed ? OpRemove : OpPut));
+    payload.append(char(flags));
+    putU32(payload, quint32(layout.geometry.x()));
+    putU32(payload, quint32(layout.geometry.y()));
+    putU32(payload, quint32(layout.geometry.width()));
+    putU32(payload, quint32(layout.geometry.height()));
+    payload.append(record.folderPath.toUtf8());
+
+    putU32(out, quint32(payload.size()));
+    putU32(out, Checksum::crc32(payload));
+    out.append(payload);
+}
+
+// Decode the record framed at pos; returns its total size, or 0 if the
+// record is incomplete or damaged
+qint64 readRecord(const QByteArray &data, qint64 pos, LayoutRecord &record)
+{
+    if (pos + FRAME_SIZE > data.size()) {
+        return 0;
+    }
+    const quint32 length = getU32(data, pos);
+    const quint32 crc = getU32(data, pos + 4);
+    if (length < quint32(PAYLOAD_FIXED_SIZE) || length > MAX_PAYLOAD_SIZE
+        || pos + FRAME_SIZE + length > data.size()) {
+        return 0;
+    }
+
+    const uchar *payload = reinterpret_cast<const uchar *>(data.constData() + pos + FRAME_SIZE);
+    if (Checksum::crc32(payload, length) != crc) {
+        return 0;
+    }
+
+    const quint8 op = payload[0];
+    const quint8 flags = payload[1];
+    if (op != OpPut && op != OpRemove) {
+        return 0;
+    }
+
+    const qint64 fields = pos + FRAME_SIZE + 2;
+    record.removed = op == OpRemove;
+    record.layout = ZoneLayout();
+    if (flags & HasGeometry) {
+        record.layout.geometry = QRect(qint32(getU32(data, fields)), qint32(getU32(data, fields + 4)),
+                                       qint32(getU32(data, fields + 8)), qint32(getU32(data, fields + 12)));
+    }
+    record.layout.hasViewMode = flags & HasViewMode;
+    record.layout.gridMode = flags & GridMode;
+    record.folderPath = QString::fromUtf8(reinterpret_cast<const char *>(payload) + PAYLOAD_FIXED_SIZE,
+                                          int(length) - PAYLOAD_FIXED_SIZE);
+    return FRAME_SIZE + length;
+}
+
+void applyRecord(QHash<QString, ZoneLayout> &layouts, const LayoutRecord &record)
+{
+    if (record.removed) {
+        layouts.remove(record.folderPath);
+    } else {
+        layouts.insert(record.folderPath, record.layout);
+    }
+}
+
+// Push written data through to the disk
+bool syncFile(QFile &file)
+{
+    if (!file.flush()) {
+        return false;
+    }
+#if defined(Q_OS_WIN)
+    return _commit(file.handle()) == 0;
+#elif defined(Q_OS_UNIX)
+    return ::fsync(file.handle()) == 0;
+#else
+    return true;
+#endif
+}
+
+// Make a rename inside dirPath durable
+void syncDirectory(const QString &dirPath)
+{
+#if defined(Q_OS_UNIX)
+    const int fd = ::open(QFile::encodeName(dirPath).constData(), O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        ::fsync(fd);
+        ::close(fd);
+    }
+#else
+    // NTFS journals the rename itself
+    Q_UNUSED(dirPath);
+#endif
+}
+
+bool writeAtomically(const QString &filePath, const QByteArray &data)
+{
+    // QSaveFile syncs the temporary file before renaming it into place
+    QSaveFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    if (file.write(data) != data.size() || !file.commit()) {
+        return false;
+    }
+    syncDirectory(QFileInfo(filePath).absolutePath());
+    return true;
+}
+
+} // namespace
+
+LayoutJournal::LayoutJournal(const QString &basePath)
+    : basePath(basePath)
+{
+}
+
+bool LayoutJournal::load()
+{
+    state.clear();
+    generation = 0;
+    snapshotBytes = 0;
+    journalBytes = 0;
+    journalValid = false;
+
+    const bool haveSnapshotFile = QFile::exists(snapshotPath());
+    const bool haveJournalFile = QFile::exists(journalPath());
+
+    if (!haveSnapshotFile && !haveJournalFile) {
+        // First start with this format: carry over the old layout file
+        if (!readLegacyJson(legacyPath(), state)) {
+            return false;
+        }
+        compact();
+        return true;
+    }
+
+    const bool snapshotOk = readSnapshot();
+    // Without a readable snapshot the journal is all there is
+    const bool journalOk = replayJournal(!snapshotOk);
+    return snapshotOk || journalOk;
+}
+
+bool LayoutJournal::append(const QVector<LayoutRecord> &records)
+{
+    if (records.isEmpty()) {
+        return true;
+    }
+
+    for (const LayoutRecord &record : records) {
+        applyRecord(state, record);
+    }
+
+    // No journal to extend (first save, or an earlier write failed): the
+    // snapshot captures these records along with everything else
+    if (!journalValid) {
+        return compact();
+    }
+
+    QByteArray out;
+    for (const LayoutRecord &record : records) {
+        appendRecord(out, record);
+    }
+
+    QFile file(journalPath());
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        journalValid = false;
+        return false;
+    }
+    if (file.write(out) != out.size() || !syncFile(file)) {
+        // Cut off what made it to disk and compact on the next occasion,
+        // so the records are not lost and nothing follows a damaged one
+        file.resize(journalBytes);
+        journalValid = false;
+        return false;
+    }
+
+    journalBytes += out.size();
+    return true;
+}
+
+bool LayoutJournal::needsCompaction() const
+{
+    return !journalValid
+        || (journalBytes > COMPACT_MIN_BYTES && journalBytes > 2 * snapshotBytes);
+}
+
+bool LayoutJournal::compact()
+{
+    QByteArray body;
+    LayoutRecord record;
+    for (auto it = state.constBegin(); it != state.constEnd(); ++it) {
+        record.folderPath = it.key();
+        record.layout = it.value();
+        appendRecord(body, record);
+    }
+
+    QByteArray out = header(SNAPSHOT_MAGIC, generation + 1);
+    putU32(out, quint32(state.size()));
+    putU32(out, Checksum::crc32(body));
+    out.append(body);
+
+    if (!writeAtomically(snapshotPath(), out)) {
+        return false;
+    }
+
+    // The old journal is stale from here on, even if resetting it fails
+    ++generation;
+    snapshotBytes = out.size();
+    journalValid = false;
+    return resetJournal();
+}
+
+bool LayoutJournal::readLegacyJson(const QString &filePath, QHash<QString, ZoneLayout> &layouts)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    const QJsonDocument doc = QJsonDocument::fromJson(file.readAll());
+    if (!doc.isObject()) {
+        return false;
+    }
+
+    const QJsonObject root = doc.object();
+    layouts.reserve(layouts.size() + root.size());
+    for (auto it = root.constBegin(); it != root.constEnd(); ++it) {
+        if (!it.value().isObject()) {
+            continue;
+        }
+        const QJsonObject zoneData = it.value().toObject();
+
+        ZoneLayout layout;
+        if (zoneData.contains("x") && zoneData.contains("y") &&
+            zoneData.contains("width") && zoneData.contains("height")) {
+            layout.geometry = QRect(zoneData["x"].toInt(), zoneData["y"].toInt(),
+                                    zoneData["width"].toInt(), zoneData["height"].toInt());
+        }
+        if (zoneData.contains("viewMode")) {
+            layout.hasViewMode = true;
+            layout.gridMode = zoneData["viewMode"].toString() == "grid";
+        }
+        layouts.insert(it.key(), layout);
+    }
+    return true;
+}
+
+bool LayoutJournal::readSnapshot()
+{
+    QFile file(snapshotPath());
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    const QByteArray data = file.readAll();
+
+    if (data.size() < SNAPSHOT_HEADER_SIZE || !data.startsWith(QByteArray(SNAPSHOT_MAGIC, 8))) {
+        return false;
+    }
+    const quint64 snapshotGeneration = getU64(data, 8);
+    const quint32 count = getU32(data, HEADER_SIZE);
+    const quint32 crc = getU32(data, HEADER_SIZE + 4);
+    const uchar *body = reinterpret_cast<const uchar *>(data.constData()) + SNAPSHOT_HEADER_SIZE;
+    if (Checksum::crc32(body, data.size() - SNAPSHOT_HEADER_SIZE) != crc) {
+        return false;
+    }
+
+    QHash<QString, ZoneLayout> layouts;
+    layouts.reserve(int(count));
+    qint64 pos = SNAPSHOT_HEADER_SIZE;
+    LayoutRecord record;
+    for (quint32 i = 0; i < count; ++i) {
+        const qint64 size = readRecord(data, pos, record);
+        if (size == 0) {
+            return false;
+        }
+        applyRecord(layouts, record);
+        pos += size;
+    }
+
+    state = layouts;
+    generation = snapshotGeneration;
+    snapshotBytes = data.size();
+    return true;
+}
+
+bool LayoutJournal::replayJournal(bool anyGeneration)
+{
+    QFile file(journalPath());
+    if (!file.open(QIODevice::ReadWrite)) {
+        return false;
+    }
+    const QByteArray data = file.readAll();
+
+    if (data.size() < HEADER_SIZE || !data.startsWith(QByteArray(JOURNAL_MAGIC, 8))) {
+        return false;
+    }
+    const quint64 journalGeneration = getU64(data, 8);
+    if (journalGeneration != generation) {
+        if (!anyGeneration) {
+            // Left over from before the last compaction; already in the snapshot
+            return false;
+        }
+        generation = journalGeneration;
+    }
+
+    qint64 pos = HEADER_SIZE;
+    int replayed = 0;
+    LayoutRecord record;
+    while (pos < data.size()) {
+        const qint64 size = readRecord(data, pos, record);
+        if (size == 0) {
+            break;
+        }
+        applyRecord(state, record);
+        pos += size;
+        ++replayed;
+    }
+
+    // Drop a torn or damaged tail so new records follow the last good one
+    if (pos < data.size() && !file.resize(pos)) {
+        return replayed > 0;
+    }
+
+    journalBytes = pos;
+    journalValid = true;
+    return replayed > 0;
+}
+
+bool LayoutJournal::resetJournal()
+{
+    const QByteArray out = header(JOURNAL_MAGIC, generation);
+    if (!writeAtomically(journalPath(), out)) {
+        return false;
+    }
+
+    journalBytes = out.size();
+    journalValid = true;
+    return true;
+}
@@ -0,0 +1,95 @@
+#ifndef LAYOUTJOURNAL_H
+#define LAYOUTJOURNAL_H
+
+#include <QHash>
+#include <QRect>
+#include <QString>
+#include <QVector>
+
+// Saved placement of one zone
+struct ZoneLayout
+{
+    QRect geometry;             // invalid if no geometry was saved
+    bool hasViewMode = false;
+    bool gridMode = false;
+
+    bool operator==(const ZoneLayout &other) const
+    {
+        return geometry == other.geometry && hasViewMode == other.hasViewMode
+            && gridMode == other.gridMode;
+    }
+    bool operator!=(const ZoneLayout &other) const { return !(*this == other); }
+};
+
+// One change to the layout of one zone
+struct LayoutRecord
+{
+    QString folderPath;
+    bool removed = false;
+    ZoneLayout layout;
+};
+
+// Crash-consistent storage of zone layouts (<base>.snapshot + <base>.journal).
+//
+// Saving appends one checksummed record per changed zone to the journal and
+// syncs it, so a save costs O(changed zones) rather than a rewrite of every
+// zone. Once the journal outgrows the live data it is compacted: the full
+// state goes into a new snapshot (written to a temporary file, synced and
+// renamed over the old one) and the journal is restarted empty.
+//
+// Snapshot and journal carry a generation number. A journal only applies to
+// the snapshot of its own generation, so a crash between the two steps of a
+// compaction never replays records twice. When loading, replay stops at the
+// first incomplete or damaged record (a torn write from a crash) and the tail
+// is cut off, so recovery yields exactly the last durable state.
+//
+// Not thread-safe; LayoutStore uses it from its single writer thread only.
+class LayoutJournal
+{
+public:
+    // The journal is compacted once it holds this many bytes and is more
+    // than twice the size of the last snapshot
+    static constexpr qint64 COMPACT_MIN_BYTES = 64 * 1024;
+
+    // basePath without suffix, e.g. "d:/boox/.layout"
+    explicit LayoutJournal(const QString &basePath);
+
+    QString snapshotPath() const { return basePath + QStringLiteral(".snapshot"); }
+    QString journalPath() const { return basePath + QStringLiteral(".journal"); }
+    // Layout file of earlier versions, imported by load() when no snapshot exists
+    QString legacyPath() const { return basePath + QStringLiteral(".json"); }
+
+    // Read the snapshot and replay the journal. Imports the legacy JSON
+    // file on first use. Returns false if nothing was stored.
+    bool load();
+    // Current state: the loaded layouts plus everything appended since
+    const QHash<QString, ZoneLayout> &layouts() const { return state; }
+
+    // Apply records and durably append them; false on I/O failure
+    bool append(const QVector<LayoutRecord> &records);
+
+    bool needsCompaction() const;
+    // Replace snapshot and journal by a snapshot of the current state
+    bool compact();
+
+    qint64 journalSize() const { return journalBytes; }
+    qint64 snapshotSize() const { return snapshotBytes; }
+
+    // Parse a layout file of earlier versions ({ "<folder>": { x, y, width,
+    // height, viewMode } }); false if it can't be read
+    static bool readLegacyJson(const QString &filePath, QHash<QString, ZoneLayout> &layouts);
+
+private:
+    bool readSnapshot();
+    bool replayJournal(bool anyGeneration);
+    bool resetJournal();
+
+    QString basePath;
+    QHash<QString, ZoneLayout> state;
+    quint64 generation = 0;
+    qint64 snapshotBytes = 0;
+    qint64 journalBytes = 0;
+    bool journalValid = false;      // appendable: header matches generation, no failed write
+};
+
+#endif // LAYOUTJOURNAL_H
@@ -0,0 +1,151 @@
+#include "layoutstore.h"
+#include <QCoreApplication>
+#include <QRunnable>
+#include <QVector>
+#include "../trace/tracer.h"
+
+namespace {
+
+// Appends one batch of changes on the writer thread
+class LayoutWriteTask : public QRunnable
+{
+public:
+    LayoutWriteTask(std::shared_ptr<LayoutJournal> journal, const QVector<LayoutRecord> &records)
+        : journal(std::move(journal)), records(records)
+    {
+    }
+
+    void run() override
+    {
+        TraceSpan span("LayoutStore::write", "layout");
+
+        journal->append(records);
+        if (journal->needsCompaction()) {
+            journal->compact();
+        }
+    }
+
+private:
+    std::shared_ptr<LayoutJournal> journal;
+    QVector<LayoutRecord> records;
+};
+
+} // namespace
+
+LayoutStore *LayoutStore::instance()
+{
+    static LayoutStore *store = new LayoutStore(QCoreApplication::instance());
+    return store;
+}
+
+LayoutStore::LayoutStore(QObject *parent)
+    : QObject(parent)
+{
+    writer.setMaxThreadCount(1);
+
+    flushTimer.setSingleShot(true);
+    flushTimer.setInterval(FLUSH_DELAY_MS);
+    connect(&flushTimer, &QTimer::timeout, this, &LayoutStore::flush);
+
+    connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit, this, [this]() {
+        flush();
+        waitForWrites();
+    });
+}
+
+LayoutStore::~LayoutStore()
+{
+    writer.waitForDone();
+}
+
+void LayoutStore::open(const QString &basePath)
+{
+    TraceSpan span("LayoutStore::open", "startup");
+
+    // Pending changes belong to the previous journal
+    flush();
+    waitForWrites();
+
+    // Read once at startup; from here on the journal lives on the writer thread
+    journal = std::make_shared<LayoutJournal>(basePath);
+    journal->load();
+    layouts = journal->layouts();
+}
+
+bool LayoutStore::lookup(const QString &folderPath, ZoneLayout &layout) const
+{
+    auto it = layouts.constFind(folderPath);
+    if (it == layouts.constEnd()) {
+        return false;
+    }
+    layout = it.value();
+    return true;
+}
+
+void LayoutStore::store(const QString &folderPath, const ZoneLayout &layout)
+{
+    auto it = layouts.find(folderPath);
+    if (it != layouts.end() && it.value() == layout) {
+        return;
+    }
+
+    layouts.insert(folderPath, layout);
+    markDirty(folderPath);
+}
+
+void LayoutStore::remove(const QString &folderPath)
+{
+    if (layouts.remove(folderPath) > 0) {
+        markDirty(folderPath);
+    }
+}
+
+void LayoutStore::rename(const QString &oldPath, const QString &newPath)
+{
+    ZoneLayout layout;
+    if (oldPath == newPath || !lookup(oldPath, layout)) {
+        return;
+    }
+
+    remove(oldPath);
+    store(newPath, layout);
+}
+
+void LayoutStore::flush()
+{
+    flushTimer.stop();
+    if (dirty.isEmpty() || !journal) {
+        return;
+    }
+
+    // One record per changed zone
+    QVector<LayoutRecord> records;
+    records.reserve(dirty.size());
+    for (const QString &folderPath : dirty) {
+        LayoutRecord record;
+        record.folderPath = folderPath;
+        auto it = layouts.constFind(folderPath);
+        if (it == layouts.constEnd()) {
+            record.removed = true;
+        } else {
+            record.layout = it.value();
+        }
+        records.append(record);
+    }
+    dirty.clear();
+
+    writer.start(new LayoutWriteTask(journal, records));
+}
+
+void LayoutStore::waitForWrites()
+{
+    writer.waitForDone();
+}
+
+void LayoutStore::markDirty(const QString &folderPath)
+{
+    dirty.insert(folderPath);
+    if (!flushTimer.isActive()) {
+        flushTimer.start();
+    }
+}
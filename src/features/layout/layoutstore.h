@@ -0,0 +1,64 @@
+#ifndef LAYOUTSTORE_H
+#define LAYOUTSTORE_H
+
+#include <QObject>
+#include <QHash>
+#include <QRect>
+#include <QSet>
+#include <QString>
+#include <QThreadPool>
+#include <QTimer>
+#include <memory>
+#include "layoutjournal.h"
+
+// Process-wide zone layouts, keyed by folder path.
+// The layouts are read once when opened and then served from memory.
+// Changed zones are collected and appended to the layout journal together
+// after a short debounce (and on quit) from a worker thread, so moving or
+// resizing a zone never touches the disk on the GUI thread.
+class LayoutStore : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int FLUSH_DELAY_MS = 500;
+
+    static LayoutStore *instance();
+
+    // Load layouts from the journal at basePath (see LayoutJournal);
+    // later changes are written back there
+    void open(const QString &basePath);
+
+    bool contains(const QString &folderPath) const { return layouts.contains(folderPath); }
+    // False if nothing is stored for folderPath
+    bool lookup(const QString &folderPath, ZoneLayout &layout) const;
+
+    void store(const QString &folderPath, const ZoneLayout &layout);
+    void remove(const QString &folderPath);
+    // Carry the layout of a renamed folder over to its new path
+    void rename(const QString &oldPath, const QString &newPath);
+
+    // Write pending changes now (still off the GUI thread)
+    void flush();
+    // Block until all queued writes are on disk
+    void waitForWrites();
+
+private:
+    explicit LayoutStore(QObject *parent = nullptr);
+    ~LayoutStore() override;
+
+    void markDirty(const QString &folderPath);
+
+    QHash<QString, ZoneLayout> layouts;
+
+    // Zones changed since the last write
+    QSet<QString> dirty;
+    QTimer flushTimer;
+
+    // Single writer thread keeps writes in order; the journal is only
+    // touched there once opened
+    QThreadPool writer;
+    std::shared_ptr<LayoutJournal> journal;
+};
+
+#endif // LAYOUTSTORE_H
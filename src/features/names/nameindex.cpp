@@ -0,0 +1,188 @@
+#include "nameindex.h"
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+
+#if defined(Q_OS_UNIX)
+#include <cerrno>
+#include <cstdio>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#if defined(Q_OS_LINUX)
+#include <sys/syscall.h>
+#ifndef RENAME_NOREPLACE
+#define RENAME_NOREPLACE (1 << 0)
+#endif
+#elif defined(Q_OS_WIN)
+#include <windows.h>
+#endif
+
+namespace {
+
+#if defined(Q_OS_UNIX)
+NameIndex::RenameResult resultOf(int error)
+{
+    switch (error) {
+    case EEXIST:
+    case ENOTEMPTY:   // plain rename() onto a non-empty folder
+        return NameIndex::TargetExists;
+    case EXDEV:
+        return NameIndex::CrossDevice;
+    default:
+        return NameIndex::Failed;
+    }
+}
+#endif
+
+} // namespace
+
+NameIndex::NameIndex(const QString &folder)
+    : folderPath(folder)
+{
+}
+
+void NameIndex::list()
+{
+    listed = true;
+#if defined(Q_OS_UNIX)
+    // readdir() alone: the names are all that is needed, so no entry is stat'ed
+    DIR *dir = ::opendir(QFile::encodeName(folderPath).constData());
+    if (!dir) {
+        return;
+    }
+    while (const struct dirent *entry = ::readdir(dir)) {
+        const char *name = entry->d_name;
+        if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+            continue;
+        }
+        names.insert(key(QFile::decodeName(name)));
+    }
+    ::closedir(dir);
+#else
+    QDirIterator it(folderPath, QDir::AllEntries | QDir::Hidden | QDir::System | QDir::NoDotAndDotDot);
+    while (it.hasNext()) {
+        it.next();
+        names.insert(key(it.fileName()));
+    }
+#endif
+}
+
+QString NameIndex::key(const QString &name)
+{
+#if defined(Q_OS_WIN) || defined(Q_OS_DARWIN)
+    return name.toCaseFolded();
+#else
+    return name;
+#endif
+}
+
+bool NameIndex::contains(const QString &name) const
+{
+    if (names.contains(key(name))) {
+        return true;
+    }
+    if (listed) {
+        return false;
+    }
+    const QFileInfo info(QDir(folderPath).filePath(name));
+    return info.exists() || info.isSymLink();
+}
+
+QString NameIndex::allocate(const QString &fileName, bool isDir)
+{
+    if (!contains(fileName)) {
+        insert(fileName);
+        return fileName;
+    }
+    if (!listed) {
+        list();
+    }
+
+    // Built by concatenation rather than arg(): names may contain "%1"
+    const QFileInfo info(fileName);
+    const QString prefix = info.completeBaseName() + QLatin1Char('_');
+    const QString tail = isDir || info.suffix().isEmpty()
+        ? QString() : QLatin1Char('.') + info.suffix();
+
+    int &counter = lastCounter[prefix + QLatin1Char('/') + tail];
+    QString name;
+    do {
+        name = prefix + QString::number(++counter) + tail;
+    } while (contains(name));
+
+    insert(name);
+    return name;
+}
+
+NameIndex::RenameResult NameIndex::renameNoReplace(const QString &from, const QString &to)
+{
+#if defined(Q_OS_UNIX)
+    const QByteArray source = QFile::encodeName(from);
+    const QByteArray target = QFile::encodeName(to);
+
+#if defined(Q_OS_LINUX) && defined(SYS_renameat2)
+    if (::syscall(SYS_renameat2, AT_FDCWD, source.constData(), AT_FDCWD, target.constData(),
+                  RENAME_NOREPLACE) == 0) {
+        return Renamed;
+    }
+    // EINVAL / ENOSYS: the kernel or the file system does not support the flag
+    if (errno != EINVAL && errno != ENOSYS) {
+        return resultOf(errno);
+    }
+#elif defined(Q_OS_DARWIN)
+    if (::renamex_np(source.constData(), target.constData(), RENAME_EXCL) == 0) {
+        return Renamed;
+    }
+    if (errno != ENOTSUP && errno != EINVAL) {
+        return resultOf(errno);
+    }
+#endif
+
+    // A new link never replaces anything; the old name goes once it exists
+    if (::linkat(AT_FDCWD, source.constData(), AT_FDCWD, target.constData(), 0) == 0) {
+        if (::unlink(source.constData()) == 0) {
+            return Renamed;
+        }
+        ::unlink(target.constData());
+        return Failed;
+    }
+    if (errno == EEXIST || errno == EXDEV) {
+        return resultOf(errno);
+    }
+
+    // Folders, and file systems without hard links (FAT, some FUSE mounts)
+    struct stat st;
+    if (::lstat(target.constData(), &st) == 0) {
+        return TargetExists;
+    }
+    return ::rename(source.constData(), target.constData()) == 0 ? Renamed : resultOf(errno);
+#elif defined(Q_OS_WIN)
+    const QString source = QDir::toNativeSeparators(from);
+    const QString target = QDir::toNativeSeparators(to);
+    // Without MOVEFILE_REPLACE_EXISTING an existing target fails the move,
+    // and without MOVEFILE_COPY_ALLOWED so does another volume
+    if (MoveFileExW(reinterpret_cast<LPCWSTR>(source.utf16()),
+                    reinterpret_cast<LPCWSTR>(target.utf16()), 0)) {
+        return Renamed;
+    }
+    switch (GetLastError()) {
+    case ERROR_ALREADY_EXISTS:
+    case ERROR_FILE_EXISTS:
+        return TargetExists;
+    case ERROR_NOT_SAME_DEVICE:
+        return CrossDevice;
+    default:
+        return Failed;
+    }
+#else
+    const QFileInfo target(to);
+    if (target.exists() || target.isSymLink()) {
+        return TargetExists;
+    }
+    return QDir().rename(from, to) ? Renamed : Failed;
+#endif
+}
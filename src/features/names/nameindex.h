@@ -0,0 +1,60 @@
+#ifndef NAMEINDEX_H
+#define NAMEINDEX_H
+
+#include <QHash>
+#include <QSet>
+#include <QString>
+
+// The names in one folder, read with a single listing, for choosing free
+// target names for a whole batch without a stat per candidate. The folder
+// is only listed once a name turns out to be taken; until then each name
+// costs one lookup, so a drop without conflicts never lists a big folder.
+// allocate() keeps the usual naming (name.ext, name_1.ext, name_2.ext, ...;
+// folders and names without a suffix get name_1, name_2, ...) and remembers,
+// per name pattern, the last counter handed out, so a batch of same-named
+// items does not probe 1, 2, 3, ... again for every item.
+// The index is only a snapshot: whatever appears in the folder after the
+// listing is caught by renameNoReplace(), which never overwrites.
+// Names are compared case-insensitively on Windows and macOS.
+class NameIndex
+{
+public:
+    enum RenameResult {
+        Renamed,
+        TargetExists,   // nothing was changed
+        CrossDevice,    // source and target are on different file systems
+        Failed
+    };
+
+    explicit NameIndex(const QString &folder);
+
+    QString folder() const { return folderPath; }
+
+    // Whether `name` is taken: in the folder, or inserted
+    bool contains(const QString &name) const;
+    // Mark `name` as taken (e.g. reserved for an item not moved yet)
+    void insert(const QString &name) { names.insert(key(name)); }
+
+    // A free name for an item called `fileName`, marked as taken
+    QString allocate(const QString &fileName, bool isDir);
+
+    // Rename `from` to `to`, failing with TargetExists instead of replacing
+    // an existing `to`: renameat2(RENAME_NOREPLACE) on Linux, renamex_np
+    // (RENAME_EXCL) on macOS, MoveFileExW without MOVEFILE_REPLACE_EXISTING
+    // on Windows. Where the file system lacks these, files are moved with
+    // link() + unlink(); only folders there fall back to check-then-rename.
+    static RenameResult renameNoReplace(const QString &from, const QString &to);
+
+private:
+    static QString key(const QString &name);
+    // Read all names of the folder (names only, no stat per entry)
+    void list();
+
+    QString folderPath;
+    bool listed = false;
+    QSet<QString> names;
+    // "prefix/tail" of a name pattern -> last counter handed out for it
+    QHash<QString, int> lastCounter;
+};
+
+#endif // NAMEINDEX_H
@@ -0,0 +1,183 @@
+#include "zoneregistry.h"
+#include <QFile>
+#include <QSet>
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#elif defined(Q_OS_UNIX)
+#include <sys/stat.h>
+#endif
+
+FolderId FolderId::of(const QString &path)
+{
+    FolderId id;
+
+#if defined(Q_OS_WIN)
+    HANDLE handle = CreateFileW(reinterpret_cast<const wchar_t *>(path.utf16()), 0,
+                                FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                                nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, nullptr);
+    if (handle != INVALID_HANDLE_VALUE) {
+        BY_HANDLE_FILE_INFORMATION info;
+        if (GetFileInformationByHandle(handle, &info)) {
+            id.device = info.dwVolumeSerialNumber;
+            id.inode = (quint64(info.nFileIndexHigh) << 32) | info.nFileIndexLow;
+        }
+        CloseHandle(handle);
+    }
+#elif defined(Q_OS_UNIX)
+    struct stat st;
+    if (::stat(QFile::encodeName(path).constData(), &st) == 0) {
+        id.device = quint64(st.st_dev);
+        id.inode = quint64(st.st_ino);
+    }
+#else
+    Q_UNUSED(path);
+#endif
+
+    return id;
+}
+
+ZoneRegistry::~ZoneRegistry()
+{
+    qDeleteAll(order);
+}
+
+ZoneDescriptor *ZoneRegistry::insert(const QString &folderPath)
+{
+    if (ZoneDescriptor *existing = byPath.value(folderPath)) {
+        return existing;
+    }
+
+    ZoneDescriptor *descriptor = new ZoneDescriptor;
+    descriptor->folderPath = folderPath;
+    descriptor->id = FolderId::of(folderPath);
+    order.append(descriptor);
+    byPath.insert(folderPath, descriptor);
+    return descriptor;
+}
+
+void ZoneRegistry::remove(ZoneDescriptor *descriptor)
+{
+    if (!order.removeOne(descriptor)) {
+        return;
+    }
+
+    if (byPath.value(descriptor->folderPath) == descriptor) {
+        byPath.remove(descriptor->folderPath);
+    }
+    delete descriptor;
+}
+
+void ZoneRegistry::retarget(ZoneDescriptor *descriptor, const QString &newPath)
+{
+    if (byPath.value(descriptor->folderPath) == descriptor) {
+        byPath.remove(descriptor->folderPath);
+    }
+    descriptor->folderPath = newPath;
+    byPath.insert(newPath, descriptor);
+}
+
+ZoneDescriptor *ZoneRegistry::find(const FloatingZone *zone) const
+{
+    // Only a small share of the zones is materialized; a scan is fine here
+    for (ZoneDescriptor *descriptor : order) {
+        if (descriptor->zone == zone) {
+            return descriptor;
+        }
+    }
+    return nullptr;
+}
+
+int ZoneRegistry::indexOf(const ZoneDescriptor *descriptor) const
+{
+    return order.indexOf(const_cast<ZoneDescriptor *>(descriptor));
+}
+
+ZoneChanges ZoneRegistry::diffListing(const QVector<FileEntry> &folders) const
+{
+    ZoneChanges changes;
+
+    QSet<ZoneDescriptor*> seen;
+    seen.reserve(folders.size());
+    for (const FileEntry &folder : folders) {
+        if (!folder.isDir) {
+            continue;
+        }
+        if (ZoneDescriptor *descriptor = byPath.value(folder.path)) {
+            seen.insert(descriptor);
+        } else {
+            changes.added.append(folder);
+        }
+    }
+
+    if (seen.size() != order.size()) {
+        for (ZoneDescriptor *descriptor : order) {
+            if (!seen.contains(descriptor)) {
+                changes.removed.append(descriptor);
+            }
+        }
+    }
+
+    pairRenames(changes);
+    return changes;
+}
+
+ZoneChanges ZoneRegistry::diffDelta(const QVector<FileEntry> &present,
+                                    const QStringList &missingPaths) const
+{
+    ZoneChanges changes;
+
+    for (const FileEntry &entry : present) {
+        ZoneDescriptor *descriptor = byPath.value(entry.path);
+        if (entry.isDir) {
+            if (!descriptor) {
+                changes.added.append(entry);
+            }
+        } else if (descriptor) {
+            // The folder was replaced by a file of the same name
+            changes.removed.append(descriptor);
+        }
+    }
+
+    for (const QString &path : missingPaths) {
+        if (ZoneDescriptor *descriptor = byPath.value(path)) {
+            changes.removed.append(descriptor);
+        }
+    }
+
+    pairRenames(changes);
+    return changes;
+}
+
+void ZoneRegistry::pairRenames(ZoneChanges &changes) const
+{
+    if (changes.added.isEmpty() || changes.removed.isEmpty()) {
+        return;
+    }
+
+    // A zone whose path vanished while a folder with the same identity
+    // appeared was renamed; keep the zone instead of recreating it
+    QHash<QPair<quint64, quint64>, ZoneDescriptor*> removedById;
+    for (ZoneDescriptor *descriptor : changes.removed) {
+        if (!descriptor->id.isNull()) {
+            removedById.insert(qMakePair(descriptor->id.device, descriptor->id.inode), descriptor);
+        }
+    }
+    if (removedById.isEmpty()) {
+        return;
+    }
+
+    for (int i = changes.added.size() - 1; i >= 0; --i) {
+        const FolderId id = FolderId::of(changes.added.at(i).path);
+        ZoneDescriptor *descriptor = removedById.take(qMakePair(id.device, id.inode));
+        if (!descriptor) {
+            continue;
+        }
+        changes.renamed.append(qMakePair(descriptor, changes.added.at(i).path));
+        changes.removed.removeOne(descriptor);
+        changes.added.remove(i);
+        if (removedById.isEmpty()) {
+            break;
+        }
+    }
+}
@@ -0,0 +1,92 @@
+#ifndef ZONEREGISTRY_H
+#define ZONEREGISTRY_H
+
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include "../filemodel/filemodel.h"
+
+class FloatingZone;
+
+// Identity of a folder on disk that survives renames (device + inode on
+// Unix, volume serial + file index on Windows). Null if it can't be read.
+struct FolderId
+{
+    quint64 device = 0;
+    quint64 inode = 0;
+
+    bool isNull() const { return device == 0 && inode == 0; }
+    bool operator==(const FolderId &other) const
+    {
+        return device == other.device && inode == other.inode;
+    }
+
+    static FolderId of(const QString &path);
+};
+
+// A zone folder of the root. The FloatingZone widget (title bar, list,
+// watcher, listing) only exists while the zone is actually on a screen;
+// everything else is represented by this descriptor alone.
+struct ZoneDescriptor
+{
+    QString folderPath;
+    FolderId id;
+    FloatingZone *zone = nullptr;   // materialized widget, or null
+};
+
+// What has to happen to the zones after a change in the root folder
+struct ZoneChanges
+{
+    QVector<FileEntry> added;                               // folders without a zone yet
+    QList<ZoneDescriptor*> removed;                         // zones whose folder is gone
+    QVector<QPair<ZoneDescriptor*, QString>> renamed;       // zone folder now lives at a new path
+
+    bool isEmpty() const { return added.isEmpty() && removed.isEmpty() && renamed.isEmpty(); }
+};
+
+// The zones of the root folder, indexed by folder path and folder identity.
+// Lookups are hash based, and diffs against a listing or a set of changed
+// names cost one pass over the input; folders are only stat'ed to pair
+// removed zones with added folders, i.e. to detect renames.
+class ZoneRegistry
+{
+public:
+    ZoneRegistry() = default;
+    ~ZoneRegistry();
+
+    // Descriptor for folderPath, added if needed
+    ZoneDescriptor *insert(const QString &folderPath);
+    // Forget (and delete) a descriptor; its widget is the caller's business
+    void remove(ZoneDescriptor *descriptor);
+    // Re-key a zone whose folder moved to newPath
+    void retarget(ZoneDescriptor *descriptor, const QString &newPath);
+
+    ZoneDescriptor *find(const QString &folderPath) const { return byPath.value(folderPath); }
+    ZoneDescriptor *find(const FloatingZone *zone) const;
+    bool contains(const QString &folderPath) const { return byPath.contains(folderPath); }
+
+    // Zones in creation order
+    const QList<ZoneDescriptor*> &zones() const { return order; }
+    int indexOf(const ZoneDescriptor *descriptor) const;
+    int size() const { return order.size(); }
+    bool isEmpty() const { return order.isEmpty(); }
+
+    // Changes needed to match a full listing of the root's folders
+    ZoneChanges diffListing(const QVector<FileEntry> &folders) const;
+    // Changes needed after the named root entries changed: present holds
+    // the entries that still exist, missingPaths the ones that are gone
+    ZoneChanges diffDelta(const QVector<FileEntry> &present, const QStringList &missingPaths) const;
+
+private:
+    Q_DISABLE_COPY(ZoneRegistry)
+
+    void pairRenames(ZoneChanges &changes) const;
+
+    QList<ZoneDescriptor*> order;
+    QHash<QString, ZoneDescriptor*> byPath;
+};
+
+#endif // ZONEREGISTRY_H
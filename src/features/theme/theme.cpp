@@ -0,0 +1,194 @@
+#include "theme.h"
+#include <QApplication>
+#include <QStyle>
+#include <QWidget>
+
+namespace {
+
+const char *const STYLE_SHEET =
+    // -----------------------------------------------------------------------
+    // Zones
+    // -----------------------------------------------------------------------
+    "FloatingZone { background-color: transparent; }"
+
+    // The title bar and list panels are painted by the zone itself from a
+    // cached pixmap (FloatingZone::chromePixmap); the widgets stay transparent
+    "QLabel#zoneTitle { "
+    "  color: white; "
+    "  font-weight: bold; "
+    "  font-size: 13px; "
+    "  background: transparent; "
+    "  border: none; "
+    "  padding: 0px; "
+    "  margin: 0px; "
+    "}"
+
+    // Title bar buttons
+    "QWidget#zoneTitleBar QPushButton { "
+    "  background-color: transparent; "
+    "  color: rgba(255, 255, 255, 150); "
+    "  border: none; "
+    "  padding: 0px; "
+    "  font-size: 14px; "
+    "  font-weight: bold; "
+    "}"
+    "QWidget#zoneTitleBar QPushButton:hover { "
+    "  background-color: rgba(255, 255, 255, 80); "
+    "  color: white; "
+    "}"
+    // Per-button rules repeat the title bar id so they outrank the shared one
+    "QWidget#zoneTitleBar QPushButton#zoneClose { font-size: 18px; }"
+    "QWidget#zoneTitleBar QPushButton#zoneClose:hover { background-color: rgba(255, 100, 100, 180); }"
+    "QWidget#zoneTitleBar QPushButton#zoneLock:hover { background-color: rgba(255, 200, 0, 100); }"
+    "QWidget#zoneTitleBar QPushButton#zoneLock[locked=\"true\"] { "
+    "  background-color: rgba(255, 200, 0, 60); "
+    "  color: rgba(255, 200, 0, 220); "
+    "}"
+    "QWidget#zoneTitleBar QPushButton#zoneLock[locked=\"true\"]:hover { "
+    "  background-color: rgba(255, 200, 0, 100); "
+    "  color: white; "
+    "}"
+
+    // File list
+    "QListView#zoneList { "
+    "  background: transparent; "
+    "  border: 1px solid transparent; "   // keeps the space of the painted border
+    "  border-top: none; "
+    "  padding: 5px; "
+    "}"
+    // Rows are painted by ZoneItemDelegate (features/delegate)
+
+    // Scrollbars of the file list
+    "QListView#zoneList QScrollBar:vertical { "
+    "  background: rgba(0, 0, 0, 30); "
+    "  width: 10px; "
+    "  border: none; "
+    "  margin: 0px; "
+    "}"
+    "QListView#zoneList QScrollBar::handle:vertical { "
+    "  background: rgba(255, 255, 255, 100); "
+    "  min-height: 20px; "
+    "  border-radius: 5px; "
+    "}"
+    "QListView#zoneList QScrollBar:horizontal { "
+    "  background: rgba(0, 0, 0, 30); "
+    "  height: 10px; "
+    "  border: none; "
+    "  margin: 0px; "
+    "}"
+    "QListView#zoneList QScrollBar::handle:horizontal { "
+    "  background: rgba(255, 255, 255, 100); "
+    "  min-width: 20px; "
+    "  border-radius: 5px; "
+    "}"
+    "QListView#zoneList QScrollBar::handle:hover { "
+    "  background: rgba(255, 255, 255, 150); "
+    "}"
+    "QListView#zoneList QScrollBar::handle:pressed { "
+    "  background: rgba(255, 255, 255, 200); "
+    "}"
+    "QListView#zoneList QScrollBar::add-line:vertical, "
+    "QListView#zoneList QScrollBar::sub-line:vertical { "
+    "  height: 0px; "
+    "}"
+    "QListView#zoneList QScrollBar::add-line:horizontal, "
+    "QListView#zoneList QScrollBar::sub-line:horizontal { "
+    "  width: 0px; "
+    "}"
+    "QListView#zoneList QScrollBar::add-page, "
+    "QListView#zoneList QScrollBar::sub-page { "
+    "  background: none; "
+    "}"
+
+    // -----------------------------------------------------------------------
+    // Zone context menus
+    // -----------------------------------------------------------------------
+    "QMenu#zoneMenu { "
+    "  background-color: rgba(40, 40, 40, 240); "
+    "  color: white; "
+    "  border: 1px solid rgba(255, 255, 255, 50); "
+    "  border-radius: 5px; "
+    "  padding: 5px; "
+    "}"
+    "QMenu#zoneMenu::item { "
+    "  padding: 5px 20px; "
+    "  border-radius: 3px; "
+    "}"
+    "QMenu#zoneMenu::item:selected { "
+    "  background-color: rgba(255, 255, 255, 80); "
+    "}"
+
+    // -----------------------------------------------------------------------
+    // Dialogs (FileOpsHandler)
+    // -----------------------------------------------------------------------
+    "QDialog#booxDialog { "
+    "  background-color: rgba(30, 30, 30, 245); "
+    "  border: 1px solid rgba(255, 255, 255, 60); "
+    "  border-radius: 8px; "
+    "}"
+    "QDialog#booxDialog QLabel { "
+    "  color: rgba(255, 255, 255, 200); "
+    "  font-size: 13px; "
+    "  background: transparent; "
+    "}"
+    "QDialog#booxDialog QLabel#dialogTitle { "
+    "  color: white; "
+    "  font-size: 14px; "
+    "  font-weight: bold; "
+    "}"
+    "QDialog#booxDialog QLabel#dialogTitle[warning=\"true\"] { "
+    "  color: rgba(255, 100, 100, 220); "
+    "}"
+    "QDialog#booxDialog QLineEdit { "
+    "  background-color: rgba(255, 255, 255, 15); "
+    "  color: white; "
+    "  border: 1px solid rgba(255, 255, 255, 60); "
+    "  border-radius: 4px; "
+    "  padding: 5px 8px; "
+    "  font-size: 13px; "
+    "}"
+    "QDialog#booxDialog QLineEdit:focus { "
+    "  border: 1px solid rgba(255, 255, 255, 120); "
+    "}"
+    "QDialog#booxDialog QPushButton { "
+    "  background-color: rgba(255, 255, 255, 20); "
+    "  color: white; "
+    "  border: 1px solid rgba(255, 255, 255, 50); "
+    "  border-radius: 4px; "
+    "  padding: 5px 18px; "
+    "  font-size: 13px; "
+    "}"
+    "QDialog#booxDialog QPushButton:hover { "
+    "  background-color: rgba(255, 255, 255, 40); "
+    "}"
+    "QDialog#booxDialog QPushButton:pressed { "
+    "  background-color: rgba(255, 255, 255, 60); "
+    "}"
+    "QDialog#booxDialog QPushButton#btnConfirm { "
+    "  background-color: rgba(80, 120, 200, 180); "
+    "  border: 1px solid rgba(80, 120, 200, 220); "
+    "}"
+    "QDialog#booxDialog QPushButton#btnConfirm:hover { "
+    "  background-color: rgba(80, 120, 200, 230); "
+    "}";
+
+} // namespace
+
+void Theme::install(QApplication &app)
+{
+    app.setStyleSheet(QString::fromLatin1(STYLE_SHEET));
+}
+
+void Theme::setState(QWidget *widget, const char *name, const QVariant &value)
+{
+    if (widget->property(name) == value) {
+        return;
+    }
+    widget->setProperty(name, value);
+
+    // Property selectors are only evaluated when the widget is polished
+    QStyle *style = widget->style();
+    style->unpolish(widget);
+    style->polish(widget);
+    widget->update();
+}
@@ -0,0 +1,25 @@
+#ifndef THEME_H
+#define THEME_H
+
+#include <QVariant>
+
+class QApplication;
+class QWidget;
+
+// The app's look, as one application-wide stylesheet.
+// Widgets opt in through their object names (zoneTitleBar, zoneList,
+// zoneMenu, booxDialog, ...) instead of carrying a stylesheet of their own, so
+// Qt parses the rules once rather than once per zone, button and dialog.
+// State that changes the look (a locked zone, a warning title) is a dynamic
+// property matched by the stylesheet.
+namespace Theme {
+
+// Call once, right after the QApplication is created
+void install(QApplication &app);
+
+// Set a property the stylesheet matches on and re-resolve the widget's style
+void setState(QWidget *widget, const char *name, const QVariant &value);
+
+} // namespace Theme
+
+#endif // THEME_H
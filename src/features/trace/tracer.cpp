@@ -0,0 +1,264 @@
+#include "tracer.h"
+#include <QCoreApplication>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QSaveFile>
+#include <QThread>
+#include <QVector>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#if defined(Q_OS_WIN)
+#include <windows.h>
+#elif defined(Q_OS_UNIX)
+#include <time.h>
+#endif
+
+std::atomic_bool Tracer::enabled{false};
+
+namespace {
+
+struct TraceEvent
+{
+    const char *name;
+    const char *category;
+    qint64 startNs;
+    qint64 endNs;
+    qint64 cpuNs;   // -1: unknown (and for async events)
+    QString detail;
+    bool async;
+};
+
+// Events of one thread. Only that thread appends; the lock is uncontended
+// except while write() copies the events out.
+struct ThreadBuffer
+{
+    int tid = 0;
+    QString threadName;
+    QMutex mutex;
+    QVector<TraceEvent> events;
+};
+
+struct TraceState
+{
+    QMutex mutex;
+    QString outputPath;
+    std::chrono::steady_clock::time_point origin;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;   // kept until exit
+};
+
+TraceState &state()
+{
+    static TraceState traceState;
+    return traceState;
+}
+
+ThreadBuffer *threadBuffer()
+{
+    thread_local ThreadBuffer *buffer = nullptr;
+    if (buffer) {
+        return buffer;
+    }
+
+    TraceState &s = state();
+    QMutexLocker locker(&s.mutex);
+    s.buffers.push_back(std::make_unique<ThreadBuffer>());
+    buffer = s.buffers.back().get();
+    buffer->tid = int(s.buffers.size());
+
+    QThread *thread = QThread::currentThread();
+    if (QCoreApplication::instance() && thread == QCoreApplication::instance()->thread()) {
+        buffer->threadName = QStringLiteral("GUI");
+    } else if (thread && !thread->objectName().isEmpty()
+               && !thread->objectName().startsWith(QLatin1String("Thread (pooled)"))) {
+        buffer->threadName = thread->objectName();
+    } else {
+        buffer->threadName = QStringLiteral("worker %1").arg(buffer->tid);
+    }
+    return buffer;
+}
+
+} // namespace
+
+void Tracer::configure(int argc, char *argv[])
+{
+    QString outputPath;
+    bool requested = false;
+
+    const QByteArray env = qgetenv("BOOX_TRACE");
+    if (!env.isEmpty() && env != "0") {
+        requested = true;
+        if (env != "1") {
+            outputPath = QString::fromLocal8Bit(env);
+        }
+    }
+
+    for (int i = 1; i < argc; ++i) {
+        const QString arg = QString::fromLocal8Bit(argv[i]);
+        if (arg == QLatin1String("--trace")) {
+            requested = true;
+        } else if (arg.startsWith(QLatin1String("--trace="))) {
+            requested = true;
+            outputPath = arg.mid(8);
+        }
+    }
+
+    if (requested) {
+        enable(outputPath.isEmpty() ? QString::fromLatin1(DEFAULT_FILE) : outputPath);
+    }
+}
+
+void Tracer::enable(const QString &outputPath)
+{
+    TraceState &s = state();
+    {
+        QMutexLocker locker(&s.mutex);
+        s.outputPath = outputPath;
+        s.origin = std::chrono::steady_clock::now();
+    }
+    enabled.store(true, std::memory_order_release);
+}
+
+qint64 Tracer::now()
+{
+    const auto elapsed = std::chrono::steady_clock::now() - state().origin;
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+}
+
+qint64 Tracer::threadCpuNs()
+{
+#if defined(Q_OS_WIN)
+    FILETIME created, exited, kernel, user;
+    if (!GetThreadTimes(GetCurrentThread(), &created, &exited, &kernel, &user)) {
+        return -1;
+    }
+    auto toNs = [](const FILETIME &t) {
+        return qint64((quint64(t.dwHighDateTime) << 32) | t.dwLowDateTime) * 100;
+    };
+    return toNs(kernel) + toNs(user);
+#elif defined(Q_OS_UNIX) && defined(CLOCK_THREAD_CPUTIME_ID)
+    timespec time;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time) != 0) {
+        return -1;
+    }
+    return qint64(time.tv_sec) * 1000000000 + time.tv_nsec;
+#else
+    return -1;
+#endif
+}
+
+void Tracer::record(const char *name, const char *category, qint64 startNs, qint64 endNs,
+                    const QString &detail, qint64 cpuNs)
+{
+    ThreadBuffer *buffer = threadBuffer();
+    QMutexLocker locker(&buffer->mutex);
+    buffer->events.append(TraceEvent{ name, category, startNs, endNs, cpuNs, detail, false });
+}
+
+void Tracer::recordAsync(const char *name, const char *category, qint64 startNs, qint64 endNs,
+                         const QString &detail)
+{
+    ThreadBuffer *buffer = threadBuffer();
+    QMutexLocker locker(&buffer->mutex);
+    buffer->events.append(TraceEvent{ name, category, startNs, endNs, -1, detail, true });
+}
+
+bool Tracer::write()
+{
+    if (!isEnabled()) {
+        return false;
+    }
+
+    TraceState &s = state();
+    QMutexLocker locker(&s.mutex);
+
+    const qint64 pid = QCoreApplication::applicationPid();
+    QJsonArray events;
+    int asyncId = 0;
+
+    for (const auto &buffer : s.buffers) {
+        QMutexLocker bufferLocker(&buffer->mutex);
+
+        QJsonObject meta;
+        meta["name"] = "thread_name";
+        meta["ph"] = "M";
+        meta["pid"] = pid;
+        meta["tid"] = buffer->tid;
+        meta["args"] = QJsonObject{ { "name", buffer->threadName } };
+        events.append(meta);
+
+        for (const TraceEvent &event : buffer->events) {
+            // The format wants microseconds
+            QJsonObject entry;
+            entry["name"] = QString::fromLatin1(event.name);
+            entry["cat"] = QString::fromLatin1(event.category);
+            entry["ts"] = event.startNs / 1000.0;
+            entry["pid"] = pid;
+            entry["tid"] = buffer->tid;
+            if (!event.detail.isEmpty()) {
+                entry["args"] = QJsonObject{ { "detail", event.detail } };
+            }
+
+            if (event.async) {
+                // Begin/end pair matched by id
+                entry["ph"] = "b";
+                entry["id"] = ++asyncId;
+                events.append(entry);
+
+                QJsonObject end;
+                end["name"] = entry["name"];
+                end["cat"] = entry["cat"];
+                end["ph"] = "e";
+                end["id"] = asyncId;
+                end["ts"] = event.endNs / 1000.0;
+                end["pid"] = pid;
+                end["tid"] = buffer->tid;
+                events.append(end);
+            } else {
+                // Complete event; tdur is the thread (CPU) duration
+                entry["ph"] = "X";
+                entry["dur"] = (event.endNs - event.startNs) / 1000.0;
+                if (event.cpuNs >= 0) {
+                    entry["tdur"] = event.cpuNs / 1000.0;
+                }
+                events.append(entry);
+            }
+        }
+    }
+
+    QJsonObject root;
+    root["traceEvents"] = events;
+    root["displayTimeUnit"] = "ms";
+
+    QSaveFile file(s.outputPath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    return file.commit();
+}
+
+QHash<QString, Tracer::SpanTotal> Tracer::totals()
+{
+    QHash<QString, SpanTotal> result;
+
+    TraceState &s = state();
+    QMutexLocker locker(&s.mutex);
+    for (const auto &buffer : s.buffers) {
+        QMutexLocker bufferLocker(&buffer->mutex);
+        for (const TraceEvent &event : buffer->events) {
+            SpanTotal &total = result[QString::fromLatin1(event.name)];
+            const qint64 duration = event.endNs - event.startNs;
+            ++total.count;
+            total.totalNs += duration;
+            total.maxNs = qMax(total.maxNs, duration);
+            if (event.cpuNs > 0) {
+                total.cpuNs += event.cpuNs;
+            }
+        }
+    }
+    return result;
+}
@@ -0,0 +1,96 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <QHash>
+#include <QString>
+#include <atomic>
+
+// Built-in span tracer for startup and refresh latency.
+// Off by default; switched on with BOOX_TRACE=<file> (or BOOX_TRACE=1) in the
+// environment or --trace[=<file>] on the command line. Spans are recorded on
+// any thread into per-thread buffers and written at exit as Chrome
+// trace-event JSON, which chrome://tracing and ui.perfetto.dev open directly.
+// While disabled a span costs one relaxed atomic load.
+class Tracer
+{
+public:
+    static constexpr const char *DEFAULT_FILE = "boox-trace.json";
+
+    static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+    // Enable from BOOX_TRACE / --trace; call once at startup
+    static void configure(int argc, char *argv[]);
+    static void enable(const QString &outputPath);
+
+    // Write everything recorded so far to the output file
+    static bool write();
+
+    struct SpanTotal
+    {
+        int count = 0;
+        qint64 totalNs = 0;     // wall time
+        qint64 maxNs = 0;       // wall time
+        qint64 cpuNs = 0;       // CPU time of the recording thread
+    };
+    // Spans recorded so far, summed per name (for benchmark harnesses)
+    static QHash<QString, SpanTotal> totals();
+
+    // Nanoseconds since tracing was enabled
+    static qint64 now();
+    // CPU time consumed by the calling thread, in nanoseconds; -1 where the
+    // platform does not tell
+    static qint64 threadCpuNs();
+    // name and category must be string literals (they are not copied).
+    // cpuNs is the CPU time the thread spent in the span, -1 if unknown.
+    static void record(const char *name, const char *category, qint64 startNs, qint64 endNs,
+                       const QString &detail = QString(), qint64 cpuNs = -1);
+    // Same for an operation that spans event loop iterations (a request and
+    // its queued completion); shown on its own track instead of nested
+    static void recordAsync(const char *name, const char *category, qint64 startNs, qint64 endNs,
+                            const QString &detail = QString());
+
+private:
+    static std::atomic_bool enabled;
+};
+
+// Times the enclosing scope, in wall time and in CPU time of the thread.
+// Nested spans on one thread show up nested.
+class TraceSpan
+{
+public:
+    explicit TraceSpan(const char *name, const char *category = "boox")
+        : name(name), category(category), startNs(Tracer::isEnabled() ? Tracer::now() : -1),
+          startCpuNs(startNs >= 0 ? Tracer::threadCpuNs() : -1)
+    {
+    }
+
+    ~TraceSpan()
+    {
+        if (startNs >= 0) {
+            const qint64 endNs = Tracer::now();
+            const qint64 cpuNs = startCpuNs >= 0 ? Tracer::threadCpuNs() - startCpuNs : -1;
+            Tracer::record(name, category, startNs, endNs, detail, cpuNs);
+        }
+    }
+
+    bool isActive() const { return startNs >= 0; }
+    // Shown as args.detail in the trace viewer
+    void setDetail(const QString &text)
+    {
+        if (isActive()) {
+            detail = text;
+        }
+    }
+
+private:
+    TraceSpan(const TraceSpan &) = delete;
+    TraceSpan &operator=(const TraceSpan &) = delete;
+
+    const char *name;
+    const char *category;
+    qint64 startNs;
+    qint64 startCpuNs;
+    QString detail;
+};
+
+#endif // TRACER_H
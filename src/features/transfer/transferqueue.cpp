@@ -0,0 +1,489 @@
+#include "transferqueue.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QRunnable>
+#include <QVector>
+#include <atomic>
+#include <functional>
+#include <utility>
+#include "../copy/copyengine.h"
+#include "../names/nameindex.h"
+#include "../trace/tracer.h"
+
+#if defined(Q_OS_UNIX)
+#include <unistd.h>
+#endif
+#if defined(Q_OS_LINUX)
+#include <fcntl.h>
+#include <sys/stat.h>
+#endif
+
+// Shared between the queue (GUI thread) and the job's worker
+struct TransferJob
+{
+    struct Item
+    {
+        QString source;
+        QString target;
+        bool isDir = false;
+    };
+
+    QVector<Item> items;
+    bool verify = false;
+
+    std::atomic_bool cancelled{false};
+    std::atomic<qint64> totalBytes{-1};
+    std::atomic<qint64> doneBytes{0};
+
+    // GUI thread only
+    TransferStatus status;
+    qint64 reportedBytes = 0;
+    QElapsedTimer sinceReport;
+};
+
+namespace {
+
+// Bytes of regular files under path (path itself if it is a file)
+qint64 treeSize(const QString &path, const std::atomic_bool &cancelled)
+{
+    const QFileInfo info(path);
+    if (!info.isDir() || info.isSymLink()) {
+        return info.isSymLink() ? 0 : info.size();
+    }
+
+    qint64 total = 0;
+    QDirIterator it(path, QDir::Files | QDir::Hidden | QDir::System | QDir::NoDotAndDotDot,
+                    QDirIterator::Subdirectories);
+    while (it.hasNext() && !cancelled.load(std::memory_order_relaxed)) {
+        it.next();
+        if (!it.fileInfo().isSymLink()) {
+            total += it.fileInfo().size();
+        }
+    }
+    return total;
+}
+
+// Recreate the symlink at source as target with the same link text, so a
+// relative link still points next to itself once the tree has moved
+// Give a copied folder the permissions and modification time of its source.
+// Only call it once nothing more goes into the folder, since every new entry
+// changes its modification time.
+void copyFolderAttributes(const QString &source, const QString &target)
+{
+#if defined(Q_OS_LINUX)
+    struct stat st;
+    if (::stat(QFile::encodeName(source).constData(), &st) != 0) {
+        return;
+    }
+    const QByteArray path = QFile::encodeName(target);
+    ::chmod(path.constData(), st.st_mode & 07777);
+    const struct timespec times[2] = { st.st_atim, st.st_mtim };
+    ::utimensat(AT_FDCWD, path.constData(), times, 0);
+#else
+    // QFile cannot open a folder to set its times
+    QFile::setPermissions(target, QFileInfo(source).permissions());
+#endif
+}
+
+bool copySymLink(const QString &source, const QString &target)
+{
+#if defined(Q_OS_UNIX)
+    const QByteArray path = QFile::encodeName(source);
+    QByteArray text(256, Qt::Uninitialized);
+    for (;;) {
+        const ssize_t n = ::readlink(path.constData(), text.data(), size_t(text.size()));
+        if (n < 0) {
+            return false;
+        }
+        if (n < text.size()) {
+            text.truncate(int(n));
+            break;
+        }
+        text.resize(text.size() * 2);
+    }
+    return ::symlink(text.constData(), QFile::encodeName(target).constData()) == 0;
+#else
+    return QFile::link(QFileInfo(source).symLinkTarget(), target);
+#endif
+}
+
+class TransferTask : public QRunnable
+{
+public:
+    TransferTask(QObject *queue, quint64 id, std::shared_ptr<TransferJob> job,
+                 std::function<void(quint64, const QString &, bool, bool, const QString &)> onItem,
+                 std::function<void(quint64)> onDone)
+        : queue(queue), id(id), job(std::move(job))
+        , onItem(std::move(onItem)), onDone(std::move(onDone))
+    {
+    }
+
+    void run() override
+    {
+        TraceSpan span("TransferQueue::job", "transfer");
+
+        // 1. Items on the same device are simply renamed. The rename never
+        // replaces: a name taken since the target folder was listed fails
+        // the item rather than overwriting what is there now.
+        QVector<int> toCopy;
+        for (int i = 0; i < job->items.size(); ++i) {
+            const TransferJob::Item &item = job->items.at(i);
+            if (isCancelled()) {
+                finishItem(item, false);
+                continue;
+            }
+            switch (NameIndex::renameNoReplace(item.source, item.target)) {
+            case NameIndex::Renamed:
+                finishItem(item, true);
+                break;
+            case NameIndex::TargetExists:
+                finishItem(item, false);
+                break;
+            default:
+                if (QFileInfo::exists(item.source) || QFileInfo(item.source).isSymLink()) {
+                    toCopy.append(i);
+                } else {
+                    finishItem(item, false);
+                }
+                break;
+            }
+        }
+
+        // 2. The rest lives on another device: copy, then remove the source
+        if (!toCopy.isEmpty()) {
+            qint64 total = 0;
+            for (int i : toCopy) {
+                total += treeSize(job->items.at(i).source, job->cancelled);
+            }
+            // Verifying reads each copy back
+            job->totalBytes.store(job->verify ? 2 * total : total);
+
+            for (int i : toCopy) {
+                const TransferJob::Item &item = job->items.at(i);
+                itemMismatch = false;
+                const bool moved = !isCancelled() && moveAcross(item);
+                finishItem(item, moved, itemMismatch);
+            }
+        }
+
+        const quint64 jobId = id;
+        auto callback = onDone;
+        QMetaObject::invokeMethod(queue, [callback, jobId]() { callback(jobId); },
+                                  Qt::QueuedConnection);
+    }
+
+private:
+    bool isCancelled() const { return job->cancelled.load(std::memory_order_relaxed); }
+
+    void finishItem(const TransferJob::Item &item, bool ok, bool mismatch = false)
+    {
+        const quint64 jobId = id;
+        const QString target = item.target;
+        const QString name = QFileInfo(item.source).fileName();
+        auto callback = onItem;
+        QMetaObject::invokeMethod(queue, [callback, jobId, target, ok, mismatch, name]() {
+            callback(jobId, target, ok, mismatch, name);
+        }, Qt::QueuedConnection);
+    }
+
+    bool moveAcross(const TransferJob::Item &item)
+    {
+        // The target is created exclusively (mkdir here, O_EXCL in
+        // CopyEngine), so a name taken in the meantime fails the item and
+        // what is there is neither merged into nor cleaned up
+        if (item.isDir && !QDir().mkdir(item.target)) {
+            return false;
+        }
+        bool copied;
+        if (item.isDir) {
+            copied = copyTree(item.source, item.target);
+        } else if (QFileInfo(item.source).isSymLink()) {
+            copied = copySymLink(item.source, item.target);
+        } else {
+            copied = copyFile(item.source, item.target);
+        }
+        if (!copied) {
+            // Leave nothing half-written behind (a failed file copy has
+            // already been removed)
+            if (item.isDir) {
+                QDir(item.target).removeRecursively();
+            }
+            return false;
+        }
+
+        // The copy is complete; a source that cannot be removed fails the
+        // item but the copy is kept
+        return item.isDir ? QDir(item.source).removeRecursively() : QFile::remove(item.source);
+    }
+
+    bool copyTree(const QString &source, const QString &target)
+    {
+        if (!QDir().mkpath(target)) {
+            return false;
+        }
+
+        const QDir sourceDir(source);
+        const QDir targetDir(target);
+        // (source, copy) of every subfolder, parents before their children
+        QVector<QPair<QString, QString>> folders;
+        QDirIterator it(source, QDir::AllEntries | QDir::Hidden | QDir::System | QDir::NoDotAndDotDot,
+                        QDirIterator::Subdirectories);
+        while (it.hasNext()) {
+            if (isCancelled()) {
+                return false;
+            }
+            it.next();
+            const QFileInfo info = it.fileInfo();
+            const QString destination = targetDir.filePath(sourceDir.relativeFilePath(info.filePath()));
+
+            bool ok;
+            if (info.isSymLink()) {
+                ok = copySymLink(info.filePath(), destination);
+            } else if (info.isDir()) {
+                ok = QDir().mkpath(destination);
+                folders.append(qMakePair(info.filePath(), destination));
+            } else {
+                ok = copyFile(info.filePath(), destination);
+            }
+            if (!ok) {
+                return false;
+            }
+        }
+
+        // Deepest first, so that setting a folder's attributes cannot be
+        // undone by a change inside it, nor blocked by a read-only parent
+        for (int i = folders.size() - 1; i >= 0; --i) {
+            copyFolderAttributes(folders.at(i).first, folders.at(i).second);
+        }
+        copyFolderAttributes(source, target);
+        return true;
+    }
+
+    bool copyFile(const QString &source, const QString &target)
+    {
+        // Kernel-side copy where possible; keeps holes, permissions and times
+        const CopyEngine::ProgressCallback progress = [this](qint64 bytes) {
+            job->doneBytes.fetch_add(bytes, std::memory_order_relaxed);
+            return !isCancelled();
+        };
+        // When verifying, the source is hashed as it is copied, so only the
+        // copy has to be read back
+        const CopyEngine::Result result = CopyEngine::copyFile(source, target, progress,
+                                                               CopyEngine::AllMethods, job->verify);
+        if (!result.ok || !job->verify) {
+            return result.ok;
+        }
+
+        // Only a reflink is not hashed: it shares the source's extents, so
+        // nothing went over the wire
+        if (!result.hashed) {
+            progress(result.bytes);
+            return true;
+        }
+        TraceSpan span("TransferQueue::verify", "transfer");
+        const CopyEngine::Result check = CopyEngine::verifyTarget(target, result.sourceHash, progress);
+        if (!check.ok) {
+            itemMismatch = !check.cancelled;
+            QFile::remove(target);
+        }
+        return check.ok;
+    }
+
+    // Only used as the context of queued calls; never dereferenced here
+    QObject *queue;
+    quint64 id;
+    std::shared_ptr<TransferJob> job;
+    // Set when the current item's copy failed verification
+    bool itemMismatch = false;
+    std::function<void(quint64, const QString &, bool, bool, const QString &)> onItem;
+    std::function<void(quint64)> onDone;
+};
+
+} // namespace
+
+TransferQueue *TransferQueue::instance()
+{
+    static TransferQueue *queue = new TransferQueue(QCoreApplication::instance());
+    return queue;
+}
+
+TransferQueue::TransferQueue(QObject *parent)
+    : QObject(parent)
+{
+    pool.setMaxThreadCount(MAX_PARALLEL_JOBS);
+
+    progressTimer.setInterval(PROGRESS_INTERVAL_MS);
+    connect(&progressTimer, &QTimer::timeout, this, &TransferQueue::reportProgress);
+
+    // Unfinished copies are rolled back rather than left half-written
+    connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit, this, [this]() {
+        cancelAll();
+        pool.waitForDone();
+    });
+}
+
+TransferQueue::~TransferQueue()
+{
+    cancelAll();
+    pool.waitForDone();
+}
+
+quint64 TransferQueue::move(const QStringList &sources, const QString &targetFolder)
+{
+    const QString folder = QDir(targetFolder).absolutePath();
+    auto job = std::make_shared<TransferJob>();
+
+    // Names for the whole drop come from at most one listing of the target
+    // folder, taken only if a name is already in use (so dropping into a big
+    // zone does not list it here on the GUI thread); names still reserved by
+    // queued items count as taken
+    const QDir targetDir(folder);
+    NameIndex names(folder);
+    for (const QString &path : std::as_const(reserved)) {
+        const QFileInfo target(path);
+        if (target.path() == folder) {
+            names.insert(target.fileName());
+        }
+    }
+
+    for (const QString &sourcePath : sources) {
+        const QFileInfo source(sourcePath);
+        if (!source.exists() && !source.isSymLink()) {
+            continue;
+        }
+        // Already there
+        if (source.absolutePath() == folder) {
+            continue;
+        }
+
+        TransferJob::Item item;
+        item.source = source.absoluteFilePath();
+        item.isDir = source.isDir() && !source.isSymLink();
+        // A folder cannot be moved into itself
+        if (item.isDir && (folder == item.source || folder.startsWith(item.source + QLatin1Char('/')))) {
+            job->status.failed.append(source.fileName());
+            continue;
+        }
+        item.target = targetDir.absoluteFilePath(names.allocate(source.fileName(), item.isDir));
+        reserved.insert(item.target);
+        job->items.append(item);
+    }
+
+    if (job->items.isEmpty()) {
+        if (!job->status.failed.isEmpty()) {
+            job->status.targetFolder = folder;
+            job->status.finished = true;
+            emit jobFinished(job->status);
+        }
+        return 0;
+    }
+
+    const quint64 id = nextId++;
+    job->status.id = id;
+    job->status.targetFolder = folder;
+    job->status.itemCount = job->items.size();
+    job->verify = verifyCopies;
+    job->status.verify = verifyCopies;
+    job->sinceReport.start();
+    jobs.insert(id, job);
+
+    for (const TransferJob::Item &item : job->items) {
+        emit itemQueued(item.target, item.isDir);
+    }
+
+    pool.start(new TransferTask(this, id, job,
+        [this](quint64 jobId, const QString &target, bool ok, bool mismatch, const QString &name) {
+            onItemFinished(jobId, target, ok, mismatch, name);
+        },
+        [this](quint64 jobId) { onJobFinished(jobId); }));
+
+    if (!progressTimer.isActive()) {
+        progressTimer.start();
+    }
+    return id;
+}
+
+void TransferQueue::cancel(quint64 id)
+{
+    auto it = jobs.constFind(id);
+    if (it != jobs.constEnd()) {
+        it.value()->cancelled.store(true);
+        it.value()->status.cancelled = true;
+    }
+}
+
+void TransferQueue::cancelAll()
+{
+    for (auto it = jobs.constBegin(); it != jobs.constEnd(); ++it) {
+        cancel(it.key());
+    }
+}
+
+QList<TransferStatus> TransferQueue::activeJobs() const
+{
+    QList<TransferStatus> result;
+    for (const auto &job : jobs) {
+        result.append(job->status);
+    }
+    return result;
+}
+
+void TransferQueue::onItemFinished(quint64 id, const QString &targetPath, bool ok, bool mismatch,
+                                   const QString &name)
+{
+    reserved.remove(targetPath);
+
+    auto it = jobs.constFind(id);
+    if (it != jobs.constEnd()) {
+        TransferStatus &status = it.value()->status;
+        ++status.itemsDone;
+        if (!ok) {
+            status.failed.append(name);
+        }
+        if (mismatch) {
+            status.mismatched.append(name);
+        }
+    }
+    emit itemFinished(targetPath, ok);
+}
+
+void TransferQueue::onJobFinished(quint64 id)
+{
+    const std::shared_ptr<TransferJob> job = jobs.take(id);
+    if (!job) {
+        return;
+    }
+
+    job->status.totalBytes = job->totalBytes.load();
+    job->status.doneBytes = job->doneBytes.load();
+    job->status.finished = true;
+    if (jobs.isEmpty()) {
+        progressTimer.stop();
+    }
+    emit jobFinished(job->status);
+}
+
+void TransferQueue::reportProgress()
+{
+    for (const auto &job : jobs) {
+        TransferStatus &status = job->status;
+        status.totalBytes = job->totalBytes.load(std::memory_order_relaxed);
+        status.doneBytes = job->doneBytes.load(std::memory_order_relaxed);
+
+        // Smoothed so a single slow chunk does not make the rate jump
+        const qint64 elapsedMs = job->sinceReport.restart();
+        if (elapsedMs > 0) {
+            const double current = (status.doneBytes - job->reportedBytes) * 1000.0 / elapsedMs;
+            status.bytesPerSecond = status.bytesPerSecond > 0
+                ? 0.7 * status.bytesPerSecond + 0.3 * current
+                : current;
+        }
+        job->reportedBytes = status.doneBytes;
+
+        emit jobProgress(status);
+    }
+}
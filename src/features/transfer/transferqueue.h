@@ -0,0 +1,93 @@
+#ifndef TRANSFERQUEUE_H
+#define TRANSFERQUEUE_H
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+#include <QThreadPool>
+#include <QTimer>
+#include <memory>
+
+struct TransferJob;
+
+// Snapshot of one transfer job, as reported to the GUI
+struct TransferStatus
+{
+    quint64 id = 0;
+    QString targetFolder;
+    int itemCount = 0;
+    int itemsDone = 0;
+    qint64 totalBytes = -1;      // bytes to copy (and verify) across devices; -1 while counting
+    qint64 doneBytes = 0;
+    double bytesPerSecond = 0;   // smoothed copy throughput
+    QStringList failed;          // names of items that could not be moved
+    QStringList mismatched;      // of those, copies that did not match (source kept)
+    bool verify = false;
+    bool cancelled = false;
+    bool finished = false;
+};
+
+// Moves dropped files and folders into a folder on worker threads.
+// Each move() is one job; a job first tries a plain rename for every item,
+// and items on another device are then copied (folders recursively, with
+// permissions and modification times; folder times on Linux only) and
+// removed at the source once the copy is complete (see CopyEngine). A
+// cancelled or failed copy removes what it had written. With verification
+// on, each copied file is hashed against its source before the source goes;
+// on a mismatch the copy is removed and the source kept.
+// Target names are chosen when the job is queued, from at most one listing
+// of the target folder for the whole drop (see NameIndex), so zones can show
+// the items as pending right away; the moves never replace an existing item.
+// Progress is reported a few times a second.
+class TransferQueue : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int MAX_PARALLEL_JOBS = 2;
+    static constexpr int PROGRESS_INTERVAL_MS = 250;
+
+    static TransferQueue *instance();
+
+    // Queue moving `sources` into `targetFolder`. Items already in the
+    // folder are skipped. Returns the job id, or 0 if there is nothing to do.
+    quint64 move(const QStringList &sources, const QString &targetFolder);
+
+    void cancel(quint64 id);
+    void cancelAll();
+
+    // Applies to jobs queued afterwards; off by default
+    void setVerifyCopies(bool on) { verifyCopies = on; }
+    bool isVerifyingCopies() const { return verifyCopies; }
+
+    bool isBusy() const { return !jobs.isEmpty(); }
+    QList<TransferStatus> activeJobs() const;
+
+signals:
+    // An item will appear at targetPath once its job gets to it
+    void itemQueued(const QString &targetPath, bool isDir);
+    // The item is in place (ok) or its move failed / was cancelled
+    void itemFinished(const QString &targetPath, bool ok);
+    void jobProgress(const TransferStatus &status);
+    void jobFinished(const TransferStatus &status);
+
+private:
+    explicit TransferQueue(QObject *parent = nullptr);
+    ~TransferQueue() override;
+
+    void onItemFinished(quint64 id, const QString &targetPath, bool ok, bool mismatch,
+                        const QString &name);
+    void onJobFinished(quint64 id);
+    void reportProgress();
+
+    QThreadPool pool;
+    QHash<quint64, std::shared_ptr<TransferJob>> jobs;
+    // Target paths handed out to queued or running items
+    QSet<QString> reserved;
+    QTimer progressTimer;
+    quint64 nextId = 1;
+    bool verifyCopies = false;
+};
+
+#endif // TRANSFERQUEUE_H
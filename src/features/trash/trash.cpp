@@ -0,0 +1,472 @@
+#include "trash.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QStandardPaths>
+#include <QUrl>
+#include <algorithm>
+#include <utility>
+#include "../delete/deletequeue.h"
+#include "../names/nameindex.h"
+#include "../trace/tracer.h"
+
+#if defined(Q_OS_UNIX) && !defined(Q_OS_DARWIN)
+#define BOOX_FREEDESKTOP_TRASH
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+void setError(QString *error, const QString &message)
+{
+    if (error) {
+        *error = message;
+    }
+}
+
+#if defined(BOOX_FREEDESKTOP_TRASH)
+
+constexpr const char INFO_SUFFIX[] = ".trashinfo";
+
+QString systemError()
+{
+    return QString::fromLocal8Bit(std::strerror(errno));
+}
+
+bool deviceOf(const QString &path, dev_t &device)
+{
+    struct stat st;
+    if (::lstat(QFile::encodeName(path).constData(), &st) != 0) {
+        return false;
+    }
+    device = st.st_dev;
+    return true;
+}
+
+bool isDirectory(const QString &path)
+{
+    struct stat st;
+    return ::lstat(QFile::encodeName(path).constData(), &st) == 0 && S_ISDIR(st.st_mode);
+}
+
+// Topmost folder above `path` on the same device: its mount point
+QString mountPoint(const QString &path, dev_t device)
+{
+    QString current = QDir::cleanPath(path);
+    for (;;) {
+        const QString parent = QFileInfo(current).path();
+        dev_t parentDevice;
+        if (parent == current || !deviceOf(parent, parentDevice) || parentDevice != device) {
+            return current;
+        }
+        current = parent;
+    }
+}
+
+// root, root/files and root/info, owner-only
+bool ensureTrash(const QString &root)
+{
+    for (const QString &dir : { root, root + QStringLiteral("/files"), root + QStringLiteral("/info") }) {
+        if (::mkdir(QFile::encodeName(dir).constData(), 0700) != 0 && errno != EEXIST) {
+            return false;
+        }
+        if (!isDirectory(dir)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool hasTrash(const QString &root)
+{
+    return isDirectory(root + QStringLiteral("/files")) && isDirectory(root + QStringLiteral("/info"));
+}
+
+struct TrashDir
+{
+    QString root;
+    QString topDir;   // paths in .trashinfo are relative to it; empty: absolute
+};
+
+// The trash on the same file system as `folder`, created if `create`
+TrashDir trashDirFor(const QString &path, bool create)
+{
+    // Resolved first: a symlink on the way (a boox root linked to another
+    // disk) would otherwise end the walk up to the mount point early
+    const QString folder = QFileInfo(path).canonicalFilePath();
+    dev_t device;
+    if (folder.isEmpty() || !deviceOf(folder, device)) {
+        return TrashDir();
+    }
+
+    // The home trash, if the folder lives on the home file system
+    const QString dataHome = QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation);
+    const QString home = dataHome + QStringLiteral("/Trash");
+    QString existing = dataHome;
+    while (!QFileInfo::exists(existing) && QFileInfo(existing).path() != existing) {
+        existing = QFileInfo(existing).path();
+    }
+    dev_t homeDevice;
+    if (deviceOf(existing, homeDevice) && homeDevice == device) {
+        if (create) {
+            QDir().mkpath(dataHome);
+            if (!ensureTrash(home)) {
+                return TrashDir();
+            }
+        } else if (!hasTrash(home)) {
+            return TrashDir();
+        }
+        return TrashDir{ home, QString() };
+    }
+
+    const QString top = mountPoint(folder, device);
+    const QString uid = QString::number(::getuid());
+
+    // $topdir/.Trash set up by an administrator: a sticky folder, not a symlink
+    const QString shared = top + QStringLiteral("/.Trash");
+    struct stat st;
+    if (::lstat(QFile::encodeName(shared).constData(), &st) == 0
+        && S_ISDIR(st.st_mode) && (st.st_mode & S_ISVTX)) {
+        const QString own = shared + QLatin1Char('/') + uid;
+        if (hasTrash(own) || (create && ensureTrash(own))) {
+            return TrashDir{ own, top };
+        }
+    }
+
+    const QString own = top + QStringLiteral("/.Trash-") + uid;
+    if (hasTrash(own) || (create && ensureTrash(own))) {
+        return TrashDir{ own, top };
+    }
+    return TrashDir();
+}
+
+bool readInfo(const QString &infoPath, const QString &topDir, TrashEntry &entry)
+{
+    QFile file(infoPath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    bool inSection = false;
+    while (!file.atEnd()) {
+        const QByteArray line = file.readLine().trimmed();
+        if (line.startsWith('[')) {
+            inSection = line == "[Trash Info]";
+        } else if (inSection && line.startsWith("Path=")) {
+            const QString path = QUrl::fromPercentEncoding(line.mid(5));
+            entry.originalPath = QDir::isAbsolutePath(path) || topDir.isEmpty()
+                ? path : QDir(topDir).filePath(path);
+        } else if (inSection && line.startsWith("DeletionDate=")) {
+            entry.deletionDate = QDateTime::fromString(QString::fromLatin1(line.mid(13)), Qt::ISODate);
+        }
+    }
+    entry.infoPath = infoPath;
+    return !entry.originalPath.isEmpty();
+}
+
+#elif defined(Q_OS_WIN)
+
+// The Recycle Bin keeps an item as $R<id> and its metadata as $I<id>
+QString recycleBinInfo(const QString &trashedPath)
+{
+    const QFileInfo info(trashedPath);
+    if (!info.fileName().startsWith(QLatin1String("$R"))) {
+        return QString();
+    }
+    return info.dir().filePath(QLatin1String("$I") + info.fileName().mid(2));
+}
+
+#endif
+
+#if !defined(BOOX_FREEDESKTOP_TRASH)
+// Items trashed in this session; the system trash cannot be listed here
+QList<TrashEntry> &sessionEntries()
+{
+    static QList<TrashEntry> entries;
+    return entries;
+}
+#endif
+
+} // namespace
+
+Trash *Trash::instance()
+{
+    static Trash *trash = new Trash(QCoreApplication::instance());
+    return trash;
+}
+
+Trash::Trash(QObject *parent)
+    : QObject(parent)
+{
+    connect(DeleteQueue::instance(), &DeleteQueue::itemRemoved, this, &Trash::onItemRemoved);
+}
+
+TrashEntry Trash::moveToTrash(const QString &path, QString *error)
+{
+    TraceSpan span("Trash::moveToTrash", "trash");
+
+    const QFileInfo source(path);
+    if (!source.exists() && !source.isSymLink()) {
+        setError(error, tr("\"%1\" 不存在").arg(source.fileName()));
+        return TrashEntry();
+    }
+
+    TrashEntry entry;
+    entry.originalPath = source.absoluteFilePath();
+    entry.deletionDate = QDateTime::currentDateTime();
+
+#if defined(BOOX_FREEDESKTOP_TRASH)
+    const TrashDir trash = trashDirFor(source.absolutePath(), true);
+    if (trash.root.isEmpty()) {
+        setError(error, tr("此磁盘上没有可用的回收站"));
+        return TrashEntry();
+    }
+
+    // Relative to the top directory where it lies below it; an item reached
+    // through a symlink keeps its absolute path
+    const bool belowTop = !trash.topDir.isEmpty()
+        && entry.originalPath.startsWith(trash.topDir + QLatin1Char('/'));
+    const QString recordedPath = belowTop
+        ? QDir(trash.topDir).relativeFilePath(entry.originalPath) : entry.originalPath;
+    const QByteArray info = "[Trash Info]\nPath=" + QUrl::toPercentEncoding(recordedPath, "/")
+        + "\nDeletionDate="
+        + entry.deletionDate.toString(QStringLiteral("yyyy-MM-dd'T'hh:mm:ss")).toLatin1() + "\n";
+
+    // Creating the .trashinfo exclusively reserves the name in the trash
+    const bool isDir = source.isDir() && !source.isSymLink();
+    const QString baseName = source.completeBaseName();
+    const QString suffix = source.suffix();
+    int fd = -1;
+    for (int counter = 0; fd < 0; ++counter) {
+        QString name = source.fileName();
+        if (counter > 0) {
+            name = isDir || suffix.isEmpty()
+                ? QStringLiteral("%1_%2").arg(baseName).arg(counter)
+                : QStringLiteral("%1_%2.%3").arg(baseName).arg(counter).arg(suffix);
+        }
+        entry.infoPath = trash.root + QStringLiteral("/info/") + name + QLatin1String(INFO_SUFFIX);
+        entry.trashedPath = trash.root + QStringLiteral("/files/") + name;
+
+        const QByteArray infoName = QFile::encodeName(entry.infoPath);
+        fd = ::open(infoName.constData(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+        if (fd < 0 && errno != EEXIST) {
+            setError(error, systemError());
+            return TrashEntry();
+        }
+        // A left-over item without info may still hold the name
+        struct stat st;
+        if (fd >= 0 && ::lstat(QFile::encodeName(entry.trashedPath).constData(), &st) == 0) {
+            ::close(fd);
+            ::unlink(infoName.constData());
+            fd = -1;
+        }
+    }
+
+    const QByteArray infoName = QFile::encodeName(entry.infoPath);
+    const bool written = ::write(fd, info.constData(), size_t(info.size())) == info.size();
+    ::close(fd);
+    if (!written || ::rename(QFile::encodeName(entry.originalPath).constData(),
+                             QFile::encodeName(entry.trashedPath).constData()) != 0) {
+        setError(error, systemError());
+        ::unlink(infoName.constData());
+        return TrashEntry();
+    }
+#else
+    QString pathInTrash;
+    if (!QFile::moveToTrash(entry.originalPath, &pathInTrash)) {
+        setError(error, tr("无法移到回收站"));
+        return TrashEntry();
+    }
+    entry.trashedPath = pathInTrash;
+    sessionEntries().append(entry);
+#endif
+
+    emit itemTrashed(entry.originalPath);
+    return entry;
+}
+
+QStringList Trash::moveToTrash(const QStringList &paths)
+{
+    QList<TrashEntry> trashed;
+    QStringList failed;
+    for (const QString &path : paths) {
+        const TrashEntry entry = moveToTrash(path);
+        if (entry.isValid()) {
+            trashed.append(entry);
+        } else {
+            failed.append(path);
+        }
+    }
+
+    if (!trashed.isEmpty()) {
+        batch = trashed;
+        emit lastBatchChanged();
+    }
+    return failed;
+}
+
+bool Trash::restore(const TrashEntry &entry, QString *error)
+{
+    TraceSpan span("Trash::restore", "trash");
+
+    const QFileInfo original(entry.originalPath);
+    if (original.exists() || original.isSymLink()) {
+        setError(error, tr("\"%1\" 已存在").arg(original.fileName()));
+        return false;
+    }
+    if (entry.trashedPath.isEmpty()) {
+        setError(error, tr("\"%1\" 无法从回收站恢复").arg(original.fileName()));
+        return false;
+    }
+    QDir().mkpath(original.absolutePath());
+
+    // Something may have taken the name since the check above; it is kept
+    switch (NameIndex::renameNoReplace(entry.trashedPath, entry.originalPath)) {
+    case NameIndex::Renamed:
+        break;
+    case NameIndex::TargetExists:
+        setError(error, tr("\"%1\" 已存在").arg(original.fileName()));
+        return false;
+    default:
+        setError(error, tr("\"%1\" 无法从回收站恢复").arg(original.fileName()));
+        return false;
+    }
+
+#if defined(BOOX_FREEDESKTOP_TRASH)
+    ::unlink(QFile::encodeName(entry.infoPath).constData());
+#else
+#if defined(Q_OS_WIN)
+    QFile::remove(recycleBinInfo(entry.trashedPath));
+#endif
+    QList<TrashEntry> &known = sessionEntries();
+    known.erase(std::remove_if(known.begin(), known.end(), [&entry](const TrashEntry &other) {
+        return other.trashedPath == entry.trashedPath;
+    }), known.end());
+#endif
+
+    emit itemRestored(entry.originalPath);
+    return true;
+}
+
+QStringList Trash::restoreLastBatch()
+{
+    QStringList failed;
+    QList<TrashEntry> remaining;
+    for (const TrashEntry &entry : std::as_const(batch)) {
+        if (!restore(entry)) {
+            failed.append(QFileInfo(entry.originalPath).fileName());
+            remaining.append(entry);
+        }
+    }
+    batch = remaining;
+    emit lastBatchChanged();
+    return failed;
+}
+
+QList<TrashEntry> Trash::entries(const QString &folder) const
+{
+    const QString prefix = folder.isEmpty() ? QString() : QDir(folder).absolutePath() + QLatin1Char('/');
+    auto cameFromFolder = [&prefix](const TrashEntry &entry) {
+        return prefix.isEmpty() || entry.originalPath.startsWith(prefix);
+    };
+
+    QList<TrashEntry> result;
+#if defined(BOOX_FREEDESKTOP_TRASH)
+    QList<TrashDir> trashes;
+    const TrashDir home = trashDirFor(QDir::homePath(), false);
+    if (!home.root.isEmpty()) {
+        trashes.append(home);
+    }
+    if (!folder.isEmpty()) {
+        const TrashDir own = trashDirFor(QDir(folder).absolutePath(), false);
+        if (!own.root.isEmpty() && own.root != home.root) {
+            trashes.append(own);
+        }
+    }
+
+    for (const TrashDir &trash : std::as_const(trashes)) {
+        const QDir infoDir(trash.root + QStringLiteral("/info"));
+        const QStringList names = infoDir.entryList(
+            { QStringLiteral("*") + QLatin1String(INFO_SUFFIX) }, QDir::Files | QDir::Hidden);
+        for (const QString &name : names) {
+            TrashEntry entry;
+            if (!readInfo(infoDir.filePath(name), trash.topDir, entry) || !cameFromFolder(entry)) {
+                continue;
+            }
+            entry.trashedPath = trash.root + QStringLiteral("/files/")
+                + name.chopped(int(sizeof(INFO_SUFFIX) - 1));
+            if (purging.contains(entry.trashedPath)) {
+                continue;
+            }
+            if (QFileInfo::exists(entry.trashedPath) || QFileInfo(entry.trashedPath).isSymLink()) {
+                result.append(entry);
+            }
+        }
+    }
+#else
+    for (const TrashEntry &entry : std::as_const(sessionEntries())) {
+        if (cameFromFolder(entry) && !purging.contains(entry.trashedPath)
+            && QFileInfo::exists(entry.trashedPath)) {
+            result.append(entry);
+        }
+    }
+#endif
+    return result;
+}
+
+void Trash::purge(const QList<TrashEntry> &entries)
+{
+    QStringList paths;
+    for (const TrashEntry &entry : entries) {
+        if (entry.trashedPath.isEmpty()) {
+            continue;
+        }
+#if defined(BOOX_FREEDESKTOP_TRASH)
+        const QString infoPath = entry.infoPath;
+#elif defined(Q_OS_WIN)
+        const QString infoPath = recycleBinInfo(entry.trashedPath);
+#else
+        const QString infoPath;
+#endif
+        const QFileInfo item(entry.trashedPath);
+        if (!item.exists() && !item.isSymLink()) {
+            if (!infoPath.isEmpty()) {
+                QFile::remove(infoPath);
+            }
+            continue;
+        }
+        // Hidden from entries() right away; the info file is removed once
+        // the item is gone (see onItemRemoved)
+        purging.insert(item.absoluteFilePath(), infoPath);
+        paths.append(entry.trashedPath);
+    }
+
+    const int before = batch.size();
+    batch.erase(std::remove_if(batch.begin(), batch.end(), [&paths](const TrashEntry &entry) {
+        return paths.contains(entry.trashedPath);
+    }), batch.end());
+    if (batch.size() != before) {
+        emit lastBatchChanged();
+    }
+
+    DeleteQueue::instance()->remove(paths, DeleteQueue::Background);
+}
+
+void Trash::onItemRemoved(const QString &path, bool ok)
+{
+    auto it = purging.find(path);
+    if (it == purging.end()) {
+        return;
+    }
+    // A partly removed item keeps its info, so it is listed (and can be
+    // emptied) again
+    if (ok && !it.value().isEmpty()) {
+        QFile::remove(it.value());
+    }
+    purging.erase(it);
+}
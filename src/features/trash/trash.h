@@ -0,0 +1,73 @@
+#ifndef TRASH_H
+#define TRASH_H
+
+#include <QDateTime>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QStringList>
+
+// One item in the trash
+struct TrashEntry
+{
+    QString trashedPath;    // the item itself, inside the trash (empty if unknown)
+    QString infoPath;       // its .trashinfo (freedesktop trash only)
+    QString originalPath;
+    QDateTime deletionDate;
+
+    bool isValid() const { return !originalPath.isEmpty(); }
+};
+
+// Moves files and folders to the trash and back, both as a single rename.
+// On Unix this is the freedesktop.org trash: the home trash
+// ($XDG_DATA_HOME/Trash) for items on the home file system, else
+// $topdir/.Trash/$uid or $topdir/.Trash-$uid on the item's own mount, each
+// item with an info/<name>.trashinfo next to files/<name>. An item is never
+// copied into a trash on another file system; moveToTrash() fails instead.
+// On Windows items go to the Recycle Bin.
+// Emptying hides the entries from the trash listing at once and deletes
+// their files on DeleteQueue in the background; an entry's info file goes
+// only once its item is gone, so an interrupted purge leaves it listed.
+class Trash : public QObject
+{
+    Q_OBJECT
+
+public:
+    static Trash *instance();
+
+    // Trash each of `paths`; the trashed ones become the undoable batch.
+    // Returns the paths that could not be trashed.
+    QStringList moveToTrash(const QStringList &paths);
+    TrashEntry moveToTrash(const QString &path, QString *error = nullptr);
+
+    // Put the item back where it was (a rename). Fails if something else is
+    // there now.
+    bool restore(const TrashEntry &entry, QString *error = nullptr);
+
+    // The last batch trashed through moveToTrash(QStringList)
+    QList<TrashEntry> lastBatch() const { return batch; }
+    // Restore the last batch; returns the names that could not be restored,
+    // which stay in the batch so restoring can be tried again
+    QStringList restoreLastBatch();
+
+    // Trashed items that came from `folder` (or from anywhere if empty)
+    QList<TrashEntry> entries(const QString &folder = QString()) const;
+    // Delete for good, in the background at idle priority
+    void purge(const QList<TrashEntry> &entries);
+
+signals:
+    void itemTrashed(const QString &originalPath);
+    void itemRestored(const QString &originalPath);
+    void lastBatchChanged();
+
+private:
+    explicit Trash(QObject *parent = nullptr);
+
+    void onItemRemoved(const QString &path, bool ok);
+
+    QList<TrashEntry> batch;
+    // Items being purged -> their info file (removed once the item is gone)
+    QHash<QString, QString> purging;
+};
+
+#endif // TRASH_H
@@ -0,0 +1,298 @@
+#include "watchservice.h"
+#include <QCoreApplication>
+#include <QFile>
+#include <QFileSystemWatcher>
+#include <QThread>
+
+#ifdef Q_OS_LINUX
+#include <sys/inotify.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+WatchService *WatchService::instance()
+{
+    static WatchService *service = new WatchService(QCoreApplication::instance());
+    return service;
+}
+
+WatchService::WatchService(QObject *parent)
+    : QObject(parent)
+{
+    if (!startInotify()) {
+        fallback = new QFileSystemWatcher(this);
+        connect(fallback, &QFileSystemWatcher::directoryChanged, this, [this](const QString &path) {
+            // The watch may be dropped on some filesystems; re-add it
+            if (subscriptions.contains(path) && !fallback->directories().contains(path)) {
+                fallback->addPath(path);
+            }
+            dispatch(path, QVector<WatchEvent>{ WatchEvent() });
+        });
+    }
+}
+
+WatchService::~WatchService()
+{
+#ifdef Q_OS_LINUX
+    if (reader) {
+        const char stop = 1;
+        ssize_t written = ::write(wakeFds[1], &stop, 1);
+        Q_UNUSED(written);
+        reader->wait();
+        delete reader;
+    }
+    if (inotifyFd >= 0) {
+        ::close(inotifyFd);
+    }
+    for (int fd : wakeFds) {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+#endif
+}
+
+bool WatchService::startInotify()
+{
+#ifdef Q_OS_LINUX
+    inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd < 0) {
+        return false;
+    }
+    if (::pipe2(wakeFds, O_CLOEXEC | O_NONBLOCK) != 0) {
+        ::close(inotifyFd);
+        inotifyFd = -1;
+        return false;
+    }
+
+    reader = QThread::create([this]() { readLoop(); });
+    reader->setObjectName(QStringLiteral("BooxWatch"));
+    reader->start();
+    return true;
+#else
+    return false;
+#endif
+}
+
+void WatchService::readLoop()
+{
+#ifdef Q_OS_LINUX
+    // Large enough for a burst of events with long names
+    alignas(inotify_event) char buffer[64 * 1024];
+
+    for (;;) {
+        pollfd fds[2] = {
+            { inotifyFd, POLLIN, 0 },
+            { wakeFds[0], POLLIN, 0 }
+        };
+        if (::poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        if (fds[1].revents) {
+            return;
+        }
+        if (!(fds[0].revents & POLLIN)) {
+            continue;
+        }
+
+        QVector<QPair<int, WatchEvent>> batch;
+        for (;;) {
+            const ssize_t length = ::read(inotifyFd, buffer, sizeof(buffer));
+            if (length <= 0) {
+                break;
+            }
+
+            for (char *p = buffer; p < buffer + length; ) {
+                const inotify_event *raw = reinterpret_cast<const inotify_event *>(p);
+                p += sizeof(inotify_event) + raw->len;
+
+                WatchEvent event;
+                event.isDir = raw->mask & IN_ISDIR;
+                event.cookie = raw->cookie;
+                if (raw->len > 0) {
+                    event.name = QFile::decodeName(raw->name);
+                }
+
+                if (raw->mask & IN_Q_OVERFLOW) {
+                    event.kind = WatchEvent::Rescan;
+                } else if (raw->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) {
+                    event.kind = WatchEvent::FolderGone;
+                    // A moved folder keeps its watch in the kernel; drop it
+                    // before the GUI thread can watch the path again. The
+                    // IN_IGNORED that follows finds no mapping and is skipped.
+                    if (raw->mask & IN_MOVE_SELF) {
+                        inotify_rm_watch(inotifyFd, raw->wd);
+                    }
+                } else if (raw->mask & IN_CREATE) {
+                    event.kind = WatchEvent::Created;
+                } else if (raw->mask & IN_DELETE) {
+                    event.kind = WatchEvent::Deleted;
+                } else if (raw->mask & IN_MOVED_FROM) {
+                    event.kind = WatchEvent::MovedFrom;
+                } else if (raw->mask & IN_MOVED_TO) {
+                    event.kind = WatchEvent::MovedTo;
+                } else {
+                    event.kind = WatchEvent::Modified;
+                }
+                batch.append(qMakePair(raw->wd, event));
+            }
+        }
+
+        if (!batch.isEmpty()) {
+            QMetaObject::invokeMethod(this, [this, batch]() { deliver(batch); },
+                                      Qt::QueuedConnection);
+        }
+    }
+#endif
+}
+
+void WatchService::addWatch(const QString &path)
+{
+#ifdef Q_OS_LINUX
+    if (inotifyFd >= 0) {
+        // Writes show up on close, not on every write() call
+        const uint32_t mask = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO
+                            | IN_CLOSE_WRITE | IN_ATTRIB
+                            | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+        const int wd = inotify_add_watch(inotifyFd, QFile::encodeName(path).constData(), mask);
+        if (wd >= 0) {
+            pathByWd.insert(wd, path);
+            wdByPath.insert(path, wd);
+        }
+        return;
+    }
+#endif
+    fallback->addPath(path);
+}
+
+void WatchService::removeWatch(const QString &path)
+{
+#ifdef Q_OS_LINUX
+    if (inotifyFd >= 0) {
+        // inotify watch descriptors start at 1
+        const int wd = wdByPath.take(path);
+        if (wd > 0) {
+            pathByWd.remove(wd);
+            inotify_rm_watch(inotifyFd, wd);
+        }
+        return;
+    }
+#endif
+    fallback->removePath(path);
+}
+
+void WatchService::subscribe(QObject *owner, const QString &path, Callback callback)
+{
+    QVector<Subscription> &subs = subscriptions[path];
+    for (Subscription &sub : subs) {
+        if (sub.owner == owner) {
+            sub.callback = std::move(callback);
+            return;
+        }
+    }
+
+    const bool firstForPath = subs.isEmpty();
+    subs.append(Subscription{ owner, std::move(callback) });
+
+    if (!pathsByOwner.contains(owner)) {
+        connect(owner, &QObject::destroyed, this, [this](QObject *gone) {
+            unsubscribeAll(gone);
+        });
+    }
+    pathsByOwner[owner].append(path);
+
+    if (firstForPath) {
+        addWatch(path);
+    }
+}
+
+void WatchService::unsubscribe(QObject *owner, const QString &path)
+{
+    auto it = subscriptions.find(path);
+    if (it == subscriptions.end()) {
+        return;
+    }
+
+    QVector<Subscription> &subs = it.value();
+    for (int i = 0; i < subs.size(); ++i) {
+        if (subs.at(i).owner == owner) {
+            subs.remove(i);
+            break;
+        }
+    }
+    if (subs.isEmpty()) {
+        subscriptions.erase(it);
+        removeWatch(path);
+    }
+
+    auto owned = pathsByOwner.find(owner);
+    if (owned != pathsByOwner.end()) {
+        owned->removeAll(path);
+    }
+}
+
+void WatchService::unsubscribeAll(QObject *owner)
+{
+    const QStringList paths = pathsByOwner.take(owner);
+    for (const QString &path : paths) {
+        unsubscribe(owner, path);
+    }
+    disconnect(owner, &QObject::destroyed, this, nullptr);
+}
+
+void WatchService::deliver(const QVector<QPair<int, WatchEvent>> &batch)
+{
+    // Group per folder, keeping the kernel's order within each
+    QHash<QString, QVector<WatchEvent>> byPath;
+    bool overflow = false;
+
+    for (const auto &item : batch) {
+        if (item.first < 0) {
+            overflow = true;
+            continue;
+        }
+        const QString path = pathByWd.value(item.first);
+        if (path.isEmpty()) {
+            continue;
+        }
+        // Changes to the folder itself (IN_ATTRIB from chmod, touch or
+        // xattrs) name no entry; subscribers only track entries
+        if (item.second.name.isEmpty() && item.second.kind != WatchEvent::Rescan
+            && item.second.kind != WatchEvent::FolderGone) {
+            continue;
+        }
+        byPath[path].append(item.second);
+
+        if (item.second.kind == WatchEvent::FolderGone) {
+            // The kernel has dropped this watch
+            pathByWd.remove(item.first);
+            wdByPath.remove(path);
+        }
+    }
+
+    if (overflow) {
+        for (auto it = subscriptions.constBegin(); it != subscriptions.constEnd(); ++it) {
+            byPath[it.key()].append(WatchEvent());
+        }
+    }
+
+    for (auto it = byPath.constBegin(); it != byPath.constEnd(); ++it) {
+        dispatch(it.key(), it.value());
+    }
+}
+
+void WatchService::dispatch(const QString &path, const QVector<WatchEvent> &events)
+{
+    // Callbacks may (un)subscribe; iterate over a copy
+    const QVector<Subscription> subs = subscriptions.value(path);
+    for (const Subscription &sub : subs) {
+        if (sub.callback) {
+            sub.callback(events);
+        }
+    }
+}
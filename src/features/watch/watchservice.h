@@ -0,0 +1,85 @@
+#ifndef WATCHSERVICE_H
+#define WATCHSERVICE_H
+
+#include <QObject>
+#include <QHash>
+#include <QPair>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <functional>
+
+class QFileSystemWatcher;
+class QThread;
+
+// A change inside a watched folder
+struct WatchEvent
+{
+    enum Kind {
+        Created,
+        Deleted,
+        Modified,
+        MovedFrom,      // renamed away from the folder; pairs with MovedTo by cookie
+        MovedTo,
+        Rescan,         // details lost (queue overflow, or no typed backend): rescan the folder
+        FolderGone      // the watched folder itself was deleted or moved
+    };
+
+    Kind kind = Rescan;
+    QString name;       // entry name inside the folder (empty for Rescan/FolderGone)
+    bool isDir = false;
+    quint32 cookie = 0;
+};
+
+// Process-wide folder watching for all zones.
+// On Linux a single inotify descriptor is read on a dedicated thread and
+// typed events (which entry, what happened) are delivered to the subscribers
+// of each folder on the GUI thread. Elsewhere, or if inotify is unavailable,
+// one shared QFileSystemWatcher backs all subscriptions and reports Rescan.
+class WatchService : public QObject
+{
+    Q_OBJECT
+
+public:
+    using Callback = std::function<void(const QVector<WatchEvent> &events)>;
+
+    static WatchService *instance();
+
+    // Deliver events for folder `path` to callback; dropped with owner
+    void subscribe(QObject *owner, const QString &path, Callback callback);
+    void unsubscribe(QObject *owner, const QString &path);
+    void unsubscribeAll(QObject *owner);
+
+private:
+    explicit WatchService(QObject *parent = nullptr);
+    ~WatchService() override;
+
+    struct Subscription
+    {
+        QObject *owner;
+        Callback callback;
+    };
+
+    bool startInotify();
+    void readLoop();
+    void addWatch(const QString &path);
+    void removeWatch(const QString &path);
+    void deliver(const QVector<QPair<int, WatchEvent>> &batch);
+    void dispatch(const QString &path, const QVector<WatchEvent> &events);
+
+    // GUI thread only
+    QHash<QString, QVector<Subscription>> subscriptions;
+    QHash<QObject*, QStringList> pathsByOwner;
+
+    // inotify backend
+    int inotifyFd = -1;
+    int wakeFds[2] = { -1, -1 };
+    QThread *reader = nullptr;
+    QHash<int, QString> pathByWd;
+    QHash<QString, int> wdByPath;
+
+    // Fallback backend
+    QFileSystemWatcher *fallback = nullptr;
+};
+
+#endif // WATCHSERVICE_H
@@ -11,19 +11,26 @@
 #include <QHBoxLayout>
 #include <QStyle>
 #include <QShowEvent>
+#include <QResizeEvent>
+#include <QPaintEvent>
 #include <QDir>
 #include <QFontMetrics>
 #include <QFile>
 #include <QStringList>
-#include <QFileIconProvider>
 #include <QMenu>
 #include <QCloseEvent>
-#include <QJsonDocument>
-#include <QJsonObject>
-#include <QJsonArray>
-#include <QJsonValue>
+#include <QScreen>
 #include "features/fileops/fileops.h"
 #include "features/contextmenu/contextmenu.h"
+#include "features/delegate/itemdelegate.h"
+#include "features/delete/deletequeue.h"
+#include "features/dirscan/dirscan.h"
+#include "features/watch/watchservice.h"
+#include "features/layout/layoutstore.h"
+#include "features/theme/theme.h"
+#include "features/trace/tracer.h"
+#include "features/transfer/transferqueue.h"
+#include "features/trash/trash.h"
 
 #ifdef Q_OS_WIN
 #include <windows.h>
@@ -39,8 +46,11 @@ FloatingZone::FloatingZone(const QString &name, const QString &folderPath, QWidg
     , resizingBottom(false)
     , isGridMode(false)
     , isLocked(false)
-    , folderWatcher(nullptr)
+    , changeCoalescer(nullptr)
 {
+    TraceSpan span("FloatingZone::FloatingZone", "zone");
+    span.setDetail(folderPath);
+
     // Set window flags for a frameless window that stays behind other windows
     setWindowFlags(Qt::FramelessWindowHint | Qt::Tool | Qt::WindowStaysOnBottomHint);
     setAttribute(Qt::WA_TranslucentBackground, true);
@@ -52,10 +62,32 @@ FloatingZone::FloatingZone(const QString &name, const QString &folderPath, QWidg
 
     setupUI();
 
-    // Initialize file system watcher
-    folderWatcher = new QFileSystemWatcher(this);
-    connect(folderWatcher, &QFileSystemWatcher::directoryChanged,
-            this, &FloatingZone::onFolderContentChanged);
+    // Bursts of watcher events (archive extraction, builds) become one refresh
+    changeCoalescer = new ChangeCoalescer(this);
+    connect(changeCoalescer, &ChangeCoalescer::triggered,
+            this, &FloatingZone::onFolderChangesSettled);
+
+    // Items dropped into this folder are listed (dimmed) while they move
+    connect(TransferQueue::instance(), &TransferQueue::itemQueued,
+            this, &FloatingZone::onTransferQueued);
+    connect(TransferQueue::instance(), &TransferQueue::itemFinished,
+            this, &FloatingZone::onTransferFinished);
+    // Items being deleted are dimmed and dropped one by one as they go
+    connect(DeleteQueue::instance(), &DeleteQueue::itemQueued,
+            this, &FloatingZone::onDeleteQueued);
+    connect(DeleteQueue::instance(), &DeleteQueue::itemRemoved,
+            this, &FloatingZone::onDeleteFinished);
+    // Trashed items go at once; restored ones are looked up again
+    connect(Trash::instance(), &Trash::itemTrashed, this, [this](const QString &path) {
+        onDeleteFinished(path, true);
+    });
+    connect(Trash::instance(), &Trash::itemRestored, this, &FloatingZone::onItemRestored);
+
+    // Interactive move/resize is applied at most once per display frame
+    geometryTimer = new QTimer(this);
+    geometryTimer->setSingleShot(true);
+    geometryTimer->setTimerType(Qt::PreciseTimer);
+    connect(geometryTimer, &QTimer::timeout, this, &FloatingZone::applyPendingGeometry);
 
     // Set initial size aligned to grid
     QSize initialSize = snapSizeToGrid(QSize(200, 350));
@@ -84,13 +116,7 @@ void FloatingZone::setupUI()
 
     // Title bar with name only
     QWidget *titleBar = new QWidget(this);
-    titleBar->setStyleSheet(
-        "QWidget { "
-        "  background-color: rgba(0, 0, 0, 51); "
-        "  border: 1px solid rgba(255, 255, 255, 50); "
-        "  border-bottom: 1px solid rgba(255, 255, 255, 20); "  // Subtle separator
-        "}"
-    );
+    titleBar->setObjectName("zoneTitleBar");
     titleBar->setFixedHeight(30);
 
     QHBoxLayout *titleLayout = new QHBoxLayout(titleBar);
@@ -98,52 +124,13 @@ void FloatingZone::setupUI()
     titleLayout->setSpacing(5);
 
     titleLabel = new ClickableLabel(zoneName, titleBar);
-    titleLabel->setStyleSheet(
-        "color: white; "
-        "font-weight: bold; "
-        "font-size: 13px; "
-        "background: transparent; "
-        "border: none; "
-        "padding: 0px; "
-        "margin: 0px;"
-    );
+    titleLabel->setObjectName("zoneTitle");
     connect(titleLabel, &ClickableLabel::doubleClicked, this, &FloatingZone::onTitleDoubleClicked);
     titleLayout->addWidget(titleLabel, 1);
 
-    // Shared button style (matches close button style)
-    auto makeButtonStyle = [](const QString &hoverBg) {
-        return QString(
-            "QPushButton { "
-            "  background-color: transparent; "
-            "  color: rgba(255, 255, 255, 150); "
-            "  border: none; "
-            "  padding: 0px; "
-            "  font-size: 14px; "
-            "  font-weight: bold; "
-            "}"
-            "QPushButton:hover { "
-            "  background-color: %1; "
-            "  color: white; "
-            "}"
-        ).arg(hoverBg);
-    };
-
     // Close button
     closeButton = new QPushButton("×", titleBar);
-    closeButton->setStyleSheet(
-        "QPushButton { "
-        "  background-color: transparent; "
-        "  color: rgba(255, 255, 255, 150); "
-        "  border: none; "
-        "  padding: 0px; "
-        "  font-size: 18px; "
-        "  font-weight: bold; "
-        "}"
-        "QPushButton:hover { "
-        "  background-color: rgba(255, 100, 100, 180); "
-        "  color: white; "
-        "}"
-    );
+    closeButton->setObjectName("zoneClose");
     closeButton->setFixedSize(24, 22);
     closeButton->setToolTip("关闭区域");
     connect(closeButton, &QPushButton::clicked, this, &FloatingZone::close);
@@ -151,7 +138,7 @@ void FloatingZone::setupUI()
 
     // View mode toggle button
     viewModeButton = new QPushButton("▦", titleBar);
-    viewModeButton->setStyleSheet(makeButtonStyle("rgba(255, 255, 255, 80)"));
+    viewModeButton->setObjectName("zoneViewMode");
     viewModeButton->setFixedSize(24, 22);
     viewModeButton->setToolTip("切换视图模式");
     connect(viewModeButton, &QPushButton::clicked, this, &FloatingZone::toggleViewMode);
@@ -159,35 +146,16 @@ void FloatingZone::setupUI()
 
     // Lock button (rightmost)
     lockButton = new QPushButton("○", titleBar);
-    lockButton->setStyleSheet(makeButtonStyle("rgba(255, 200, 0, 100)"));
+    lockButton->setObjectName("zoneLock");
     lockButton->setFixedSize(24, 22);
     lockButton->setToolTip("锁定区域");
-    connect(lockButton, &QPushButton::clicked, this, [this, makeButtonStyle]() {
+    connect(lockButton, &QPushButton::clicked, this, [this]() {
         isLocked = !isLocked;
         closeButton->setVisible(!isLocked);
         viewModeButton->setVisible(!isLocked);
-        if (isLocked) {
-            lockButton->setText("●");
-            lockButton->setToolTip("解锁区域");
-            lockButton->setStyleSheet(
-                "QPushButton { "
-                "  background-color: rgba(255, 200, 0, 60); "
-                "  color: rgba(255, 200, 0, 220); "
-                "  border: none; "
-                "  padding: 0px; "
-                "  font-size: 14px; "
-                "  font-weight: bold; "
-                "}"
-                "QPushButton:hover { "
-                "  background-color: rgba(255, 200, 0, 100); "
-                "  color: white; "
-                "}"
-            );
-        } else {
-            lockButton->setText("○");
-            lockButton->setToolTip("锁定区域");
-            lockButton->setStyleSheet(makeButtonStyle("rgba(255, 200, 0, 100)"));
-        }
+        lockButton->setText(isLocked ? "●" : "○");
+        lockButton->setToolTip(isLocked ? "解锁区域" : "锁定区域");
+        Theme::setState(lockButton, "locked", isLocked);
         fileList->setAcceptDrops(!isLocked);
         fileList->setDragEnabled(!isLocked);
         setAcceptDrops(!isLocked);
@@ -197,85 +165,30 @@ void FloatingZone::setupUI()
     mainLayout->addWidget(titleBar);
 
     // File list in list view with drag support
-    fileList = new DraggableListWidget(this);
-    fileList->setViewMode(QListWidget::ListMode);
+    fileModel = new ZoneFileModel(this);
+    fileModel->setIconSize(24);
+    fileList = new DraggableListView(this);
+    fileList->setObjectName("zoneList");
+    fileList->setModel(fileModel);
+    fileList->setViewMode(QListView::ListMode);
     fileList->setIconSize(QSize(24, 24));
     fileList->setGridSize(QSize());
-    fileList->setResizeMode(QListWidget::Adjust);
-    fileList->setMovement(QListWidget::Static);
+    fileList->setResizeMode(QListView::Adjust);
+    fileList->setMovement(QListView::Static);
     fileList->setWrapping(false);
     fileList->setSpacing(2);
-    fileList->setStyleSheet(
-        "QListWidget { "
-        "  background-color: rgba(0, 0, 0, 51); "
-        "  border: 1px solid rgba(255, 255, 255, 50); "
-        "  border-top: none; "
-        "  padding: 5px; "
-        "}"
-        "QListWidget::item { "
-        "  background-color: transparent; "
-        "  color: white; "
-        "  padding: 3px;"
-        "}"
-        "QListWidget::item:selected { "
-        "  background-color: rgba(255, 255, 255, 80); "
-        "  color: white; "
-        "}"
-        "QListWidget::item:hover { "
-        "  background-color: rgba(255, 255, 255, 40); "
-        "}"
-        // Scrollbar styling
-        "QScrollBar:vertical { "
-        "  background: rgba(0, 0, 0, 30); "
-        "  width: 10px; "
-        "  border: none; "
-        "  margin: 0px; "
-        "}"
-        "QScrollBar::handle:vertical { "
-        "  background: rgba(255, 255, 255, 100); "
-        "  min-height: 20px; "
-        "  border-radius: 5px; "
-        "}"
-        "QScrollBar::handle:vertical:hover { "
-        "  background: rgba(255, 255, 255, 150); "
-        "}"
-        "QScrollBar::handle:vertical:pressed { "
-        "  background: rgba(255, 255, 255, 200); "
-        "}"
-        "QScrollBar::add-line:vertical, QScrollBar::sub-line:vertical { "
-        "  height: 0px; "
-        "}"
-        "QScrollBar::add-page:vertical, QScrollBar::sub-page:vertical { "
-        "  background: none; "
-        "}"
-        // Horizontal scrollbar
-        "QScrollBar:horizontal { "
-        "  background: rgba(0, 0, 0, 30); "
-        "  height: 10px; "
-        "  border: none; "
-        "  margin: 0px; "
-        "}"
-        "QScrollBar::handle:horizontal { "
-        "  background: rgba(255, 255, 255, 100); "
-        "  min-width: 20px; "
-        "  border-radius: 5px; "
-        "}"
-        "QScrollBar::handle:horizontal:hover { "
-        "  background: rgba(255, 255, 255, 150); "
-        "}"
-        "QScrollBar::handle:horizontal:pressed { "
-        "  background: rgba(255, 255, 255, 200); "
-        "}"
-        "QScrollBar::add-line:horizontal, QScrollBar::sub-line:horizontal { "
-        "  width: 0px; "
-        "}"
-        "QScrollBar::add-page:horizontal, QScrollBar::sub-page:horizontal { "
-        "  background: none; "
-        "}"
-    );
+    // Large folders: every row has the same size and layout is done in
+    // batches, so the view never measures all rows up front
+    fileList->setUniformItemSizes(true);
+    fileList->setLayoutMode(QListView::Batched);
+    fileList->setBatchSize(256);
+    // Rows are painted directly rather than through QListView::item rules
+    fileList->setItemDelegate(new ZoneItemDelegate(fileList));
+    fileList->viewport()->setAttribute(Qt::WA_Hover, true);
     fileList->setContextMenuPolicy(Qt::CustomContextMenu);
-    fileList->setWordWrap(true);
-    connect(fileList, &QListWidget::customContextMenuRequested, this, &FloatingZone::showContextMenu);
+    // Uniform rows in list mode: long names are elided instead of wrapped
+    fileList->setWordWrap(false);
+    connect(fileList, &QListView::customContextMenuRequested, this, &FloatingZone::showContextMenu);
 
     // Enable drag from list
     fileList->setDragEnabled(true);
@@ -283,12 +196,13 @@ void FloatingZone::setupUI()
     fileList->setDragDropMode(QAbstractItemView::DragDrop);
     fileList->setDefaultDropAction(Qt::MoveAction);
 
-    connect(fileList, &QListWidget::itemDoubleClicked, this, &FloatingZone::onItemDoubleClicked);
-    connect(fileList, &QListWidget::itemSelectionChanged, this, &FloatingZone::onSelectionChanged);
+    connect(fileList, &QListView::doubleClicked, this, &FloatingZone::onItemDoubleClicked);
+    connect(fileList->selectionModel(), &QItemSelectionModel::selectionChanged,
+            this, &FloatingZone::onSelectionChanged);
     mainLayout->addWidget(fileList);
 
-    // No background for main widget (transparent)
-    setStyleSheet("FloatingZone { background-color: transparent; }");
+    // Colors, fonts and the locked state come from the application
+    // stylesheet (features/theme), matched on the object names above
 }
 
 void FloatingZone::setName(const QString &name)
@@ -359,9 +273,13 @@ void FloatingZone::mousePressEvent(QMouseEvent *event)
             resizingBottom = onBottomEdge;
             resizeStartPos = event->globalPos();
             resizeStartSize = size();
+            pendingSize = size();
+            // Items are laid out again once, on release
+            fileList->setResizeMode(QListView::Fixed);
         } else if (pos.y() < 40) {  // Title bar area
             dragging = true;
             dragPosition = event->globalPos() - frameGeometry().topLeft();
+            pendingPos = pos();
         }
 
 #ifdef Q_OS_WIN
@@ -377,15 +295,11 @@ void FloatingZone::mousePressEvent(QMouseEvent *event)
 
 void FloatingZone::mouseMoveEvent(QMouseEvent *event)
 {
+    // Mice can report far more often than the display refreshes: only the
+    // latest target is kept and applied on the next frame
     if (dragging) {
-        move(event->globalPos() - dragPosition);
-
-#ifdef Q_OS_WIN
-        // Keep window at bottom while dragging
-        HWND hwnd = (HWND)winId();
-        SetWindowPos(hwnd, HWND_BOTTOM, 0, 0, 0, 0,
-                     SWP_NOMOVE | SWP_NOSIZE | SWP_NOACTIVATE);
-#endif
+        pendingPos = event->globalPos() - dragPosition;
+        scheduleGeometry();
         event->accept();
     } else if (resizing) {
         QPoint delta = event->globalPos() - resizeStartPos;
@@ -401,15 +315,8 @@ void FloatingZone::mouseMoveEvent(QMouseEvent *event)
         }
 
         // Apply grid snapping during resize for real-time feedback
-        QSize snappedSize = snapSizeToGrid(QSize(newWidth, newHeight));
-        resize(snappedSize);
-
-#ifdef Q_OS_WIN
-        // Keep window at bottom while resizing
-        HWND hwnd = (HWND)winId();
-        SetWindowPos(hwnd, HWND_BOTTOM, 0, 0, 0, 0,
-                     SWP_NOMOVE | SWP_NOSIZE | SWP_NOACTIVATE);
-#endif
+        pendingSize = snapSizeToGrid(QSize(newWidth, newHeight));
+        scheduleGeometry();
         event->accept();
     } else {
         // Change cursor when hovering over resize areas
@@ -435,6 +342,12 @@ void FloatingZone::mouseReleaseEvent(QMouseEvent *event)
         bool wasMoving = dragging;
         bool wasResizing = resizing;
 
+        // Catch up with the last mouse position before snapping
+        if (geometryTimer->isActive()) {
+            geometryTimer->stop();
+            applyPendingGeometry();
+        }
+
         // Snap to grid when releasing
         if (dragging) {
             QPoint snappedPos = snapToGrid(pos());
@@ -444,6 +357,8 @@ void FloatingZone::mouseReleaseEvent(QMouseEvent *event)
         if (resizing) {
             QSize snappedSize = snapSizeToGrid(size());
             resize(snappedSize);
+            fileList->setResizeMode(QListView::Adjust);
+            fileList->doItemsLayout();
         }
 
         dragging = false;
@@ -481,20 +396,70 @@ void FloatingZone::dropEvent(QDropEvent *event)
 
 void FloatingZone::paintEvent(QPaintEvent *event)
 {
-    QWidget::paintEvent(event);
+    // Copy only the damaged part of the cached chrome. A hovered or updated
+    // row repaints its own rect in the list, and this just fills in the
+    // translucent background underneath it.
+    const QPixmap &chrome = chromePixmap();
+    const qreal dpr = chrome.devicePixelRatio();
+    const QRect target = event->rect();
+    const QRectF source(target.x() * dpr, target.y() * dpr, target.width() * dpr, target.height() * dpr);
 
-    // Draw subtle resize indicator in the bottom-right corner
     QPainter painter(this);
-    painter.setRenderHint(QPainter::Antialiasing);
+    painter.drawPixmap(QRectF(target), chrome, source);
+}
 
-    int x = width() - 8;
-    int y = height() - 8;
-    painter.setPen(QPen(QColor(255, 255, 255, 150), 2));
+void FloatingZone::resizeEvent(QResizeEvent *event)
+{
+    QWidget::resizeEvent(event);
+    chromeCache = QPixmap();
+}
 
-    // Draw three lines to indicate resize area
+const QPixmap &FloatingZone::chromePixmap()
+{
+    // Child geometry is checked too: it settles after the resize event
+    const QWidget *titleBar = titleLabel->parentWidget();
+    const qreal dpr = devicePixelRatioF();
+    if (!chromeCache.isNull() && qFuzzyCompare(chromeCache.devicePixelRatio(), dpr)
+        && chromeTitleRect == titleBar->geometry() && chromeListRect == fileList->geometry()) {
+        return chromeCache;
+    }
+
+    chromeTitleRect = titleBar->geometry();
+    chromeListRect = fileList->geometry();
+    chromeCache = QPixmap(size() * dpr);
+    chromeCache.setDevicePixelRatio(dpr);
+    chromeCache.fill(Qt::transparent);
+
+    QPainter painter(&chromeCache);
+    const QColor panel(0, 0, 0, 51);
+    const QColor border(255, 255, 255, 50);
+    const QColor separator(255, 255, 255, 20);
+
+    // Title bar: bordered panel with a subtle separator at the bottom
+    const QRect title = chromeTitleRect;
+    painter.fillRect(title, panel);
+    painter.fillRect(QRect(title.left(), title.top(), title.width(), 1), border);
+    painter.fillRect(QRect(title.left(), title.top() + 1, 1, title.height() - 2), border);
+    painter.fillRect(QRect(title.right(), title.top() + 1, 1, title.height() - 2), border);
+    painter.fillRect(QRect(title.left(), title.bottom(), title.width(), 1), separator);
+
+    // File list: same panel, open at the top
+    const QRect list = chromeListRect;
+    painter.fillRect(list, panel);
+    painter.fillRect(QRect(list.left(), list.top(), 1, list.height() - 1), border);
+    painter.fillRect(QRect(list.right(), list.top(), 1, list.height() - 1), border);
+    painter.fillRect(QRect(list.left(), list.bottom(), list.width(), 1), border);
+
+    // Subtle resize indicator in the bottom-right corner
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setPen(QPen(QColor(255, 255, 255, 150), 2));
+    const int x = width() - 8;
+    const int y = height() - 8;
     for (int i = 0; i < 3; ++i) {
         painter.drawLine(x - i * 4, y, x, y - i * 4);
     }
+
+    return chromeCache;
 }
 
 QRect FloatingZone::getResizeRect() const
@@ -508,9 +473,9 @@ bool FloatingZone::isInResizeArea(const QPoint &pos) const
     return pos.x() >= width() - RESIZE_MARGIN && pos.y() >= height() - RESIZE_MARGIN;
 }
 
-void FloatingZone::onItemDoubleClicked(QListWidgetItem *item)
+void FloatingZone::onItemDoubleClicked(const QModelIndex &index)
 {
-    QString filePath = item->data(Qt::UserRole).toString();
+    QString filePath = fileModel->filePath(index);
 
     // Open the file or folder with the default system application
     if (!QDesktopServices::openUrl(QUrl::fromLocalFile(filePath))) {
@@ -523,6 +488,9 @@ void FloatingZone::showEvent(QShowEvent *event)
 {
     QWidget::showEvent(event);
 
+    // Icons are rendered for the screen the zone lives on
+    fileModel->setDevicePixelRatio(devicePixelRatioF());
+
 #ifdef Q_OS_WIN
     // Set window to desktop level on Windows
     HWND hwnd = (HWND)winId();
@@ -563,6 +531,8 @@ void FloatingZone::setFolderPath(const QString &path)
 
 void FloatingZone::loadFilesFromFolder()
 {
+    TraceSpan span("FloatingZone::loadFilesFromFolder", "zone");
+
     if (folderPath.isEmpty()) {
         return;
     }
@@ -573,9 +543,7 @@ void FloatingZone::loadFilesFromFolder()
     }
 
     // Setup folder watching
-    if (folderWatcher && !folderWatcher->directories().contains(folderPath)) {
-        folderWatcher->addPath(folderPath);
-    }
+    watchFolder();
 
     refreshFileList();
     updateTitle();  // Update width after loading files
@@ -587,60 +555,87 @@ void FloatingZone::refreshFileList()
         return;
     }
 
-    // Clear existing items
-    fileList->clear();
+    // List the folder on the scanner pool; a newer refresh cancels this one.
+    // On first load rows are shown batch by batch as they are read, later
+    // refreshes are diffed against the current rows once the listing is complete.
+    TraceSpan span("FloatingZone::refreshFileList", "zone");
+    span.setDetail(folderPath);
 
-    QDir dir(folderPath);
-    if (!dir.exists()) {
-        return;
-    }
+    const bool initialLoad = fileModel->isEmpty();
+    const qint64 requestedNs = span.isActive() ? Tracer::now() : -1;
 
-    // Use QFileIconProvider for real system icons (supports .lnk, file types, etc.)
-    QFileIconProvider iconProvider;
-
-    // Get all files and subdirectories
-    QFileInfoList entries = dir.entryInfoList(QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot,
-                                              QDir::Name | QDir::DirsFirst);
+    DirScanner::instance()->scan(this, folderPath, DirScanner::FilesAndDirs,
+        [this, initialLoad](const QVector<FileEntry> &batch) {
+            if (initialLoad) {
+                fileModel->appendEntries(batch);
+            }
+        },
+        [this, requestedNs](const QVector<FileEntry> &entries, bool ok) {
+            if (requestedNs >= 0) {
+                // Request to listing on screen, including time queued on the pool
+                Tracer::recordAsync("FloatingZone::refreshFileList (listing)", "zone",
+                                    requestedNs, Tracer::now(), folderPath);
+            }
+            if (!ok) {
+                fileModel->clear();
+                return;
+            }
+            // Unchanged rows keep their icon and selection
+            fileModel->setEntries(entries);
 
-    for (const QFileInfo &fileInfo : entries) {
-        QListWidgetItem *item = new QListWidgetItem(fileInfo.fileName());
-        item->setData(Qt::UserRole, fileInfo.absoluteFilePath());
-        item->setToolTip(fileInfo.absoluteFilePath());
+            // Changes that arrived while listing
+            flushPendingChanges();
+        });
+}
 
-        // Set real system icon for this file/folder/shortcut
-        item->setIcon(iconProvider.icon(fileInfo));
+void FloatingZone::watchFolder()
+{
+    WatchService *watcher = WatchService::instance();
+    watcher->unsubscribeAll(this);
+    pendingNames.clear();
+    rescanPending = false;
 
-        fileList->addItem(item);
+    if (!folderPath.isEmpty()) {
+        watcher->subscribe(this, folderPath, [this](const QVector<WatchEvent> &events) {
+            onFolderEvents(events);
+        });
     }
 }
 
 void FloatingZone::toggleViewMode()
 {
     isGridMode = !isGridMode;
+    applyViewMode();
 
+    // Update window width based on new view mode
+    updateTitle();
+}
+
+void FloatingZone::applyViewMode()
+{
+    // Presentation only: the listing in fileModel stays as it is, and rows
+    // ask IconService for icons at the new size (served from its cache)
     if (isGridMode) {
-        // Switch to grid/icon mode
-        fileList->setViewMode(QListWidget::IconMode);
+        // Grid/icon mode
+        fileList->setViewMode(QListView::IconMode);
+        fileModel->setIconSize(48);
         fileList->setIconSize(QSize(48, 48));
         fileList->setGridSize(QSize(80, 90));
         fileList->setWrapping(true);
         fileList->setSpacing(5);
+        fileList->setWordWrap(true);
         viewModeButton->setText("≡");
     } else {
-        // Switch to list mode
-        fileList->setViewMode(QListWidget::ListMode);
+        // List mode
+        fileList->setViewMode(QListView::ListMode);
+        fileModel->setIconSize(24);
         fileList->setIconSize(QSize(24, 24));
         fileList->setGridSize(QSize());
         fileList->setWrapping(false);
         fileList->setSpacing(2);
+        fileList->setWordWrap(false);
         viewModeButton->setText("▦");
     }
-
-    // Refresh the file list to apply new view mode
-    refreshFileList();
-
-    // Update window width based on new view mode
-    updateTitle();
 }
 
 void FloatingZone::showContextMenu(const QPoint &pos)
@@ -653,18 +648,7 @@ void FloatingZone::showContextMenu(const QPoint &pos)
         this,
         [this]() { refreshFileList(); },
         [this](const QString &newFolderPath) {
-            // Update folder watcher: remove old path, add new path
-            if (folderWatcher && !folderPath.isEmpty()) {
-                folderWatcher->removePath(folderPath);
-            }
-            folderPath = newFolderPath;
-            zoneName = QFileInfo(newFolderPath).fileName();
-            if (folderWatcher) {
-                folderWatcher->addPath(folderPath);
-            }
-            updateTitle();
-            refreshFileList();
-            saveLayout();
+            onFolderRenamed(newFolderPath);
         }
     );
 }
@@ -678,22 +662,56 @@ void FloatingZone::onTitleDoubleClicked()
 
     FileOpsHandler::renameFolder(folderPath, zoneName, this,
         [this](const QString &newFolderPath) {
-            // Update folder watcher: remove old path, add new path
-            if (folderWatcher && !folderPath.isEmpty()) {
-                folderWatcher->removePath(folderPath);
-            }
-            folderPath = newFolderPath;
-            zoneName = QFileInfo(newFolderPath).fileName();
-            if (folderWatcher) {
-                folderWatcher->addPath(folderPath);
-            }
-            updateTitle();
-            refreshFileList();
-            saveLayout();
+            onFolderRenamed(newFolderPath);
         }
     );
 }
 
+void FloatingZone::onFolderRenamed(const QString &newFolderPath)
+{
+    // Move the folder watch over to the new path
+    folderPath = newFolderPath;
+    zoneName = QFileInfo(newFolderPath).fileName();
+    watchFolder();
+    updateTitle();
+    refreshFileList();
+    saveLayout();
+}
+
+void FloatingZone::scheduleGeometry()
+{
+    if (geometryTimer->isActive()) {
+        return;
+    }
+
+    const QScreen *currentScreen = screen();
+    const qreal refreshRate = currentScreen ? currentScreen->refreshRate() : 60.0;
+    geometryTimer->start(qMax(1, int(1000.0 / qMax(refreshRate, 1.0))));
+}
+
+void FloatingZone::applyPendingGeometry()
+{
+    bool changed = false;
+    if (dragging && pendingPos != pos()) {
+        move(pendingPos);
+        changed = true;
+    } else if (resizing && pendingSize != size()) {
+        resize(pendingSize);
+        changed = true;
+    }
+
+#ifdef Q_OS_WIN
+    // Keep window at bottom while dragging/resizing
+    if (changed) {
+        HWND hwnd = (HWND)winId();
+        SetWindowPos(hwnd, HWND_BOTTOM, 0, 0, 0, 0,
+                     SWP_NOMOVE | SWP_NOSIZE | SWP_NOACTIVATE);
+    }
+#else
+    Q_UNUSED(changed);
+#endif
+}
+
 QPoint FloatingZone::snapToGrid(const QPoint &pos) const
 {
     int x = qRound(pos.x() / (double)GRID_SIZE) * GRID_SIZE;
@@ -715,160 +733,187 @@ void FloatingZone::saveLayout()
         return;
     }
 
-    // Layout file path: d:\boox\.layout.json
-    QString layoutFilePath = "d:/boox/.layout.json";
+    // Written to disk later by the store, together with other zones
+    ZoneLayout layout;
+    layout.geometry = QRect(pos(), size());
+    layout.hasViewMode = true;
+    layout.gridMode = isGridMode;
+    LayoutStore::instance()->store(folderPath, layout);
+}
 
-    // Read existing layout data
-    QJsonObject layoutData;
-    QFile layoutFile(layoutFilePath);
-    if (layoutFile.exists()) {
-        if (layoutFile.open(QIODevice::ReadOnly)) {
-            QByteArray data = layoutFile.readAll();
-            layoutFile.close();
-            QJsonDocument doc = QJsonDocument::fromJson(data);
-            if (doc.isObject()) {
-                layoutData = doc.object();
-            }
-        }
+void FloatingZone::loadLayout()
+{
+    TraceSpan span("FloatingZone::loadLayout", "zone");
+
+    // Only load layout if this zone is linked to a folder
+    if (folderPath.isEmpty()) {
+        return;
     }
 
-    // Create zone data
-    QJsonObject zoneData;
-    zoneData["x"] = pos().x();
-    zoneData["y"] = pos().y();
-    zoneData["width"] = width();
-    zoneData["height"] = height();
-    zoneData["viewMode"] = isGridMode ? "grid" : "list";
+    // Check if we have saved geometry for this zone
+    ZoneLayout layout;
+    if (!LayoutStore::instance()->lookup(folderPath, layout)) {
+        return;
+    }
 
-    // Use folder path as key
-    layoutData[folderPath] = zoneData;
+    // Restore position and size
+    if (layout.geometry.isValid()) {
+        move(layout.geometry.topLeft());
+        resize(layout.geometry.size());
+    }
 
-    // Write back to file
-    if (layoutFile.open(QIODevice::WriteOnly)) {
-        QJsonDocument doc(layoutData);
-        layoutFile.write(doc.toJson(QJsonDocument::Indented));
-        layoutFile.close();
+    // Restore view mode if saved; only switch if different from current mode
+    if (layout.hasViewMode && layout.gridMode != isGridMode) {
+        isGridMode = layout.gridMode;
+        applyViewMode();
     }
 }
 
-void FloatingZone::loadLayout()
+bool FloatingZone::hasStoredLayout() const
 {
-    // Only load layout if this zone is linked to a folder
+    // Only check if this zone is linked to a folder
     if (folderPath.isEmpty()) {
-        return;
+        return false;
     }
 
-    // Layout file path: d:\boox\.layout.json
-    QString layoutFilePath = "d:/boox/.layout.json";
+    return LayoutStore::instance()->contains(folderPath);
+}
 
-    QFile layoutFile(layoutFilePath);
-    if (!layoutFile.exists()) {
-        return;
+void FloatingZone::onFolderEvents(const QVector<WatchEvent> &events)
+{
+    TraceSpan span("FloatingZone::onFolderEvents", "zone");
+
+    // Collect which entries changed; they are looked up again once the burst
+    // settles. Without details (or with too many) the folder is relisted.
+    for (const WatchEvent &event : events) {
+        if (event.kind == WatchEvent::Rescan || event.kind == WatchEvent::FolderGone) {
+            rescanPending = true;
+        } else if (!rescanPending) {
+            pendingNames.insert(event.name);
+        }
+        changeCoalescer->notify();
     }
 
-    if (!layoutFile.open(QIODevice::ReadOnly)) {
-        return;
+    if (rescanPending || pendingNames.size() > MAX_DELTA_NAMES) {
+        rescanPending = true;
+        pendingNames.clear();
     }
+}
 
-    QByteArray data = layoutFile.readAll();
-    layoutFile.close();
-
-    QJsonDocument doc = QJsonDocument::fromJson(data);
-    if (!doc.isObject()) {
-        return;
+void FloatingZone::onFolderChangesSettled()
+{
+    // A listing or lookup still running will flush when it completes
+    if (!DirScanner::instance()->isBusy(this)) {
+        flushPendingChanges();
     }
 
-    QJsonObject layoutData = doc.object();
+    // Update window width if needed based on new content
+    updateTitle();
+}
 
-    // Check if we have saved geometry for this zone
-    if (!layoutData.contains(folderPath)) {
+void FloatingZone::flushPendingChanges()
+{
+    TraceSpan span("FloatingZone::flushPendingChanges", "zone");
+
+    if (rescanPending) {
+        // Refresh the file list to show new/removed files
+        rescanPending = false;
+        pendingNames.clear();
+        refreshFileList();
         return;
     }
 
-    QJsonValue zoneValue = layoutData[folderPath];
-    if (!zoneValue.isObject()) {
+    if (pendingNames.isEmpty()) {
         return;
     }
 
-    QJsonObject zoneData = zoneValue.toObject();
+    // Look up just the changed entries and patch the model in place
+    const QStringList names = pendingNames.values();
+    pendingNames.clear();
 
-    // Restore position and size
-    if (zoneData.contains("x") && zoneData.contains("y") &&
-        zoneData.contains("width") && zoneData.contains("height")) {
-        int x = zoneData["x"].toInt();
-        int y = zoneData["y"].toInt();
-        int w = zoneData["width"].toInt();
-        int h = zoneData["height"].toInt();
+    DirScanner::instance()->stat(this, folderPath, names,
+        [this](const QVector<FileEntry> &present, const QStringList &missing) {
+            if (!fileModel->applyDelta(present, missing)) {
+                rescanPending = true;
+            }
+            flushPendingChanges();
+        });
+}
 
-        move(x, y);
-        resize(w, h);
-    }
+bool FloatingZone::isInFolder(const QFileInfo &info) const
+{
+    return !folderPath.isEmpty() && info.absolutePath() == QFileInfo(folderPath).absoluteFilePath();
+}
 
-    // Restore view mode if saved
-    if (zoneData.contains("viewMode")) {
-        QString viewMode = zoneData["viewMode"].toString();
-        bool savedIsGridMode = (viewMode == "grid");
+void FloatingZone::markPending(const QFileInfo &info, bool isDir)
+{
+    FileEntry entry;
+    entry.name = info.fileName();
+    entry.path = info.absoluteFilePath();
+    entry.isDir = isDir;
+    fileModel->setPending(entry);
+}
 
-        // Only toggle if different from current mode
-        if (savedIsGridMode != isGridMode) {
-            toggleViewMode();
-        }
+void FloatingZone::onTransferQueued(const QString &targetPath, bool isDir)
+{
+    const QFileInfo target(targetPath);
+    if (isInFolder(target)) {
+        markPending(target, isDir);
     }
 }
 
-bool FloatingZone::hasStoredLayout() const
+void FloatingZone::onTransferFinished(const QString &targetPath, bool ok)
 {
-    // Only check if this zone is linked to a folder
-    if (folderPath.isEmpty()) {
-        return false;
+    Q_UNUSED(ok);
+    const QFileInfo target(targetPath);
+    if (!isInFolder(target)) {
+        return;
     }
 
-    // Layout file path: d:\boox\.layout.json
-    QString layoutFilePath = "d:/boox/.layout.json";
+    // Look the item up like a watcher change: it is now either there or gone
+    fileModel->clearPending(target.absoluteFilePath());
+    pendingNames.insert(target.fileName());
+    changeCoalescer->notify();
+}
 
-    QFile layoutFile(layoutFilePath);
-    if (!layoutFile.exists()) {
-        return false;
+void FloatingZone::onDeleteQueued(const QString &path, bool isDir)
+{
+    const QFileInfo info(path);
+    if (isInFolder(info)) {
+        markPending(info, isDir);
     }
+}
 
-    if (!layoutFile.open(QIODevice::ReadOnly)) {
-        return false;
+void FloatingZone::onDeleteFinished(const QString &path, bool ok)
+{
+    const QFileInfo info(path);
+    if (!isInFolder(info)) {
+        return;
     }
 
-    QByteArray data = layoutFile.readAll();
-    layoutFile.close();
-
-    QJsonDocument doc = QJsonDocument::fromJson(data);
-    if (!doc.isObject()) {
-        return false;
+    fileModel->clearPending(info.absoluteFilePath());
+    // Gone: drop the row now. A partly deleted folder is looked up again.
+    if (ok && fileModel->applyDelta(QVector<FileEntry>(), QStringList{ info.fileName() })) {
+        return;
     }
-
-    QJsonObject layoutData = doc.object();
-
-    // Check if we have saved geometry for this zone
-    return layoutData.contains(folderPath);
+    pendingNames.insert(info.fileName());
+    changeCoalescer->notify();
 }
 
-void FloatingZone::onFolderContentChanged(const QString &path)
+void FloatingZone::onItemRestored(const QString &path)
 {
-    Q_UNUSED(path);
-
-    // Re-add the path to watcher in case it was removed (happens on some filesystems)
-    if (folderWatcher && !folderWatcher->directories().contains(folderPath)) {
-        folderWatcher->addPath(folderPath);
+    const QFileInfo info(path);
+    if (!isInFolder(info)) {
+        return;
     }
 
-    // Refresh the file list to show new/removed files
-    refreshFileList();
-
-    // Update window width if needed based on new content
-    updateTitle();
+    pendingNames.insert(info.fileName());
+    changeCoalescer->notify();
 }
 
 void FloatingZone::onSelectionChanged()
 {
-    QListWidgetItem* item = fileList->currentItem();
-    QString selectedPath = item ? item->data(Qt::UserRole).toString() : QString();
+    QString selectedPath = fileModel->filePath(fileList->currentIndex());
     emit selectionChanged(this, selectedPath);
 }
 
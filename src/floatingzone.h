@@ -3,13 +3,17 @@
 
 #include <QWidget>
 #include <QLabel>
-#include <QListWidget>
+#include <QListView>
 #include <QVBoxLayout>
+#include <QPixmap>
 #include <QPoint>
 #include <QPushButton>
 #include <QTimer>
-#include <QFileSystemWatcher>
+#include <QSet>
 #include "features/dragdrop/dragdrop.h"
+#include "features/filemodel/filemodel.h"
+#include "features/coalescer/coalescer.h"
+#include "features/watch/watchservice.h"
 #include "features/contextmenu/contextmenu.h"
 #include "features/fileops/fileops.h"
 
@@ -45,6 +49,8 @@ public:
 
     QString getFolderPath() const { return folderPath; }
     void setFolderPath(const QString &path);
+    // The folder was renamed: follow it and take on its new name
+    void onFolderRenamed(const QString &newFolderPath);
 
     void loadFilesFromFolder();
     void saveLayout();
@@ -52,10 +58,14 @@ public:
     bool hasStoredLayout() const;
     
     // For dragdrop feature
-    DraggableListWidget* getFileList() const { return fileList; }
+    DraggableListView* getFileList() const { return fileList; }
+    ZoneFileModel* getFileModel() const { return fileModel; }
     void refreshFileList();
     void clearFileSelection();
 
+    // Watcher events vs. refreshes actually run for this zone
+    const ChangeCoalescer* getChangeCoalescer() const { return changeCoalescer; }
+
 signals:
     void zoneClosed(FloatingZone* zone);
     void layoutChanged();
@@ -73,6 +83,7 @@ protected:
 
     // For resizing
     void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
 
     // For setting window to desktop level
     void showEvent(QShowEvent *event) override;
@@ -81,29 +92,49 @@ protected:
     void closeEvent(QCloseEvent *event) override;
 
 private slots:
-    void onItemDoubleClicked(QListWidgetItem *item);
+    void onItemDoubleClicked(const QModelIndex &index);
     void toggleViewMode();
     void showContextMenu(const QPoint &pos);
     void onTitleDoubleClicked();
-    void onFolderContentChanged(const QString &path);
+    void onFolderChangesSettled();
     void onSelectionChanged();
+    void onTransferQueued(const QString &targetPath, bool isDir);
+    void onTransferFinished(const QString &targetPath, bool ok);
+    void onDeleteQueued(const QString &path, bool isDir);
+    void onDeleteFinished(const QString &path, bool ok);
+    void onItemRestored(const QString &path);
 
 private:
     void setupUI();
+    void applyViewMode();
+    void watchFolder();
+    void onFolderEvents(const QVector<WatchEvent> &events);
+    void flushPendingChanges();
+    bool isInFolder(const QFileInfo &info) const;
+    void markPending(const QFileInfo &info, bool isDir);
     void updateTitle();
     QRect getResizeRect() const;
+    void scheduleGeometry();
+    void applyPendingGeometry();
+    const QPixmap &chromePixmap();
     bool isInResizeArea(const QPoint &pos) const;
 
     QString zoneName;
     QString folderPath;
     ClickableLabel *titleLabel;
-    DraggableListWidget *fileList;
+    DraggableListView *fileList;
+    ZoneFileModel *fileModel;
     QPushButton *viewModeButton;
     QPushButton *closeButton;
     QPushButton *lockButton;
     bool isGridMode;
     bool isLocked;
-    QFileSystemWatcher *folderWatcher;
+    ChangeCoalescer *changeCoalescer;
+
+    // Watcher deltas not yet applied: changed entry names, or a full relist
+    QSet<QString> pendingNames;
+    bool rescanPending = false;
+    static constexpr int MAX_DELTA_NAMES = 1000;
 
     // For window dragging
     bool dragging;
@@ -116,6 +147,16 @@ private:
     QPoint resizeStartPos;
     QSize resizeStartSize;
 
+    // Latest move/resize target, applied once per display frame
+    QTimer *geometryTimer = nullptr;
+    QPoint pendingPos;
+    QSize pendingSize;
+
+    // Panels, borders and resize grip, rendered once per size and DPR
+    QPixmap chromeCache;
+    QRect chromeTitleRect;
+    QRect chromeListRect;
+
     static constexpr int RESIZE_MARGIN = 20;  // Increased for easier resizing
     static constexpr int MIN_WIDTH = 200;
     static constexpr int MIN_HEIGHT = 150;
@@ -1,14 +1,35 @@
 #include "mainwindow.h"
 #include <QApplication>
+#include "features/theme/theme.h"
+#include "features/trace/tracer.h"
 
 int main(int argc, char *argv[])
 {
-    QApplication a(argc, argv);
-    a.setApplicationName("Boox");
-    a.setOrganizationName("Boox");
+    // BOOX_TRACE=<file> or --trace[=<file>] records a startup/refresh trace
+    Tracer::configure(argc, argv);
 
-    MainWindow w;
-    // MainWindow is hidden - only tray icon is visible
+    int result = 0;
+    {
+        QApplication a(argc, argv);
+        a.setApplicationName("Boox");
+        a.setOrganizationName("Boox");
+        Theme::install(a);
 
-    return a.exec();
+        // --root=<folder> (or BOOX_ROOT) replaces the default d:/boox
+        QString rootPath = MainWindow::defaultRootPath();
+        for (const QString &arg : a.arguments()) {
+            if (arg.startsWith(QLatin1String("--root="))) {
+                rootPath = arg.mid(7);
+            }
+        }
+
+        MainWindow w(rootPath);
+        // MainWindow is hidden - only tray icon is visible
+
+        result = a.exec();
+    }
+
+    // Written after the zones and worker pools are gone
+    Tracer::write();
+    return result;
 }
@@ -5,37 +5,66 @@
 #include <QFileInfo>
 #include <QStandardPaths>
 #include <QGuiApplication>
+#include <QLocale>
 #include <QScreen>
-
-MainWindow::MainWindow(QWidget *parent)
+#include <QTimer>
+#include <algorithm>
+#include "features/delete/deletequeue.h"
+#include "features/dirscan/dirscan.h"
+#include "features/fileops/fileops.h"
+#include "features/icons/iconservice.h"
+#include "features/watch/watchservice.h"
+#include "features/layout/layoutstore.h"
+#include "features/trace/tracer.h"
+#include "features/transfer/transferqueue.h"
+#include "features/trash/trash.h"
+
+MainWindow::MainWindow(const QString &rootPath, QWidget *parent)
     : QMainWindow(parent)
     , trayIcon(nullptr)
     , trayMenu(nullptr)
-    , fileWatcher(nullptr)
+    , rootCoalescer(nullptr)
     , zoneCounter(1)
-    , booxRootPath("d:/boox")
+    , booxRootPath(rootPath)
 {
+    TraceSpan span("MainWindow::MainWindow", "startup");
+
     // Hide the main window - we only use tray icon
     hide();
 
     createActions();
     setupTrayIcon();
+    watchScreens();
+    watchTransfers();
 
     // Initialize and scan the boox directory
     initializeBooxDirectory();
+
+    // Zone layouts are read once and served from memory from here on
+    // (.layout.snapshot + .layout.journal; an old .layout.json is imported)
+    LayoutStore::instance()->open(QDir(booxRootPath).filePath(".layout"));
+
+    // Icons painted in previous runs are kept next to the layout file
+    IconService::instance()->openDiskCache(QDir(booxRootPath).filePath(".iconcache"));
+
     scanBooxDirectory();
 }
 
-MainWindow::~MainWindow()
+QString MainWindow::defaultRootPath()
 {
-    // Clean up zones
-    qDeleteAll(zones);
-    zones.clear();
+    return qEnvironmentVariable("BOOX_ROOT", QStringLiteral("d:/boox"));
+}
 
-    // Clean up file watcher
-    if (fileWatcher) {
-        delete fileWatcher;
+MainWindow::~MainWindow()
+{
+    // Clean up zones; the registry deletes the descriptors
+    for (ZoneDescriptor *descriptor : zoneRegistry.zones()) {
+        delete descriptor->zone;
+        descriptor->zone = nullptr;
     }
+
+    // Stop watching the root folder
+    WatchService::instance()->unsubscribeAll(this);
 }
 
 void MainWindow::createActions()
@@ -49,6 +78,37 @@ void MainWindow::createActions()
     hideAllAction = new QAction(tr("隐藏所有区域(&H)"), this);
     connect(hideAllAction, &QAction::triggered, this, &MainWindow::hideAllZones);
 
+    // Only shown while files are being moved
+    cancelTransfersAction = new QAction(tr("取消文件移动(&C)"), this);
+    cancelTransfersAction->setVisible(false);
+    connect(cancelTransfersAction, &QAction::triggered,
+            TransferQueue::instance(), &TransferQueue::cancelAll);
+
+    // Cross-device moves hash each copy against its source before deleting
+    // it; BOOX_VERIFY=1 in the environment turns this on at startup
+    const bool verify = qEnvironmentVariableIntValue("BOOX_VERIFY") != 0;
+    TransferQueue::instance()->setVerifyCopies(verify);
+    verifyCopiesAction = new QAction(tr("跨盘移动时校验(&V)"), this);
+    verifyCopiesAction->setCheckable(true);
+    verifyCopiesAction->setChecked(verify);
+    connect(verifyCopiesAction, &QAction::toggled,
+            TransferQueue::instance(), &TransferQueue::setVerifyCopies);
+
+    // Puts the items of the last delete back; only shown while there are some
+    undoDeleteAction = new QAction(tr("撤销删除(&U)"), this);
+    undoDeleteAction->setVisible(false);
+    connect(undoDeleteAction, &QAction::triggered, this, &MainWindow::undoDelete);
+    connect(Trash::instance(), &Trash::lastBatchChanged, this, [this]() {
+        const int count = Trash::instance()->lastBatch().size();
+        undoDeleteAction->setText(count > 1 ? tr("撤销删除 %1 项(&U)").arg(count) : tr("撤销删除(&U)"));
+        undoDeleteAction->setVisible(count > 0);
+    });
+
+    emptyTrashAction = new QAction(tr("清空区域回收站(&E)"), this);
+    connect(emptyTrashAction, &QAction::triggered, this, [this]() {
+        FileOpsHandler::emptyTrash(booxRootPath);
+    });
+
     quitAction = new QAction(tr("退出(&Q)"), this);
     connect(quitAction, &QAction::triggered, qApp, &QApplication::quit);
 }
@@ -61,6 +121,10 @@ void MainWindow::setupTrayIcon()
     trayMenu->addAction(showAllAction);
     trayMenu->addAction(hideAllAction);
     trayMenu->addSeparator();
+    trayMenu->addAction(undoDeleteAction);
+    trayMenu->addAction(emptyTrashAction);
+    trayMenu->addAction(verifyCopiesAction);
+    trayMenu->addAction(cancelTransfersAction);
     trayMenu->addAction(quitAction);
 
     trayIcon = new QSystemTrayIcon(this);
@@ -74,6 +138,105 @@ void MainWindow::setupTrayIcon()
     trayIcon->show();
 }
 
+void MainWindow::watchTransfers()
+{
+    TransferQueue *transfers = TransferQueue::instance();
+    connect(transfers, &TransferQueue::jobProgress, this, &MainWindow::updateTransferStatus);
+    connect(transfers, &TransferQueue::jobFinished, this, [this](const TransferStatus &status) {
+        updateTransferStatus();
+
+        // Only failures are worth a notification
+        if (status.failed.isEmpty() || status.cancelled) {
+            return;
+        }
+        const int successCount = status.itemCount - status.failed.size();
+        QString msg;
+        if (successCount > 0) {
+            msg = tr("成功移动 %1 个文件\n失败 %2 个: %3")
+                .arg(successCount)
+                .arg(status.failed.size())
+                .arg(status.failed.join(", "));
+        } else {
+            msg = tr("移动失败: %1").arg(status.failed.join(", "));
+        }
+        if (!status.mismatched.isEmpty()) {
+            msg += tr("\n校验不一致, 已保留源文件: %1").arg(status.mismatched.join(", "));
+        }
+        trayIcon->showMessage(tr("移动完成"), msg, QSystemTrayIcon::Warning, 5000);
+    });
+
+    DeleteQueue *deletes = DeleteQueue::instance();
+    connect(deletes, &DeleteQueue::jobProgress, this, &MainWindow::updateTransferStatus);
+    connect(deletes, &DeleteQueue::jobFinished, this, [this](const DeleteStatus &status) {
+        updateTransferStatus();
+        if (status.failed.isEmpty() || status.cancelled) {
+            return;
+        }
+        trayIcon->showMessage(tr("删除未完成"),
+                              tr("无法完全删除: %1").arg(status.failed.join(", ")),
+                              QSystemTrayIcon::Warning, 5000);
+    });
+}
+
+void MainWindow::updateTransferStatus()
+{
+    TransferQueue *transfers = TransferQueue::instance();
+    DeleteQueue *deletes = DeleteQueue::instance();
+    cancelTransfersAction->setVisible(transfers->isBusy());
+    if (!transfers->isBusy() && !deletes->isBusy()) {
+        trayIcon->setToolTip(tr("Boox - 桌面悬浮区域"));
+        return;
+    }
+
+    QStringList lines;
+    if (transfers->isBusy()) {
+        // All running jobs together
+        int items = 0;
+        int itemsDone = 0;
+        qint64 totalBytes = 0;
+        qint64 doneBytes = 0;
+        double bytesPerSecond = 0;
+        for (const TransferStatus &status : transfers->activeJobs()) {
+            items += status.itemCount;
+            itemsDone += status.itemsDone;
+            totalBytes += qMax<qint64>(0, status.totalBytes);
+            doneBytes += status.doneBytes;
+            bytesPerSecond += status.bytesPerSecond;
+        }
+
+        lines << tr("正在移动 %1/%2 项").arg(itemsDone).arg(items);
+        if (totalBytes > 0) {
+            const QLocale locale;
+            lines << tr("%1 / %2 (%3/s)")
+                .arg(locale.formattedDataSize(doneBytes))
+                .arg(locale.formattedDataSize(totalBytes))
+                .arg(locale.formattedDataSize(qint64(bytesPerSecond)));
+        }
+    }
+
+    if (deletes->isBusy()) {
+        int items = 0;
+        int itemsDone = 0;
+        qint64 entries = 0;
+        for (const DeleteStatus &status : deletes->activeJobs()) {
+            items += status.itemCount;
+            itemsDone += status.itemsDone;
+            entries += status.entriesRemoved;
+        }
+        lines << tr("正在删除 %1/%2 项 (已删除 %3 个文件)").arg(itemsDone).arg(items).arg(entries);
+    }
+    trayIcon->setToolTip(lines.join(QLatin1Char('\n')));
+}
+
+void MainWindow::undoDelete()
+{
+    const QStringList failed = Trash::instance()->restoreLastBatch();
+    if (!failed.isEmpty()) {
+        trayIcon->showMessage(tr("撤销删除"), tr("无法恢复: %1").arg(failed.join(", ")),
+                              QSystemTrayIcon::Warning, 5000);
+    }
+}
+
 void MainWindow::createNewZone()
 {
     // Generate unique folder name
@@ -86,55 +249,16 @@ void MainWindow::createNewZone()
         folderPath = QDir(booxRootPath).absoluteFilePath(zoneName);
     }
 
-    // Temporarily block file system watcher signals to prevent duplicate zone creation
-    fileWatcher->blockSignals(true);
-
     // Create the physical folder
     QDir dir;
     if (!dir.mkpath(folderPath)) {
-        fileWatcher->blockSignals(false);  // Restore signals
         QMessageBox::warning(nullptr, tr("错误"),
                            tr("无法创建文件夹: %1").arg(folderPath));
         return;
     }
 
-    // Create zone with folder path
-    FloatingZone *zone = new FloatingZone(zoneName, folderPath);
-
-    connect(zone, &FloatingZone::zoneClosed, this, &MainWindow::onZoneClosed);
-    connect(zone, &FloatingZone::selectionChanged, this, &MainWindow::onZoneSelectionChanged);
-
-    zones.append(zone);
-
-    // Position new zone if no stored layout
-    if (!zone->hasStoredLayout()) {
-        int index = zones.size() - 1;
-
-        QRect screenGeometry = QGuiApplication::primaryScreen()->availableGeometry();
-        int screenWidth = screenGeometry.width();
-        int screenHeight = screenGeometry.height();
-
-        const int GRID_SIZE = 50;
-        const int ZONE_HEIGHT = 350;
-        const int MARGIN = 50;
-
-        int zonesPerColumn = qMax(1, (screenHeight - MARGIN * 2) / (ZONE_HEIGHT + GRID_SIZE));
-        int col = index / zonesPerColumn;
-        int row = index % zonesPerColumn;
-
-        int xPos = screenWidth - (col + 1) * (zone->width() + MARGIN);
-        int yPos = MARGIN + row * (ZONE_HEIGHT + GRID_SIZE);
-
-        xPos = qRound(xPos / (double)GRID_SIZE) * GRID_SIZE;
-        yPos = qRound(yPos / (double)GRID_SIZE) * GRID_SIZE;
-
-        zone->move(xPos, yPos);
-    }
-
-    zone->show();
-
-    // Restore file system watcher signals
-    fileWatcher->blockSignals(false);
+    // Create zone with folder path; a new zone is always shown
+    materializeZone(zoneRegistry.insert(folderPath));
 
     trayIcon->showMessage(tr("新建区域"),
                           tr("已创建新的悬浮区域: %1").arg(zoneName),
@@ -143,15 +267,19 @@ void MainWindow::createNewZone()
 
 void MainWindow::showAllZones()
 {
-    for (FloatingZone *zone : zones) {
-        zone->show();
-    }
+    zonesHidden = false;
+    updateMaterializedZones();
 }
 
 void MainWindow::hideAllZones()
 {
-    for (FloatingZone *zone : zones) {
-        zone->hide();
+    // Widgets are only hidden: rebuilding them would lose the lock state,
+    // the selection and the scroll position, none of which is in the layout
+    zonesHidden = true;
+    for (ZoneDescriptor *descriptor : zoneRegistry.zones()) {
+        if (descriptor->zone) {
+            descriptor->zone->hide();
+        }
     }
 }
 
@@ -164,7 +292,10 @@ void MainWindow::trayIconActivated(QSystemTrayIcon::ActivationReason reason)
 
 void MainWindow::onZoneClosed(FloatingZone* zone)
 {
-    zones.removeOne(zone);
+    if (ZoneDescriptor *descriptor = zoneRegistry.find(zone)) {
+        descriptor->zone = nullptr;
+        zoneRegistry.remove(descriptor);
+    }
     zone->deleteLater();
 }
 
@@ -183,121 +314,287 @@ void MainWindow::initializeBooxDirectory()
         }
     }
 
+    // Folders created/removed in bulk are handled by a single rescan
+    rootCoalescer = new ChangeCoalescer(this);
+    connect(rootCoalescer, &ChangeCoalescer::triggered, this, &MainWindow::syncZonesWithRoot);
+
     // Setup file system watcher
-    fileWatcher = new QFileSystemWatcher(this);
-    fileWatcher->addPath(booxRootPath);
-    connect(fileWatcher, &QFileSystemWatcher::directoryChanged,
-            this, &MainWindow::onBooxDirectoryChanged);
+    WatchService::instance()->subscribe(this, booxRootPath,
+        [this](const QVector<WatchEvent> &events) {
+            onBooxDirectoryChanged(events);
+        });
 }
 
 void MainWindow::scanBooxDirectory()
 {
-    QDir dir(booxRootPath);
-    if (!dir.exists()) {
+    const qint64 requestedNs = Tracer::isEnabled() ? Tracer::now() : -1;
+
+    // Get all subdirectories in the boox root off the GUI thread
+    DirScanner::instance()->scan(this, booxRootPath, DirScanner::DirsOnly, nullptr,
+        [this, requestedNs](const QVector<FileEntry> &folders, bool ok) {
+            TraceSpan span("MainWindow::scanBooxDirectory (create zones)", "startup");
+            if (requestedNs >= 0) {
+                Tracer::recordAsync("MainWindow::scanBooxDirectory", "startup",
+                                    requestedNs, Tracer::now(), booxRootPath);
+            }
+
+            if (!ok) {
+                return;
+            }
+
+            if (folders.isEmpty()) {
+                trayIcon->showMessage(tr("提示"),
+                                     tr("Boox 目录为空,请在 %1 下创建文件夹").arg(booxRootPath),
+                                     QSystemTrayIcon::Information, 3000);
+            }
+
+            // Create a zone for each folder, in name order
+            QVector<FileEntry> sorted = folders;
+            std::sort(sorted.begin(), sorted.end(), &ZoneFileModel::lessThan);
+            for (const FileEntry &folder : sorted) {
+                createZoneForFolder(folder.path);
+            }
+
+            // Folders that changed while listing
+            syncZonesWithRoot();
+        });
+}
+
+void MainWindow::createZoneForFolder(const QString &folderPath)
+{
+    // Check if a zone already exists for this folder
+    if (zoneRegistry.contains(folderPath)) {
         return;
     }
 
-    // Get all subdirectories in the boox root
-    QFileInfoList folders = dir.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name);
+    // Only zones that end up on a screen get a widget right away
+    ZoneDescriptor *descriptor = zoneRegistry.insert(folderPath);
+    if (!zonesHidden && isOnScreen(descriptor)) {
+        materializeZone(descriptor);
+    }
+}
 
-    if (folders.isEmpty()) {
-        trayIcon->showMessage(tr("提示"),
-                             tr("Boox 目录为空,请在 %1 下创建文件夹").arg(booxRootPath),
-                             QSystemTrayIcon::Information, 3000);
+void MainWindow::materializeZone(ZoneDescriptor *descriptor)
+{
+    if (descriptor->zone) {
         return;
     }
 
-    // Create a zone for each folder
-    for (const QFileInfo &folderInfo : folders) {
-        createZoneForFolder(folderInfo.absoluteFilePath());
+    QString folderName = QFileInfo(descriptor->folderPath).fileName();
+    FloatingZone *zone = new FloatingZone(folderName, descriptor->folderPath);
+    descriptor->zone = zone;
+
+    connect(zone, &FloatingZone::zoneClosed, this, &MainWindow::onZoneClosed);
+    connect(zone, &FloatingZone::selectionChanged, this, &MainWindow::onZoneSelectionChanged);
+    connect(zone, &FloatingZone::layoutChanged, this, [this, zone]() {
+        // Dragged off every screen: no need to keep the widget around
+        ZoneDescriptor *moved = zoneRegistry.find(zone);
+        if (moved && !isOnScreen(moved)) {
+            releaseZone(moved, true);
+        }
+    });
+
+    // Only set default position if there's no stored layout
+    if (!zone->hasStoredLayout()) {
+        placeNewZone(zone, zoneRegistry.indexOf(descriptor));
     }
+
+    zone->show();
 }
 
-void MainWindow::createZoneForFolder(const QString &folderPath)
+void MainWindow::releaseZone(ZoneDescriptor *descriptor, bool keepLayout)
 {
-    QFileInfo folderInfo(folderPath);
-    if (!folderInfo.exists() || !folderInfo.isDir()) {
+    FloatingZone *zone = descriptor->zone;
+    if (!zone) {
         return;
     }
 
-    // Check if a zone already exists for this folder
-    for (FloatingZone *zone : zones) {
-        if (zone->getFolderPath() == folderPath) {
-            return; // Zone already exists
+    descriptor->zone = nullptr;
+    disconnect(zone, nullptr, this, nullptr);
+    if (keepLayout) {
+        zone->saveLayout();
+    }
+    zone->hide();
+    zone->deleteLater();
+}
+
+bool MainWindow::isOnScreen(const ZoneDescriptor *descriptor) const
+{
+    QRect geometry;
+    if (descriptor->zone) {
+        geometry = descriptor->zone->geometry();
+    } else {
+        ZoneLayout layout;
+        if (!LayoutStore::instance()->lookup(descriptor->folderPath, layout)
+                || !layout.geometry.isValid()) {
+            // Zones without a layout are placed on the primary screen
+            return true;
         }
+        geometry = layout.geometry;
     }
 
-    QString folderName = folderInfo.fileName();
-    FloatingZone *zone = new FloatingZone(folderName, folderPath);
+    for (QScreen *screen : QGuiApplication::screens()) {
+        if (screen->geometry().intersects(geometry)) {
+            return true;
+        }
+    }
+    return false;
+}
 
-    connect(zone, &FloatingZone::zoneClosed, this, &MainWindow::onZoneClosed);
-    connect(zone, &FloatingZone::selectionChanged, this, &MainWindow::onZoneSelectionChanged);
+void MainWindow::updateMaterializedZones()
+{
+    // Only zones off every screen lose their widget; hidden ones keep it
+    for (ZoneDescriptor *descriptor : zoneRegistry.zones()) {
+        const bool onScreen = isOnScreen(descriptor);
+        if (!onScreen) {
+            releaseZone(descriptor, true);
+        } else if (!zonesHidden) {
+            if (!descriptor->zone) {
+                materializeZone(descriptor);
+            } else if (descriptor->zone->isHidden()) {
+                descriptor->zone->show();
+            }
+        }
+    }
+}
 
-    zones.append(zone);
+void MainWindow::watchScreens()
+{
+    // Zones on a screen that comes or goes are built or released
+    auto watchScreen = [this](QScreen *screen) {
+        connect(screen, &QScreen::geometryChanged, this, [this]() {
+            updateMaterializedZones();
+        });
+    };
+    for (QScreen *screen : QGuiApplication::screens()) {
+        watchScreen(screen);
+    }
 
-    // Only set default position if there's no stored layout
-    if (!zone->hasStoredLayout()) {
-        // Position zones in a grid layout on the right side of the screen
-        int index = zones.size() - 1;
+    connect(qApp, &QGuiApplication::screenAdded, this, [this, watchScreen](QScreen *screen) {
+        watchScreen(screen);
+        updateMaterializedZones();
+    });
+    connect(qApp, &QGuiApplication::screenRemoved, this, [this]() {
+        // The screen is still listed while the signal is delivered
+        QTimer::singleShot(0, this, &MainWindow::updateMaterializedZones);
+    });
+}
 
-        // Get screen geometry
-        QRect screenGeometry = QGuiApplication::primaryScreen()->availableGeometry();
-        int screenWidth = screenGeometry.width();
-        int screenHeight = screenGeometry.height();
+void MainWindow::placeNewZone(FloatingZone *zone, int index)
+{
+    // Position zones in a grid layout on the right side of the screen
 
-        // Grid settings
-        const int GRID_SIZE = 50;  // Match the GRID_SIZE in FloatingZone
-        const int ZONE_HEIGHT = 350;  // Default zone height
-        const int MARGIN = 50;  // Margin from screen edge (aligned to grid)
+    // Get screen geometry
+    QRect screenGeometry = QGuiApplication::primaryScreen()->availableGeometry();
+    int screenWidth = screenGeometry.width();
+    int screenHeight = screenGeometry.height();
 
-        // Calculate grid-aligned position from right side
-        int zonesPerColumn = qMax(1, (screenHeight - MARGIN * 2) / (ZONE_HEIGHT + GRID_SIZE));
-        int col = index / zonesPerColumn;
-        int row = index % zonesPerColumn;
+    // Grid settings
+    const int GRID_SIZE = 50;  // Match the GRID_SIZE in FloatingZone
+    const int ZONE_HEIGHT = 350;  // Default zone height
+    const int MARGIN = 50;  // Margin from screen edge (aligned to grid)
 
-        // Calculate position and align to grid
-        int xPos = screenWidth - (col + 1) * (zone->width() + MARGIN);
-        int yPos = MARGIN + row * (ZONE_HEIGHT + GRID_SIZE);
+    // Calculate grid-aligned position from right side
+    int zonesPerColumn = qMax(1, (screenHeight - MARGIN * 2) / (ZONE_HEIGHT + GRID_SIZE));
+    int col = index / zonesPerColumn;
+    int row = index % zonesPerColumn;
 
-        // Snap to grid
-        xPos = qRound(xPos / (double)GRID_SIZE) * GRID_SIZE;
-        yPos = qRound(yPos / (double)GRID_SIZE) * GRID_SIZE;
+    // Calculate position and align to grid
+    int xPos = screenWidth - (col + 1) * (zone->width() + MARGIN);
+    int yPos = MARGIN + row * (ZONE_HEIGHT + GRID_SIZE);
 
-        zone->move(xPos, yPos);
-    }
+    // Snap to grid
+    xPos = qRound(xPos / (double)GRID_SIZE) * GRID_SIZE;
+    yPos = qRound(yPos / (double)GRID_SIZE) * GRID_SIZE;
 
-    zone->show();
+    zone->move(xPos, yPos);
 }
 
-void MainWindow::onBooxDirectoryChanged(const QString &path)
+void MainWindow::onBooxDirectoryChanged(const QVector<WatchEvent> &events)
 {
-    Q_UNUSED(path);
+    // Only folders map to zones; loose files in the root are ignored.
+    // Zones created here already exist by the time the sync runs.
+    for (const WatchEvent &event : events) {
+        if (event.kind == WatchEvent::Rescan || event.kind == WatchEvent::FolderGone) {
+            rootRescanPending = true;
+        } else if (event.isDir) {
+            pendingRootNames.insert(event.name);
+        } else {
+            continue;
+        }
+        rootCoalescer->notify();
+    }
+}
 
-    // Rescan the directory to pick up new folders
-    // This is a simple implementation - you might want to optimize it
-    // to only handle added/removed folders instead of rescanning everything
+void MainWindow::syncZonesWithRoot()
+{
+    // A listing or lookup still running syncs again when it completes
+    if (DirScanner::instance()->isBusy(this)) {
+        return;
+    }
 
-    QDir dir(booxRootPath);
-    QFileInfoList folders = dir.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name);
+    if (rootRescanPending) {
+        // Details were lost: diff a full listing against the registry
+        rootRescanPending = false;
+        pendingRootNames.clear();
+
+        DirScanner::instance()->scan(this, booxRootPath, DirScanner::DirsOnly, nullptr,
+            [this](const QVector<FileEntry> &folders, bool ok) {
+                if (ok) {
+                    applyZoneChanges(zoneRegistry.diffListing(folders));
+                }
+                syncZonesWithRoot();
+            });
+        return;
+    }
 
-    // Check for new folders and create zones
-    for (const QFileInfo &folderInfo : folders) {
-        createZoneForFolder(folderInfo.absoluteFilePath());
+    if (pendingRootNames.isEmpty()) {
+        return;
     }
 
-    // Check for deleted folders and remove corresponding zones
-    QList<FloatingZone*> zonesToRemove;
-    for (FloatingZone *zone : zones) {
-        QString zonePath = zone->getFolderPath();
-        if (!zonePath.isEmpty() && !QDir(zonePath).exists()) {
-            zonesToRemove.append(zone);
+    // Look up only the folders that changed
+    const QStringList names = pendingRootNames.values();
+    pendingRootNames.clear();
+
+    DirScanner::instance()->stat(this, booxRootPath, names,
+        [this](const QVector<FileEntry> &present, const QStringList &missing) {
+            const QDir root(booxRootPath);
+            QStringList missingPaths;
+            missingPaths.reserve(missing.size());
+            for (const QString &name : missing) {
+                missingPaths.append(root.absoluteFilePath(name));
+            }
+
+            applyZoneChanges(zoneRegistry.diffDelta(present, missingPaths));
+            syncZonesWithRoot();
+        });
+}
+
+void MainWindow::applyZoneChanges(const ZoneChanges &changes)
+{
+    // Renamed folders keep their zone
+    for (const auto &rename : changes.renamed) {
+        ZoneDescriptor *descriptor = rename.first;
+        LayoutStore::instance()->rename(descriptor->folderPath, rename.second);
+        zoneRegistry.retarget(descriptor, rename.second);
+
+        FloatingZone *zone = descriptor->zone;
+        if (zone && zone->getFolderPath() != rename.second) {
+            zone->onFolderRenamed(rename.second);
         }
     }
 
-    for (FloatingZone *zone : zonesToRemove) {
-        zones.removeOne(zone);
-        zone->close();
-        zone->deleteLater();
+    // Remove zones whose folder was deleted
+    for (ZoneDescriptor *descriptor : changes.removed) {
+        releaseZone(descriptor, false);
+        zoneRegistry.remove(descriptor);
+    }
+
+    // Create zones for new folders, in name order
+    QVector<FileEntry> added = changes.added;
+    std::sort(added.begin(), added.end(), &ZoneFileModel::lessThan);
+    for (const FileEntry &folder : added) {
+        createZoneForFolder(folder.path);
     }
 }
 
@@ -305,8 +602,9 @@ void MainWindow::onZoneSelectionChanged(FloatingZone* changedZone, const QString
 {
     Q_UNUSED(selectedPath);
 
-    for (FloatingZone* zone : zones) {
-        if (zone != changedZone) {
+    for (ZoneDescriptor *descriptor : zoneRegistry.zones()) {
+        FloatingZone *zone = descriptor->zone;
+        if (zone && zone != changedZone) {
             zone->clearFileSelection();
         }
     }
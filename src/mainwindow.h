@@ -5,15 +5,22 @@
 #include <QSystemTrayIcon>
 #include <QMenu>
 #include <QList>
-#include <QFileSystemWatcher>
+#include <QSet>
 #include "floatingzone.h"
+#include "features/coalescer/coalescer.h"
+#include "features/watch/watchservice.h"
+#include "features/registry/zoneregistry.h"
 
 class MainWindow : public QMainWindow
 {
     Q_OBJECT
 
 public:
-    MainWindow(QWidget *parent = nullptr);
+    // rootPath: folder whose subfolders become zones
+    explicit MainWindow(const QString &rootPath = defaultRootPath(), QWidget *parent = nullptr);
+
+    // BOOX_ROOT from the environment, else d:/boox
+    static QString defaultRootPath();
     ~MainWindow();
 
 private slots:
@@ -22,7 +29,6 @@ private slots:
     void hideAllZones();
     void trayIconActivated(QSystemTrayIcon::ActivationReason reason);
     void onZoneClosed(FloatingZone* zone);
-    void onBooxDirectoryChanged(const QString &path);
     void onZoneSelectionChanged(FloatingZone* changedZone, const QString& selectedPath);
 
 private:
@@ -31,15 +37,36 @@ private:
     void initializeBooxDirectory();
     void scanBooxDirectory();
     void createZoneForFolder(const QString &folderPath);
+    void materializeZone(ZoneDescriptor *descriptor);
+    void releaseZone(ZoneDescriptor *descriptor, bool keepLayout);
+    bool isOnScreen(const ZoneDescriptor *descriptor) const;
+    void updateMaterializedZones();
+    void watchScreens();
+    void watchTransfers();
+    void updateTransferStatus();
+    void undoDelete();
+    void placeNewZone(FloatingZone *zone, int index);
+    void syncZonesWithRoot();
+    void onBooxDirectoryChanged(const QVector<WatchEvent> &events);
+    void applyZoneChanges(const ZoneChanges &changes);
 
     QSystemTrayIcon *trayIcon;
     QMenu *trayMenu;
-    QList<FloatingZone*> zones;
-    QFileSystemWatcher *fileWatcher;
+    ZoneRegistry zoneRegistry;
+    bool zonesHidden = false;
+    ChangeCoalescer *rootCoalescer;
+
+    // Root watcher deltas not yet applied: changed folder names, or a full relist
+    QSet<QString> pendingRootNames;
+    bool rootRescanPending = false;
 
     QAction *newZoneAction;
     QAction *showAllAction;
     QAction *hideAllAction;
+    QAction *cancelTransfersAction;
+    QAction *verifyCopiesAction;
+    QAction *undoDeleteAction;
+    QAction *emptyTrashAction;
     QAction *quitAction;
 
     int zoneCounter;
@@ -0,0 +1,96 @@
+#include <QtTest>
+#include "features/checksum/checksum.h"
+
+class TestChecksum : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void crc32_data();
+    void crc32();
+    void hash64_data();
+    void hash64();
+    void streamMatchesOneShot_data();
+    void streamMatchesOneShot();
+};
+
+void TestChecksum::crc32_data()
+{
+    QTest::addColumn<QByteArray>("input");
+    QTest::addColumn<quint32>("expected");
+
+    QTest::newRow("empty") << QByteArray() << quint32(0);
+    QTest::newRow("check") << QByteArray("123456789") << quint32(0xCBF43926);
+    QTest::newRow("fox") << QByteArray("The quick brown fox jumps over the lazy dog")
+                         << quint32(0x414FA339);
+}
+
+void TestChecksum::crc32()
+{
+    QFETCH(QByteArray, input);
+    QFETCH(quint32, expected);
+
+    QCOMPARE(Checksum::crc32(input), expected);
+    QCOMPARE(Checksum::crc32(reinterpret_cast<const uchar *>(input.constData()), input.size()),
+             expected);
+}
+
+void TestChecksum::hash64_data()
+{
+    QTest::addColumn<QByteArray>("input");
+    QTest::addColumn<quint64>("expected");
+
+    // Reference values of XXH64 with seed 0
+    QTest::newRow("empty") << QByteArray() << Q_UINT64_C(0xEF46DB3751D8E999);
+    QTest::newRow("a") << QByteArray("a") << Q_UINT64_C(0xD24EC4F1A98C6E5B);
+    QTest::newRow("abc") << QByteArray("abc") << Q_UINT64_C(0x44BC2CF5AD770999);
+    // Longer than one 32-byte stripe
+    QTest::newRow("spam") << QByteArray("Nobody inspects the spammish repetition")
+                          << Q_UINT64_C(0xFBCEA83C8A378BF1);
+}
+
+void TestChecksum::hash64()
+{
+    QFETCH(QByteArray, input);
+    QFETCH(quint64, expected);
+
+    QCOMPARE(Checksum::hash64(reinterpret_cast<const uchar *>(input.constData()), input.size()),
+             expected);
+
+    Checksum::StreamHash stream;
+    stream.add(input);
+    QCOMPARE(stream.result(), expected);
+}
+
+void TestChecksum::streamMatchesOneShot_data()
+{
+    QTest::addColumn<int>("chunk");
+
+    for (const int chunk : { 1, 7, 31, 32, 33, 1000, 65536 }) {
+        QTest::newRow(QByteArray::number(chunk).constData()) << chunk;
+    }
+}
+
+void TestChecksum::streamMatchesOneShot()
+{
+    QFETCH(int, chunk);
+
+    QByteArray data(10007, Qt::Uninitialized);
+    quint32 state = 12345;
+    for (int i = 0; i < data.size(); ++i) {
+        state = state * 1103515245 + 12345;
+        data[i] = char(state >> 24);
+    }
+    const uchar *bytes = reinterpret_cast<const uchar *>(data.constData());
+
+    for (const quint64 seed : { quint64(0), quint64(0x9E3779B97F4A7C15) }) {
+        Checksum::StreamHash stream(seed);
+        for (int pos = 0; pos < data.size(); pos += chunk) {
+            stream.add(bytes + pos, qMin(chunk, data.size() - pos));
+        }
+        QCOMPARE(stream.result(), Checksum::hash64(bytes, data.size(), seed));
+    }
+}
+
+QTEST_APPLESS_MAIN(TestChecksum)
+#include "tst_checksum.moc"
@@ -0,0 +1,308 @@
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+#include <QtTest>
+#include "features/checksum/checksum.h"
+#include "features/copy/copyengine.h"
+
+#if defined(Q_OS_LINUX)
+#include <sys/stat.h>
+#endif
+
+namespace {
+
+constexpr qint64 MiB = 1024 * 1024;
+
+// Deterministic, incompressible-looking bytes
+QByteArray pattern(qint64 size, quint32 seed)
+{
+    QByteArray data(int(size), Qt::Uninitialized);
+    quint32 state = seed;
+    for (int i = 0; i < data.size(); ++i) {
+        state = state * 1103515245 + 12345;
+        data[i] = char(state >> 24);
+    }
+    return data;
+}
+
+QByteArray contentOf(const QString &filePath)
+{
+    QFile file(filePath);
+    return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+}
+
+#if defined(Q_OS_LINUX)
+// Bytes the file system actually allocated for the file
+qint64 allocatedBytes(const QString &filePath)
+{
+    struct stat st;
+    if (::stat(QFile::encodeName(filePath).constData(), &st) != 0) {
+        return -1;
+    }
+    return qint64(st.st_blocks) * 512;
+}
+#endif
+
+} // namespace
+
+class TestCopyEngine : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void copiesContentAndMetadata_data();
+    void copiesContentAndMetadata();
+    void keepsHoles_data();
+    void keepsHoles();
+    void refusesExistingTarget();
+    void cancelRemovesTarget();
+    void verifyDetectsDifference();
+    void hashedCopyVerifiesTarget_data();
+    void hashedCopyVerifiesTarget();
+
+private:
+    void addMethodRows();
+    QString path(const QString &name) const { return dir->filePath(name); }
+
+    QTemporaryDir *dir = nullptr;
+};
+
+void TestCopyEngine::init()
+{
+    dir = new QTemporaryDir;
+    QVERIFY(dir->isValid());
+}
+
+void TestCopyEngine::cleanup()
+{
+    delete dir;
+    dir = nullptr;
+}
+
+void TestCopyEngine::addMethodRows()
+{
+    QTest::addColumn<int>("methods");
+
+    // Each method with the read/write loop behind it, as the engine uses them
+    QTest::newRow("all") << int(CopyEngine::AllMethods);
+    QTest::newRow("copy_file_range") << int(CopyEngine::CopyFileRange | CopyEngine::ReadWrite);
+    QTest::newRow("sendfile") << int(CopyEngine::SendFile | CopyEngine::ReadWrite);
+    QTest::newRow("read/write") << int(CopyEngine::ReadWrite);
+}
+
+void TestCopyEngine::copiesContentAndMetadata_data()
+{
+    addMethodRows();
+}
+
+void TestCopyEngine::copiesContentAndMetadata()
+{
+    QFETCH(int, methods);
+
+    // Spans more than one progress chunk and ends mid-buffer
+    const QByteArray data = pattern(CopyEngine::CHUNK_SIZE + 3 * MiB + 123, 1);
+    const QString source = path("source.bin");
+    const QString target = path("target.bin");
+    {
+        QFile file(source);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        QCOMPARE(file.write(data), qint64(data.size()));
+    }
+    const QFileDevice::Permissions permissions = QFileDevice::ReadOwner | QFileDevice::WriteOwner
+        | QFileDevice::ExeOwner | QFileDevice::ReadUser | QFileDevice::WriteUser
+        | QFileDevice::ExeUser | QFileDevice::ReadGroup | QFileDevice::ReadOther;
+    QVERIFY(QFile::setPermissions(source, permissions));
+    const QDateTime modified = QDateTime::fromSecsSinceEpoch(1500000000).addMSecs(250);
+    {
+        QFile file(source);
+        QVERIFY(file.open(QIODevice::ReadWrite));
+        QVERIFY(file.setFileTime(modified, QFileDevice::FileModificationTime));
+    }
+
+    qint64 reported = 0;
+    const CopyEngine::Result result = CopyEngine::copyFile(source, target, [&reported](qint64 bytes) {
+        reported += bytes;
+        return true;
+    }, methods);
+
+    QVERIFY2(result.ok, qPrintable(result.error));
+    QCOMPARE(result.bytes, qint64(data.size()));
+    QCOMPARE(reported, qint64(data.size()));
+    QVERIFY(contentOf(target) == data);
+    QCOMPARE(QFile::permissions(target), QFile::permissions(source));
+    QCOMPARE(QFileInfo(target).lastModified(), QFileInfo(source).lastModified());
+}
+
+void TestCopyEngine::keepsHoles_data()
+{
+    addMethodRows();
+}
+
+void TestCopyEngine::keepsHoles()
+{
+#if defined(Q_OS_LINUX)
+    QFETCH(int, methods);
+
+    // data, 16 MiB hole, data, trailing hole up to 32 MiB
+    const QByteArray head = pattern(64 * 1024, 2);
+    const QByteArray tail = pattern(64 * 1024, 3);
+    const QString source = path("sparse.bin");
+    const QString target = path("sparse-copy.bin");
+    {
+        QFile file(source);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        QCOMPARE(file.write(head), qint64(head.size()));
+        QVERIFY(file.seek(16 * MiB));
+        QCOMPARE(file.write(tail), qint64(tail.size()));
+        QVERIFY(file.resize(32 * MiB));
+    }
+    const qint64 sourceAllocated = allocatedBytes(source);
+    if (sourceAllocated < 0 || sourceAllocated > 8 * MiB) {
+        QSKIP("the file system of the temporary folder does not keep holes");
+    }
+
+    const CopyEngine::Result result = CopyEngine::copyFile(source, target, {}, methods);
+    QVERIFY2(result.ok, qPrintable(result.error));
+
+    QCOMPARE(QFileInfo(target).size(), 32 * MiB);
+    QVERIFY(contentOf(target) == contentOf(source));
+    // Only the data ranges were written (allowing for file system block rounding)
+    QVERIFY2(allocatedBytes(target) <= sourceAllocated + MiB,
+             qPrintable(QStringLiteral("%1 bytes allocated for the copy")
+                        .arg(allocatedBytes(target))));
+#else
+    QSKIP("hole detection (SEEK_DATA / SEEK_HOLE) is only used on Linux");
+#endif
+}
+
+void TestCopyEngine::refusesExistingTarget()
+{
+    const QString source = path("source.txt");
+    const QString target = path("target.txt");
+    {
+        QFile file(source);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write("new");
+    }
+    {
+        QFile file(target);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write("existing");
+    }
+
+    const CopyEngine::Result result = CopyEngine::copyFile(source, target);
+    QVERIFY(!result.ok);
+    QVERIFY(!result.error.isEmpty());
+    QCOMPARE(contentOf(target), QByteArray("existing"));
+}
+
+void TestCopyEngine::cancelRemovesTarget()
+{
+    const QString source = path("source.bin");
+    const QString target = path("target.bin");
+    {
+        QFile file(source);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write(pattern(4 * MiB, 4));
+    }
+
+    const CopyEngine::Result result = CopyEngine::copyFile(source, target, [](qint64) {
+        return false;
+    }, CopyEngine::ReadWrite);
+
+    QVERIFY(!result.ok);
+    QVERIFY(result.cancelled);
+    QVERIFY(!QFileInfo::exists(target));
+}
+
+void TestCopyEngine::verifyDetectsDifference()
+{
+    const QString source = path("source.bin");
+    const QString target = path("target.bin");
+    const QByteArray data = pattern(3 * MiB + 7, 5);
+    {
+        QFile file(source);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write(data);
+    }
+
+    QVERIFY(CopyEngine::copyFile(source, target).ok);
+    const CopyEngine::Result same = CopyEngine::verify(source, target);
+    QVERIFY2(same.ok, qPrintable(same.error));
+
+    {
+        QFile file(target);
+        QVERIFY(file.open(QIODevice::ReadWrite));
+        QVERIFY(file.seek(2 * MiB));
+        QVERIFY(file.putChar(char(data.at(2 * MiB) ^ 1)));
+    }
+    const CopyEngine::Result changed = CopyEngine::verify(source, target);
+    QVERIFY(!changed.ok);
+    QVERIFY(!changed.error.isEmpty());
+}
+
+void TestCopyEngine::hashedCopyVerifiesTarget_data()
+{
+    QTest::addColumn<bool>("sparse");
+
+    QTest::newRow("dense") << false;
+    QTest::newRow("sparse") << true;
+}
+
+void TestCopyEngine::hashedCopyVerifiesTarget()
+{
+    QFETCH(bool, sparse);
+
+    const QString source = path("source.bin");
+    const QString target = path("target.bin");
+    const QByteArray data = pattern(3 * MiB + 7, 6);
+    {
+        QFile file(source);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        QCOMPARE(file.write(data), qint64(data.size()));
+        if (sparse) {
+            // The hole in between must hash as the zeros it reads back as
+            QVERIFY(file.seek(16 * MiB));
+            QCOMPARE(file.write(data), qint64(data.size()));
+        }
+    }
+
+    const CopyEngine::Result result = CopyEngine::copyFile(source, target, {},
+                                                           CopyEngine::AllMethods, true);
+    QVERIFY2(result.ok, qPrintable(result.error));
+    if (result.method == CopyEngine::Reflink) {
+        QSKIP("the file system of the temporary folder cloned the file");
+    }
+    QVERIFY(result.hashed);
+    QCOMPARE(result.method, CopyEngine::ReadWrite);
+
+    const QByteArray content = contentOf(source);
+    QCOMPARE(result.sourceHash,
+             Checksum::hash64(reinterpret_cast<const uchar *>(content.constData()), content.size()));
+
+    qint64 reported = 0;
+    const CopyEngine::Result same = CopyEngine::verifyTarget(target, result.sourceHash,
+                                                             [&reported](qint64 bytes) {
+        reported += bytes;
+        return true;
+    });
+    QVERIFY2(same.ok, qPrintable(same.error));
+    QCOMPARE(reported, QFileInfo(target).size());
+
+    {
+        QFile file(target);
+        QVERIFY(file.open(QIODevice::ReadWrite));
+        QVERIFY(file.seek(MiB));
+        QVERIFY(file.putChar(char(data.at(MiB) ^ 1)));
+    }
+    const CopyEngine::Result changed = CopyEngine::verifyTarget(target, result.sourceHash);
+    QVERIFY(!changed.ok);
+    QVERIFY(!changed.error.isEmpty());
+}
+
+QTEST_GUILESS_MAIN(TestCopyEngine)
+#include "tst_copyengine.moc"
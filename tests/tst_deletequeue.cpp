@@ -0,0 +1,229 @@
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+#include <QtTest>
+#include "features/delete/deletequeue.h"
+
+namespace {
+
+bool touch(const QString &filePath)
+{
+    QFile file(filePath);
+    return file.open(QIODevice::WriteOnly);
+}
+
+// `folders` subfolders of root, each with `files` files; returns the number
+// of entries created (files and folders, root included)
+qint64 makeWideTree(const QString &root, int folders, int files)
+{
+    qint64 entries = 0;
+    if (!QDir().mkpath(root)) {
+        return -1;
+    }
+    ++entries;
+    for (int f = 0; f < folders; ++f) {
+        const QString folder = QDir(root).filePath(QStringLiteral("folder %1").arg(f));
+        if (!QDir().mkdir(folder)) {
+            return -1;
+        }
+        ++entries;
+        for (int i = 0; i < files; ++i) {
+            if (!touch(QDir(folder).filePath(QStringLiteral("file %1.txt").arg(i)))) {
+                return -1;
+            }
+            ++entries;
+        }
+    }
+    return entries;
+}
+
+int entryCount(const QString &folder)
+{
+    return QDir(folder).entryList(QDir::AllEntries | QDir::Hidden | QDir::System
+                                  | QDir::NoDotAndDotDot).size();
+}
+
+} // namespace
+
+class TestDeleteQueue : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void removesDeepTree();
+    void removesWideTree();
+    void keepsSymlinkTargets();
+    void cancelLeavesTheRest();
+    void batchReportsEachItemOnce();
+
+private:
+    QString path(const QString &name) const { return dir->filePath(name); }
+    // Whether job id is done; its final status is then in `finished`
+    bool isFinished(quint64 id) const { return finished.contains(id); }
+
+    QTemporaryDir *dir = nullptr;
+    QHash<quint64, DeleteStatus> finished;
+    QVector<QPair<QString, bool>> removed;
+};
+
+void TestDeleteQueue::init()
+{
+    dir = new QTemporaryDir;
+    QVERIFY(dir->isValid());
+
+    finished.clear();
+    removed.clear();
+    DeleteQueue *queue = DeleteQueue::instance();
+    connect(queue, &DeleteQueue::jobFinished, this, [this](const DeleteStatus &status) {
+        finished.insert(status.id, status);
+    });
+    connect(queue, &DeleteQueue::itemRemoved, this, [this](const QString &path, bool ok) {
+        removed.append(qMakePair(path, ok));
+    });
+}
+
+void TestDeleteQueue::cleanup()
+{
+    DeleteQueue *queue = DeleteQueue::instance();
+    queue->cancelAll();
+    QTRY_VERIFY_WITH_TIMEOUT(!queue->isBusy(), 30000);
+    disconnect(queue, nullptr, this, nullptr);
+
+    delete dir;
+    dir = nullptr;
+}
+
+void TestDeleteQueue::removesDeepTree()
+{
+    // One file at every level
+    const int depth = 150;
+    const QString root = path("deep");
+    QString folder = root;
+    for (int level = 0; level < depth; ++level) {
+        QVERIFY(QDir().mkpath(folder));
+        QVERIFY(touch(QDir(folder).filePath("file")));
+        folder = QDir(folder).filePath("level");
+    }
+
+    const quint64 id = DeleteQueue::instance()->remove({ root });
+    QVERIFY(id != 0);
+    QTRY_VERIFY_WITH_TIMEOUT(isFinished(id), 30000);
+
+    const DeleteStatus status = finished.value(id);
+    QVERIFY(status.failed.isEmpty());
+    QVERIFY(!status.cancelled);
+    QCOMPARE(status.entriesRemoved, qint64(2 * depth));
+    QVERIFY(!QFileInfo::exists(root));
+}
+
+void TestDeleteQueue::removesWideTree()
+{
+    const QString root = path("wide");
+    const qint64 entries = makeWideTree(root, 40, 60);
+    QVERIFY(entries > 0);
+    // Files next to the subfolders as well
+    for (int i = 0; i < 600; ++i) {
+        QVERIFY(touch(QDir(root).filePath(QStringLiteral("top %1").arg(i))));
+    }
+
+    const quint64 id = DeleteQueue::instance()->remove({ root });
+    QTRY_VERIFY_WITH_TIMEOUT(isFinished(id), 30000);
+
+    const DeleteStatus status = finished.value(id);
+    QVERIFY(status.failed.isEmpty());
+    QCOMPARE(status.entriesRemoved, entries + 600);
+    QVERIFY(!QFileInfo::exists(root));
+}
+
+void TestDeleteQueue::keepsSymlinkTargets()
+{
+#if defined(Q_OS_UNIX)
+    const QString outside = path("outside");
+    QVERIFY(QDir().mkpath(QDir(outside).filePath("inner")));
+    QVERIFY(touch(QDir(outside).filePath("keep.txt")));
+    QVERIFY(touch(QDir(outside).filePath("inner/keep.txt")));
+
+    // A link inside the tree, and a link that is an item of its own
+    const QString root = path("tree");
+    QVERIFY(QDir().mkpath(QDir(root).filePath("sub")));
+    QVERIFY(QFile::link(outside, QDir(root).filePath("sub/link")));
+    QVERIFY(QFile::link(outside, path("top-link")));
+
+    const quint64 id = DeleteQueue::instance()->remove({ root, path("top-link") });
+    QTRY_VERIFY_WITH_TIMEOUT(isFinished(id), 30000);
+
+    QVERIFY(finished.value(id).failed.isEmpty());
+    QVERIFY(!QFileInfo::exists(root));
+    QVERIFY(!QFileInfo(path("top-link")).isSymLink());
+    QVERIFY(QFileInfo::exists(QDir(outside).filePath("keep.txt")));
+    QVERIFY(QFileInfo::exists(QDir(outside).filePath("inner/keep.txt")));
+#else
+    QSKIP("symlinks need privileges here");
+#endif
+}
+
+void TestDeleteQueue::cancelLeavesTheRest()
+{
+    // Background jobs pause every PACE_BATCH entries, which leaves time to
+    // cancel while the tree is still being emptied
+    const int folders = 100;
+    const QString root = path("big");
+    const qint64 entries = makeWideTree(root, folders, 200);
+    QVERIFY(entries > 0);
+    const QString later = path("later.txt");
+    QVERIFY(touch(later));
+
+    DeleteQueue *queue = DeleteQueue::instance();
+    const quint64 id = queue->remove({ root, later }, DeleteQueue::Background);
+    QTRY_VERIFY_WITH_TIMEOUT(entryCount(root) < folders, 30000);
+    queue->cancel(id);
+    QTRY_VERIFY_WITH_TIMEOUT(isFinished(id), 30000);
+
+    const DeleteStatus status = finished.value(id);
+    QVERIFY(status.cancelled);
+    QVERIFY(status.entriesRemoved > 0);
+    QVERIFY(status.entriesRemoved < entries);
+    QVERIFY(QFileInfo::exists(root));
+    QVERIFY(entryCount(root) > 0);
+    // Items after the cancelled one are not touched, but still reported
+    QVERIFY(QFileInfo::exists(later));
+    QCOMPARE(removed, (QVector<QPair<QString, bool>>{ { QFileInfo(root).absoluteFilePath(), false },
+                                                     { QFileInfo(later).absoluteFilePath(), false } }));
+}
+
+void TestDeleteQueue::batchReportsEachItemOnce()
+{
+    QStringList items;
+    items.append(path("a.txt"));
+    QVERIFY(touch(items.last()));
+    items.append(path("empty"));
+    QVERIFY(QDir().mkdir(items.last()));
+    items.append(path("tree"));
+    QVERIFY(makeWideTree(items.last(), 3, 3) > 0);
+    items.append(path("b.txt"));
+    QVERIFY(touch(items.last()));
+
+    // Missing paths are not part of the job
+    QCOMPARE(DeleteQueue::instance()->remove({ path("missing") }), quint64(0));
+    const quint64 id = DeleteQueue::instance()->remove(items + QStringList{ path("missing") });
+    QTRY_VERIFY_WITH_TIMEOUT(isFinished(id), 30000);
+
+    const DeleteStatus status = finished.value(id);
+    QCOMPARE(status.itemCount, items.size());
+    QCOMPARE(status.itemsDone, items.size());
+    QVERIFY(status.failed.isEmpty());
+
+    QVector<QPair<QString, bool>> expected;
+    for (const QString &item : items) {
+        expected.append(qMakePair(QFileInfo(item).absoluteFilePath(), true));
+        QVERIFY(!QFileInfo::exists(item));
+    }
+    QCOMPARE(removed, expected);
+}
+
+QTEST_GUILESS_MAIN(TestDeleteQueue)
+#include "tst_deletequeue.moc"
@@ -0,0 +1,207 @@
+#include <QSignalSpy>
+#include <QtTest>
+#include <utility>
+#include "features/filemodel/filemodel.h"
+
+namespace {
+
+FileEntry entry(const QString &name, bool isDir = false, qint64 size = 0)
+{
+    FileEntry e;
+    e.name = name;
+    e.path = QStringLiteral("/zone/") + name;
+    e.isDir = isDir;
+    e.size = size;
+    e.mtime = 1000;
+    return e;
+}
+
+QStringList names(const ZoneFileModel &model)
+{
+    QStringList result;
+    for (int row = 0; row < model.rowCount(); ++row) {
+        result.append(model.index(row).data().toString());
+    }
+    return result;
+}
+
+// (first, last) of each range a rows* / dataChanged signal reported
+QVector<QPair<int, int>> ranges(QSignalSpy &spy, int firstArg)
+{
+    QVector<QPair<int, int>> result;
+    for (const QList<QVariant> &args : std::as_const(spy)) {
+        if (firstArg == 0) {
+            result.append(qMakePair(args.at(0).toModelIndex().row(), args.at(1).toModelIndex().row()));
+        } else {
+            result.append(qMakePair(args.at(1).toInt(), args.at(2).toInt()));
+        }
+    }
+    return result;
+}
+
+} // namespace
+
+class TestFileModel : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void sortsFoldersFirstThenByName();
+    void setEntriesEmitsMinimalChanges();
+    void setEntriesWithSameListingIsSilent();
+    void applyDeltaInsertsUpdatesAndRemoves();
+    void applyDeltaReplacesFileByFolder();
+    void applyDeltaRefusedWhileUnsorted();
+    void exposesRowsInBatches();
+    void pendingEntriesSurviveListings();
+};
+
+void TestFileModel::initTestCase()
+{
+    // Roles argument of dataChanged, for QSignalSpy
+    qRegisterMetaType<QVector<int>>();
+}
+
+void TestFileModel::sortsFoldersFirstThenByName()
+{
+    ZoneFileModel model;
+    model.setEntries({ entry("b.txt"), entry("z", true), entry("a.txt"), entry("c", true) });
+
+    QCOMPARE(names(model), QStringList({ "c", "z", "a.txt", "b.txt" }));
+}
+
+void TestFileModel::setEntriesEmitsMinimalChanges()
+{
+    ZoneFileModel model;
+    model.setEntries({ entry("a"), entry("b"), entry("c") });
+
+    QSignalSpy inserted(&model, &QAbstractItemModel::rowsInserted);
+    QSignalSpy removed(&model, &QAbstractItemModel::rowsRemoved);
+    QSignalSpy changed(&model, &QAbstractItemModel::dataChanged);
+    QSignalSpy reset(&model, &QAbstractItemModel::modelReset);
+
+    // b vanished, c changed size, d is new
+    model.setEntries({ entry("d"), entry("c", false, 42), entry("a") });
+
+    QCOMPARE(names(model), QStringList({ "a", "c", "d" }));
+    QCOMPARE(ranges(removed, 1), (QVector<QPair<int, int>>{ { 1, 1 } }));
+    QCOMPARE(ranges(inserted, 1), (QVector<QPair<int, int>>{ { 2, 2 } }));
+    QCOMPARE(ranges(changed, 0), (QVector<QPair<int, int>>{ { 1, 1 } }));
+    QCOMPARE(reset.count(), 0);
+}
+
+void TestFileModel::setEntriesWithSameListingIsSilent()
+{
+    ZoneFileModel model;
+    const QVector<FileEntry> listing{ entry("a"), entry("b", true), entry("c") };
+    model.setEntries(listing);
+
+    QSignalSpy inserted(&model, &QAbstractItemModel::rowsInserted);
+    QSignalSpy removed(&model, &QAbstractItemModel::rowsRemoved);
+    QSignalSpy changed(&model, &QAbstractItemModel::dataChanged);
+    QSignalSpy listingChanged(&model, &ZoneFileModel::entriesChanged);
+
+    model.setEntries(listing);
+
+    QCOMPARE(inserted.count(), 0);
+    QCOMPARE(removed.count(), 0);
+    QCOMPARE(changed.count(), 0);
+    QCOMPARE(listingChanged.count(), 1);
+}
+
+void TestFileModel::applyDeltaInsertsUpdatesAndRemoves()
+{
+    ZoneFileModel model;
+    model.setEntries({ entry("a"), entry("c") });
+
+    QSignalSpy inserted(&model, &QAbstractItemModel::rowsInserted);
+    QSignalSpy removed(&model, &QAbstractItemModel::rowsRemoved);
+    QSignalSpy changed(&model, &QAbstractItemModel::dataChanged);
+
+    QVERIFY(model.applyDelta({ entry("b") }, QStringList()));
+    QCOMPARE(names(model), QStringList({ "a", "b", "c" }));
+    QCOMPARE(ranges(inserted, 1), (QVector<QPair<int, int>>{ { 1, 1 } }));
+
+    // Unchanged size and mtime: nothing to repaint
+    QVERIFY(model.applyDelta({ entry("a") }, QStringList()));
+    QCOMPARE(changed.count(), 0);
+
+    QVERIFY(model.applyDelta({ entry("a", false, 7) }, QStringList()));
+    QCOMPARE(ranges(changed, 0), (QVector<QPair<int, int>>{ { 0, 0 } }));
+
+    QVERIFY(model.applyDelta(QVector<FileEntry>(), { "c", "missing" }));
+    QCOMPARE(names(model), QStringList({ "a", "b" }));
+    QCOMPARE(ranges(removed, 1), (QVector<QPair<int, int>>{ { 2, 2 } }));
+    QVERIFY(!model.contains(QStringLiteral("/zone/c")));
+}
+
+void TestFileModel::applyDeltaReplacesFileByFolder()
+{
+    ZoneFileModel model;
+    model.setEntries({ entry("a"), entry("b") });
+
+    QVERIFY(model.applyDelta({ entry("b", true) }, QStringList()));
+
+    QCOMPARE(names(model), QStringList({ "b", "a" }));
+    QCOMPARE(model.entryCount(), 2);
+}
+
+void TestFileModel::applyDeltaRefusedWhileUnsorted()
+{
+    ZoneFileModel model;
+    model.appendEntries({ entry("b"), entry("a") });
+
+    QVERIFY(!model.applyDelta({ entry("c") }, QStringList()));
+    QCOMPARE(model.entryCount(), 2);
+
+    // The final listing puts the rows in order, after which deltas apply
+    model.setEntries({ entry("b"), entry("a") });
+    QCOMPARE(names(model), QStringList({ "a", "b" }));
+    QVERIFY(model.applyDelta({ entry("c") }, QStringList()));
+    QCOMPARE(names(model), QStringList({ "a", "b", "c" }));
+}
+
+void TestFileModel::exposesRowsInBatches()
+{
+    ZoneFileModel model;
+    const int total = ZoneFileModel::FETCH_BATCH + 10;
+    QVector<FileEntry> listing;
+    for (int i = 0; i < total; ++i) {
+        listing.append(entry(QStringLiteral("f%1").arg(i, 5, 10, QLatin1Char('0'))));
+    }
+    model.setEntries(listing);
+
+    QCOMPARE(model.rowCount(), ZoneFileModel::FETCH_BATCH);
+    QCOMPARE(model.entryCount(), total);
+    QVERIFY(model.contains(listing.last().path));
+    QVERIFY(model.canFetchMore(QModelIndex()));
+
+    model.fetchMore(QModelIndex());
+    QCOMPARE(model.rowCount(), total);
+    QVERIFY(!model.canFetchMore(QModelIndex()));
+}
+
+void TestFileModel::pendingEntriesSurviveListings()
+{
+    ZoneFileModel model;
+    model.setEntries({ entry("a") });
+
+    const FileEntry moving = entry("b");
+    model.setPending(moving);
+    QCOMPARE(names(model), QStringList({ "a", "b" }));
+    QVERIFY(model.index(1).data(ZoneFileModel::PendingRole).toBool());
+
+    // Not on disk yet: neither a listing nor a delta removes it
+    model.setEntries({ entry("a") });
+    QVERIFY(model.applyDelta(QVector<FileEntry>(), { "b" }));
+    QVERIFY(model.contains(moving.path));
+
+    model.clearPending(moving.path);
+    QVERIFY(!model.index(1).data(ZoneFileModel::PendingRole).toBool());
+    model.setEntries({ entry("a") });
+    QVERIFY(!model.contains(moving.path));
+}
+
+QTEST_MAIN(TestFileModel)
+#include "tst_filemodel.moc"
@@ -0,0 +1,216 @@
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryDir>
+#include <QtTest>
+#include "features/layout/layoutjournal.h"
+
+namespace {
+
+LayoutRecord put(const QString &folder, const QRect &geometry, bool grid = false)
+{
+    LayoutRecord record;
+    record.folderPath = folder;
+    record.layout.geometry = geometry;
+    record.layout.hasViewMode = true;
+    record.layout.gridMode = grid;
+    return record;
+}
+
+LayoutRecord removal(const QString &folder)
+{
+    LayoutRecord record;
+    record.folderPath = folder;
+    record.removed = true;
+    return record;
+}
+
+bool truncateFile(const QString &filePath, qint64 size)
+{
+    QFile file(filePath);
+    return file.open(QIODevice::ReadWrite) && file.resize(size);
+}
+
+} // namespace
+
+class TestLayoutJournal : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void emptyLoadsNothing();
+    void roundTrip();
+    void tornTailIsCutOff();
+    void damagedRecordEndsReplay();
+    void staleJournalIsIgnored();
+    void compactionKeepsState();
+
+private:
+    QString basePath() const { return dir->filePath(QStringLiteral(".layout")); }
+
+    QTemporaryDir *dir = nullptr;
+};
+
+void TestLayoutJournal::init()
+{
+    dir = new QTemporaryDir;
+    QVERIFY(dir->isValid());
+}
+
+void TestLayoutJournal::cleanup()
+{
+    delete dir;
+    dir = nullptr;
+}
+
+void TestLayoutJournal::emptyLoadsNothing()
+{
+    LayoutJournal journal(basePath());
+    QVERIFY(!journal.load());
+    QVERIFY(journal.layouts().isEmpty());
+}
+
+void TestLayoutJournal::roundTrip()
+{
+    {
+        LayoutJournal journal(basePath());
+        journal.load();
+        QVERIFY(journal.append({ put("/a", QRect(1, 2, 300, 400)), put("/b", QRect(5, 6, 70, 80), true) }));
+        QVERIFY(journal.append({ put("/a", QRect(10, 20, 300, 400)) }));
+        QVERIFY(journal.append({ removal("/b"), put("/c", QRect()) }));
+    }
+
+    LayoutJournal reloaded(basePath());
+    QVERIFY(reloaded.load());
+    QCOMPARE(reloaded.layouts().size(), 2);
+    QCOMPARE(reloaded.layouts().value("/a"), put("/a", QRect(10, 20, 300, 400)).layout);
+    QCOMPARE(reloaded.layouts().value("/c"), put("/c", QRect()).layout);
+    QVERIFY(!reloaded.layouts().contains("/b"));
+}
+
+void TestLayoutJournal::tornTailIsCutOff()
+{
+    qint64 durableSize = 0;
+    qint64 fullSize = 0;
+    {
+        LayoutJournal journal(basePath());
+        journal.load();
+        QVERIFY(journal.append({ put("/a", QRect(0, 0, 100, 100)) }));   // first save: snapshot
+        QVERIFY(journal.append({ put("/b", QRect(0, 0, 200, 200)) }));
+        durableSize = journal.journalSize();
+        QVERIFY(journal.append({ put("/a", QRect(9, 9, 100, 100)), put("/c", QRect(0, 0, 1, 1)) }));
+        fullSize = journal.journalSize();
+    }
+
+    // A crash in the middle of the last write: only part of it reached the disk
+    QVERIFY(truncateFile(basePath() + ".journal", fullSize - 3));
+
+    LayoutJournal recovered(basePath());
+    QVERIFY(recovered.load());
+    QCOMPARE(recovered.layouts().value("/a").geometry, QRect(9, 9, 100, 100));
+    QVERIFY(!recovered.layouts().contains("/c"));
+    QVERIFY(recovered.layouts().contains("/b"));
+    QVERIFY(recovered.journalSize() > durableSize);
+    QCOMPARE(QFileInfo(basePath() + ".journal").size(), recovered.journalSize());
+
+    // New records follow the last good one and survive the next load
+    QVERIFY(recovered.append({ put("/d", QRect(0, 0, 4, 4)) }));
+
+    LayoutJournal reloaded(basePath());
+    QVERIFY(reloaded.load());
+    QVERIFY(reloaded.layouts().contains("/b"));
+    QVERIFY(reloaded.layouts().contains("/d"));
+    QVERIFY(!reloaded.layouts().contains("/c"));
+}
+
+void TestLayoutJournal::damagedRecordEndsReplay()
+{
+    qint64 durableSize = 0;
+    {
+        LayoutJournal journal(basePath());
+        journal.load();
+        QVERIFY(journal.append({ put("/a", QRect(0, 0, 100, 100)) }));
+        QVERIFY(journal.append({ put("/b", QRect(0, 0, 200, 200)) }));
+        durableSize = journal.journalSize();
+        QVERIFY(journal.append({ put("/c", QRect(0, 0, 300, 300)) }));
+        QVERIFY(journal.append({ put("/d", QRect(0, 0, 400, 400)) }));
+    }
+
+    // Flip a byte in the payload of the "/c" record
+    QFile file(basePath() + ".journal");
+    QVERIFY(file.open(QIODevice::ReadWrite));
+    QVERIFY(file.seek(durableSize + 12));
+    char byte = 0;
+    QVERIFY(file.getChar(&byte));
+    QVERIFY(file.seek(durableSize + 12));
+    QVERIFY(file.putChar(char(byte ^ 0x40)));
+    file.close();
+
+    LayoutJournal recovered(basePath());
+    QVERIFY(recovered.load());
+    QVERIFY(recovered.layouts().contains("/a"));
+    QVERIFY(recovered.layouts().contains("/b"));
+    QVERIFY(!recovered.layouts().contains("/c"));
+    QVERIFY(!recovered.layouts().contains("/d"));
+    QCOMPARE(recovered.journalSize(), durableSize);
+}
+
+void TestLayoutJournal::staleJournalIsIgnored()
+{
+    const QString journalPath = basePath() + ".journal";
+    const QString stalePath = basePath() + ".stale";
+    {
+        LayoutJournal journal(basePath());
+        journal.load();
+        QVERIFY(journal.append({ put("/a", QRect(0, 0, 100, 100)) }));
+        QVERIFY(journal.append({ put("/b", QRect(0, 0, 200, 200)) }));
+        QVERIFY(QFile::copy(journalPath, stalePath));
+        QVERIFY(journal.append({ removal("/b") }));
+        QVERIFY(journal.compact());
+    }
+
+    // A journal of the previous generation (as left by a crash between
+    // writing the new snapshot and resetting the journal) is already part of
+    // the snapshot; replaying it would bring "/b" back
+    QVERIFY(QFile::remove(journalPath));
+    QVERIFY(QFile::rename(stalePath, journalPath));
+
+    LayoutJournal recovered(basePath());
+    QVERIFY(recovered.load());
+    QCOMPARE(recovered.layouts().size(), 1);
+    QVERIFY(recovered.layouts().contains("/a"));
+}
+
+void TestLayoutJournal::compactionKeepsState()
+{
+    QHash<QString, ZoneLayout> expected;
+    {
+        LayoutJournal journal(basePath());
+        journal.load();
+        // Enough records to outgrow COMPACT_MIN_BYTES, 20 per save
+        for (int save = 0; save < 200; ++save) {
+            QVector<LayoutRecord> records;
+            for (int i = save * 20; i < (save + 1) * 20; ++i) {
+                records.append(put(QStringLiteral("/zone %1").arg(i % 50), QRect(i, i, 100, 100), i % 2));
+                expected.insert(records.last().folderPath, records.last().layout);
+            }
+            QVERIFY(journal.append(records));
+            if (journal.needsCompaction()) {
+                QVERIFY(journal.compact());
+                QCOMPARE(journal.journalSize(), qint64(16));
+            }
+        }
+        QVERIFY(journal.snapshotSize() > 0);
+        QVERIFY(journal.journalSize() < LayoutJournal::COMPACT_MIN_BYTES);
+        QCOMPARE(journal.layouts(), expected);
+    }
+
+    LayoutJournal reloaded(basePath());
+    QVERIFY(reloaded.load());
+    QCOMPARE(reloaded.layouts(), expected);
+}
+
+QTEST_GUILESS_MAIN(TestLayoutJournal)
+#include "tst_layoutjournal.moc"
@@ -0,0 +1,164 @@
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QtTest>
+#include "features/names/nameindex.h"
+
+namespace {
+
+bool touch(const QString &filePath, const QByteArray &content = QByteArray())
+{
+    QFile file(filePath);
+    return file.open(QIODevice::WriteOnly) && file.write(content) == content.size();
+}
+
+QByteArray contentOf(const QString &filePath)
+{
+    QFile file(filePath);
+    return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+}
+
+} // namespace
+
+class TestNameIndex : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void freeNameIsKept();
+    void takenNamesGetCounters();
+    void counterFormats_data();
+    void counterFormats();
+    void insertReservesName();
+    void namesTakenBeforeListingAreSeen();
+    void danglingSymlinkIsTaken();
+    void renameNeverReplaces();
+
+private:
+    QString path(const QString &name) const { return dir->filePath(name); }
+
+    QTemporaryDir *dir = nullptr;
+};
+
+void TestNameIndex::init()
+{
+    dir = new QTemporaryDir;
+    QVERIFY(dir->isValid());
+}
+
+void TestNameIndex::cleanup()
+{
+    delete dir;
+    dir = nullptr;
+}
+
+void TestNameIndex::freeNameIsKept()
+{
+    NameIndex index(dir->path());
+    QCOMPARE(index.allocate("report.pdf", false), QStringLiteral("report.pdf"));
+    // Handed out once: the next item of that name must not get it again
+    QVERIFY(index.contains("report.pdf"));
+    QCOMPARE(index.allocate("report.pdf", false), QStringLiteral("report_1.pdf"));
+}
+
+void TestNameIndex::takenNamesGetCounters()
+{
+    QVERIFY(touch(path("report.pdf")));
+    QVERIFY(touch(path("report_1.pdf")));
+    QVERIFY(touch(path("report_3.pdf")));
+
+    NameIndex index(dir->path());
+    QCOMPARE(index.allocate("report.pdf", false), QStringLiteral("report_2.pdf"));
+    QCOMPARE(index.allocate("report.pdf", false), QStringLiteral("report_4.pdf"));
+    QCOMPARE(index.allocate("report.pdf", false), QStringLiteral("report_5.pdf"));
+    // Other names are unaffected
+    QCOMPARE(index.allocate("notes.txt", false), QStringLiteral("notes.txt"));
+}
+
+void TestNameIndex::counterFormats_data()
+{
+    QTest::addColumn<QString>("name");
+    QTest::addColumn<bool>("isDir");
+    QTest::addColumn<QString>("expected");
+
+    QTest::newRow("file") << "a.txt" << false << "a_1.txt";
+    QTest::newRow("no suffix") << "README" << false << "README_1";
+    QTest::newRow("folder") << "photos" << true << "photos_1";
+    QTest::newRow("double suffix") << "backup.tar.gz" << false << "backup.tar_1.gz";
+    QTest::newRow("placeholder") << "100%1.txt" << false << "100%1_1.txt";
+}
+
+void TestNameIndex::counterFormats()
+{
+    QFETCH(QString, name);
+    QFETCH(bool, isDir);
+    QFETCH(QString, expected);
+
+    if (isDir) {
+        QVERIFY(QDir(dir->path()).mkdir(name));
+    } else {
+        QVERIFY(touch(path(name)));
+    }
+
+    NameIndex index(dir->path());
+    QCOMPARE(index.allocate(name, isDir), expected);
+}
+
+void TestNameIndex::insertReservesName()
+{
+    NameIndex index(dir->path());
+    index.insert("a.txt");
+    index.insert("a_1.txt");
+    QCOMPARE(index.allocate("a.txt", false), QStringLiteral("a_2.txt"));
+}
+
+void TestNameIndex::namesTakenBeforeListingAreSeen()
+{
+    NameIndex index(dir->path());
+    QCOMPARE(index.allocate("first.txt", false), QStringLiteral("first.txt"));
+
+    // Not listed yet, so each name is checked on disk when asked for
+    QVERIFY(touch(path("late.txt")));
+    QVERIFY(touch(path("late_1.txt")));
+    QCOMPARE(index.allocate("late.txt", false), QStringLiteral("late_2.txt"));
+    QVERIFY(index.contains("first.txt"));
+}
+
+void TestNameIndex::danglingSymlinkIsTaken()
+{
+#if defined(Q_OS_UNIX)
+    QVERIFY(QFile::link(path("missing-target"), path("link.txt")));
+
+    NameIndex index(dir->path());
+    QCOMPARE(index.allocate("link.txt", false), QStringLiteral("link_1.txt"));
+#else
+    QSKIP("symlinks need privileges here");
+#endif
+}
+
+void TestNameIndex::renameNeverReplaces()
+{
+    QVERIFY(touch(path("source.txt"), "source"));
+    QVERIFY(touch(path("target.txt"), "target"));
+
+    QCOMPARE(NameIndex::renameNoReplace(path("source.txt"), path("target.txt")),
+             NameIndex::TargetExists);
+    QCOMPARE(contentOf(path("source.txt")), QByteArray("source"));
+    QCOMPARE(contentOf(path("target.txt")), QByteArray("target"));
+
+    QVERIFY(QDir(dir->path()).mkdir("folder"));
+    QCOMPARE(NameIndex::renameNoReplace(path("source.txt"), path("folder")),
+             NameIndex::TargetExists);
+    QVERIFY(QFile::exists(path("source.txt")));
+
+    QCOMPARE(NameIndex::renameNoReplace(path("source.txt"), path("free.txt")),
+             NameIndex::Renamed);
+    QVERIFY(!QFile::exists(path("source.txt")));
+    QCOMPARE(contentOf(path("free.txt")), QByteArray("source"));
+}
+
+QTEST_GUILESS_MAIN(TestNameIndex)
+#include "tst_nameindex.moc"
@@ -0,0 +1,208 @@
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QtTest>
+#include "features/registry/zoneregistry.h"
+
+namespace {
+
+FileEntry folderEntry(const QString &path, bool isDir = true)
+{
+    FileEntry entry;
+    entry.name = QFileInfo(path).fileName();
+    entry.path = path;
+    entry.isDir = isDir;
+    return entry;
+}
+
+QStringList paths(const QVector<FileEntry> &entries)
+{
+    QStringList result;
+    for (const FileEntry &entry : entries) {
+        result.append(entry.path);
+    }
+    return result;
+}
+
+} // namespace
+
+class TestZoneRegistry : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+    void cleanup();
+
+    void listingAddsNewFolders();
+    void listingRemovesMissingFolders();
+    void listingPairsRenameByIdentity();
+    void deltaAddsAndRemoves();
+    void deltaFolderReplacedByFile();
+    void deltaRenameInOneBurst();
+    void retargetRekeysZone();
+
+private:
+    // Absolute path of a new folder in the temporary root
+    QString makeFolder(const QString &name);
+    QString path(const QString &name) const { return dir->filePath(name); }
+
+    QTemporaryDir *dir = nullptr;
+};
+
+void TestZoneRegistry::init()
+{
+    dir = new QTemporaryDir;
+    QVERIFY(dir->isValid());
+}
+
+void TestZoneRegistry::cleanup()
+{
+    delete dir;
+    dir = nullptr;
+}
+
+QString TestZoneRegistry::makeFolder(const QString &name)
+{
+    QDir(dir->path()).mkdir(name);
+    return path(name);
+}
+
+void TestZoneRegistry::listingAddsNewFolders()
+{
+    ZoneRegistry registry;
+    registry.insert(makeFolder("a"));
+    const QString b = makeFolder("b");
+
+    // Files in the root are not zones
+    const ZoneChanges changes = registry.diffListing({ folderEntry(path("a")), folderEntry(b),
+                                                       folderEntry(path("notes.txt"), false) });
+
+    QCOMPARE(paths(changes.added), QStringList({ b }));
+    QVERIFY(changes.removed.isEmpty());
+    QVERIFY(changes.renamed.isEmpty());
+
+    // A listing that matches the registry changes nothing
+    QVERIFY(registry.diffListing({ folderEntry(path("a")) }).isEmpty());
+}
+
+void TestZoneRegistry::listingRemovesMissingFolders()
+{
+    ZoneRegistry registry;
+    registry.insert(makeFolder("a"));
+    ZoneDescriptor *b = registry.insert(makeFolder("b"));
+    QVERIFY(QDir(path("b")).removeRecursively());
+
+    const ZoneChanges changes = registry.diffListing({ folderEntry(path("a")) });
+
+    QVERIFY(changes.added.isEmpty());
+    QCOMPARE(changes.removed, QList<ZoneDescriptor*>({ b }));
+    QVERIFY(changes.renamed.isEmpty());
+}
+
+void TestZoneRegistry::listingPairsRenameByIdentity()
+{
+    ZoneRegistry registry;
+    ZoneDescriptor *a = registry.insert(makeFolder("a"));
+    if (a->id.isNull()) {
+        QSKIP("folder identities cannot be read on this platform");
+    }
+    registry.insert(makeFolder("b"));
+    QVERIFY(QDir(dir->path()).rename("a", "renamed"));
+    const QString fresh = makeFolder("fresh");
+
+    const ZoneChanges changes = registry.diffListing({ folderEntry(path("b")),
+                                                       folderEntry(path("renamed")),
+                                                       folderEntry(fresh) });
+
+    QCOMPARE(changes.renamed.size(), 1);
+    QCOMPARE(changes.renamed.first().first, a);
+    QCOMPARE(changes.renamed.first().second, path("renamed"));
+    // Neither end of the rename shows up as a removal or an addition
+    QCOMPARE(paths(changes.added), QStringList({ fresh }));
+    QVERIFY(changes.removed.isEmpty());
+}
+
+void TestZoneRegistry::deltaAddsAndRemoves()
+{
+    ZoneRegistry registry;
+    registry.insert(makeFolder("a"));
+    ZoneDescriptor *b = registry.insert(makeFolder("b"));
+    QVERIFY(QDir(path("b")).removeRecursively());
+    const QString c = makeFolder("c");
+
+    // Names the watcher reported: c appeared, b and an unknown name are gone,
+    // a is unchanged
+    const ZoneChanges changes = registry.diffDelta({ folderEntry(path("a")), folderEntry(c) },
+                                                   { path("b"), path("unknown") });
+
+    QCOMPARE(paths(changes.added), QStringList({ c }));
+    QCOMPARE(changes.removed, QList<ZoneDescriptor*>({ b }));
+    QVERIFY(changes.renamed.isEmpty());
+}
+
+void TestZoneRegistry::deltaFolderReplacedByFile()
+{
+    ZoneRegistry registry;
+    ZoneDescriptor *a = registry.insert(makeFolder("a"));
+    QVERIFY(QDir(path("a")).removeRecursively());
+    {
+        QFile file(path("a"));
+        QVERIFY(file.open(QIODevice::WriteOnly));
+    }
+
+    const ZoneChanges changes = registry.diffDelta({ folderEntry(path("a"), false) }, QStringList());
+
+    QVERIFY(changes.added.isEmpty());
+    QCOMPARE(changes.removed, QList<ZoneDescriptor*>({ a }));
+}
+
+void TestZoneRegistry::deltaRenameInOneBurst()
+{
+    ZoneRegistry registry;
+    ZoneDescriptor *a = registry.insert(makeFolder("a"));
+    ZoneDescriptor *b = registry.insert(makeFolder("b"));
+    if (a->id.isNull()) {
+        QSKIP("folder identities cannot be read on this platform");
+    }
+
+    // One coalesced burst reports the old and the new name of each rename,
+    // next to a folder that is really new
+    QVERIFY(QDir(dir->path()).rename("a", "a2"));
+    QVERIFY(QDir(dir->path()).rename("b", "b2"));
+    const QString d = makeFolder("d");
+
+    const ZoneChanges changes = registry.diffDelta(
+        { folderEntry(path("a2")), folderEntry(path("b2")), folderEntry(d) },
+        { path("a"), path("b") });
+
+    QCOMPARE(changes.renamed.size(), 2);
+    QHash<ZoneDescriptor*, QString> targets;
+    for (const auto &rename : changes.renamed) {
+        targets.insert(rename.first, rename.second);
+    }
+    QCOMPARE(targets.value(a), path("a2"));
+    QCOMPARE(targets.value(b), path("b2"));
+    QCOMPARE(paths(changes.added), QStringList({ d }));
+    QVERIFY(changes.removed.isEmpty());
+}
+
+void TestZoneRegistry::retargetRekeysZone()
+{
+    ZoneRegistry registry;
+    ZoneDescriptor *a = registry.insert(makeFolder("a"));
+    registry.insert(makeFolder("b"));
+
+    registry.retarget(a, path("renamed"));
+
+    QCOMPARE(registry.find(path("renamed")), a);
+    QVERIFY(!registry.contains(path("a")));
+    QCOMPARE(registry.indexOf(a), 0);
+    QCOMPARE(registry.size(), 2);
+    // The old name is free for a zone of its own
+    QVERIFY(registry.insert(path("a")) != a);
+    QCOMPARE(registry.size(), 3);
+}
+
+QTEST_GUILESS_MAIN(TestZoneRegistry)
+#include "tst_zoneregistry.moc"